@@ -37,8 +37,10 @@
 #include <pcap.h>
 #include "sixonelib.h"
 
-/// @brief DBG enable/disable debug output (should be an #ifdef really)
+/// @brief DBG enable/disable debug output, build with -DDBG=0 to silence it
+#ifndef DBG
 #define DBG 1
+#endif
 /// @brief DBG_P macro for debug printouts
 #define DBG_P if(DBG) printf
 
@@ -52,12 +54,33 @@ void signalExit() {
 
 void catchSignal(int sig) {
 	printf("Caught signal: %d.\n", sig);
+	if(NULL != global_egress)
+		egress_report(global_egress);
 	signal(SIGINT, signalExit );
 }
 
+/**
+ *  @brief Forgets what was learned from mappings that may have changed
+ */
+static void mappings_changed()
+{
+	if(NULL != global_fastpath)
+		fast_flush(global_fastpath);
+}
+
 /**
  *  @brief Main loop.
  *  When called from command line, first cfg file, then arguments are devices to listen to.
+ *  With --replay <in.pcap> --out <out.pcap> the capture is run through the router offline instead.
+ *  With --fastpath packets of established mappings skip the resolve/route slow path.
+ *  With --policy rtt new flows go to the transit prefix with the lowest measured RTT
+ *  (policy_pick_rtt()), the default is weighted multipath (policy_pick_weighted()).
+ *  With --workers <n> packets are run by n worker threads, both directions of a flow
+ *  by the same one (sixonerss.h).
+ *  With --conntrack <n> up to n legacy flows are tracked (sixonect.h), 0 turns tracking off.
+ *  With --icmp-rate <n> each source /64 gets up to n ICMPv6 errors a second (sixoneicmp.h), 0 sends none.
+ *  With --direct outbound packets are sent as frames on the transit interface, not through
+ *  the tun device and the kernel's routes (sixoneegress.h).
  */
 
 int main( int argc, char *argv[])
@@ -75,6 +98,9 @@ int main( int argc, char *argv[])
 	u_char *pcap_args[2]; 
 	
 	sixone_settings net_settings;
+	char *cfg_file = NULL, *replay_in = NULL, *replay_out = NULL;
+	int fastpath = 0, workers = 0, conntrack = CT_MAX, icmp_rate = ICMP_RATE, direct = 0;
+	char *policy = "weighted";
 	
 	printf("\n");
 	printf(" ____  _       ___                \n");
@@ -93,15 +119,120 @@ int main( int argc, char *argv[])
 	
 	signal(SIGINT, catchSignal);
 	
-	if(argc != 2) {
-		printf("Usage: %s, <config-file>\n", argv[0]);
+	for(i = 1; i < argc; i++) {
+		if(0 == strcmp(argv[i], "--replay") && i + 1 < argc)
+			replay_in = argv[++i];
+		else if(0 == strcmp(argv[i], "--out") && i + 1 < argc)
+			replay_out = argv[++i];
+		else if(0 == strcmp(argv[i], "--fastpath"))
+			fastpath = 1;
+		else if(0 == strcmp(argv[i], "--policy") && i + 1 < argc)
+			policy = argv[++i];
+		else if(0 == strcmp(argv[i], "--workers") && i + 1 < argc)
+			workers = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--conntrack") && i + 1 < argc)
+			conntrack = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--icmp-rate") && i + 1 < argc)
+			icmp_rate = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--direct"))
+			direct = 1;
+		else if(NULL == cfg_file && '-' != argv[i][0])
+			cfg_file = argv[i];
+		else
+			break;
+	}
+
+	if(i != argc || NULL == cfg_file || (NULL == replay_in) != (NULL == replay_out)) {
+		printf("Usage: %s [--fastpath] [--policy weighted|rtt] [--workers <n>] [--conntrack <n>] [--icmp-rate <n>] [--direct] [--replay <in.pcap> --out <out.pcap>] <config-file>\n", argv[0]);
 		return 2;
 	}
 	
 	DBG_P("START...\n");
+
+	// a replay keeps time by the capture, before any thread starts its timers
+	timers_replay = NULL != replay_in;
   
 	net_settings = alloc_sixone_settings();
-	load_settings(argv[1], net_settings);
+	load_settings(cfg_file, net_settings);
+
+	if(NULL != net_settings->plugin
+	   && 0 != load_plugin(net_settings, (char *)net_settings->plugin, (char *)net_settings->plugin_arg))
+		return 1;
+
+	if(NULL != net_settings->resolver) {
+		if(NULL != net_settings->plugin) {
+			printf("Plugin= and Resolver= are exclusive, the daemon can host the plugin\n");
+			return 1;
+		}
+		global_async = alloc_sixone_async((char *)net_settings->resolver, (char *)net_settings->resolver_arg);
+		if(NULL == global_async)
+			return 1;
+		net_settings->resolv->sixone_resolv = async_resolv;
+	}
+
+	if(NULL != net_settings->replicate) {
+		if(NULL != net_settings->plugin || NULL != net_settings->resolver) {
+			printf("Replicate= resolves from the replicated table, it excludes Plugin= and Resolver=\n");
+			return 1;
+		}
+		global_repl = alloc_sixone_repl((char *)net_settings->replicate, (char *)net_settings->replicate_arg);
+		if(NULL == global_repl)
+			return 1;
+		global_repl->on_change = mappings_changed;
+		net_settings->resolv->sixone_resolv = repl_resolv;
+		net_settings->resolv->sixone_resolv_batch = repl_resolv_batch;
+		if(0 != repl_wait(global_repl, REPL_SYNC_MS))
+			printf("Replication: no table from %s yet, unmapped until there is\n", global_repl->addr);
+	}
+
+	if(0 == strcmp(policy, "rtt")) {
+		if(NULL == (global_rtt = alloc_sixone_rtt())) {
+			printf("Out of memory\n");
+			return 1;
+		}
+		net_settings->policy->sixone_policy_dst = policy_pick_rtt;
+	}
+	else if(0 != strcmp(policy, "weighted")) {
+		printf("Unknown policy %s, expected weighted or rtt\n", policy);
+		return 2;
+	}
+
+	if(fastpath && NULL == (global_fastpath = alloc_sixone_fast(net_settings))) {
+		printf("--fastpath needs at least one edge and one transit net\n");
+		return 1;
+	}
+
+	if(0 < conntrack && NULL == (global_ct = alloc_sixone_ct(conntrack))) {
+		printf("Out of memory\n");
+		return 1;
+	}
+
+	if(NULL == (global_pmtu = alloc_sixone_pmtu())) {
+		printf("Out of memory\n");
+		return 1;
+	}
+
+	if(0 < icmp_rate && NULL == (global_icmp = alloc_sixone_icmp(icmp_rate))) {
+		printf("Out of memory\n");
+		return 1;
+	}
+
+	// a replay waits for room in the queues, a live capture drops like a full ring
+	if(0 != workers && NULL == (global_rss = alloc_sixone_rss(workers, NULL != replay_in)))
+		return 1;
+	frag_per_thread = NULL != global_rss;
+
+	if(NULL != replay_in) {
+		// a replay writes the packets to the dump, nothing leaves on an interface
+		if(direct)
+			printf("--direct has no effect on a replay\n");
+		return replay_sixone(net_settings, replay_in, replay_out);
+	}
+
+	if(direct && NULL == (global_egress = alloc_sixone_egress(net_settings))) {
+		printf("Out of memory\n");
+		return 1;
+	}
   
 	start_sixone(net_settings);
   
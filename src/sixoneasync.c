@@ -0,0 +1,593 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneasync.c
+ *  @brief Six-One Router asynchronous mapping resolution with pending queues
+ *  @date 2026-10-19
+ */
+
+#include "sixoneasync.h"
+#include "sixonelib.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+sixone_async global_async;
+
+/// @brief Longest line taken from the daemon
+#define ASYNC_LINE_MAX 8192
+/// @brief How often the reader expires queries and negative answers (ms), the tick of its wheels
+#define ASYNC_TICK_MS 10
+
+/// @brief Cache value of addresses without mappings
+static struct ip_list_ async_none;
+
+static u_int64_t async_now_ms()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static u_int async_bucket(struct in6_addr *addr)
+{
+	u_int32_t w[4];
+
+	memcpy(w, addr, sizeof(w));
+	return ((w[0] ^ w[1] ^ w[2] ^ w[3]) * 0x9E3779B1U) >> 24 & (ASYNC_BUCKETS - 1);
+}
+
+static void free_answer(void *p)
+{
+	ip_list l = p, next;
+
+	if(&async_none == l)
+		return;
+	for(; l != NULL; l = next) {
+		next = l->next;
+		free(l->ip);
+		free(l);
+	}
+}
+
+static void free_pending(async_pending p)
+{
+	async_pkt pk, next;
+
+	for(pk = p->head; pk != NULL; pk = next) {
+		next = pk->next;
+		free(pk);
+	}
+	free(p);
+}
+
+/**
+ *  @brief Connects to the daemon, non-blocking so the packet path never waits on it
+ *  @return The socket, -1 on failure
+ */
+static int async_connect(const char *path)
+{
+	struct sockaddr_un sun;
+	int fd;
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(sun.sun_path))
+		return -1;
+	strcpy(sun.sun_path, path);
+
+	if(-1 == (fd = socket(AF_UNIX, SOCK_STREAM, 0)))
+		return -1;
+	if(0 != connect(fd, (struct sockaddr *)&sun, sizeof(sun))) {
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+/**
+ *  @brief Unlinks every pending address that is covered by pfx/len, call with the lock held
+ *  @return The unlinked entries, chained on next
+ */
+static async_pending pending_take(sixone_async async, struct in6_addr *pfx, u_int len)
+{
+	async_pending ret = NULL, *pp, p;
+	struct in6_addr addr;
+	u_int i;
+
+	for(i = 0; i < ASYNC_BUCKETS; i++) {
+		for(pp = &async->pending[i]; NULL != (p = *pp); ) {
+			addr = p->addr;
+			lpm_mask(&addr, len);
+			if(0 == memcmp(&addr, pfx, sizeof(addr))) {
+				*pp = p->next;
+				wheel_del(async->expiry, &p->timer);
+				p->next = ret;
+				ret = p;
+				async->pending_c--;
+			}
+			else
+				pp = &p->next;
+		}
+	}
+	if(0 == async->pending_c)
+		pthread_cond_broadcast(&async->idle);
+	return ret;
+}
+
+/**
+ * @brief A negative answer to forget
+ */
+typedef struct async_negative_ {
+	struct wheel_timer_ timer;
+	struct in6_addr addr;
+	u_int len;
+	u_int generation;
+} *async_negative;
+
+/**
+ *  @brief Timer callback, uncaches a negative answer (lock held)
+ */
+static void negative_expire(wheel_timer timer, void *arg)
+{
+	sixone_async async = arg;
+	async_negative n = (async_negative)timer;
+
+	// a flush or a positive answer may have replaced it already
+	if(n->generation == async->generation && &async_none == lpm_exact(async->cache, &n->addr, n->len))
+		lpm_remove(async->cache, &n->addr, n->len);
+	free(n);
+}
+
+/**
+ *  @brief Timer callback, frees a negative answer without looking at the cache
+ */
+static void negative_drop(wheel_timer timer, void *arg)
+{
+	free(timer);
+}
+
+/**
+ *  @brief Handles one "A <addr> <len> <prefix>/<len>:<weight> ..." line
+ */
+static void async_answer(sixone_async async, char *line)
+{
+	char *tok, *save, str[INET6_ADDRSTRLEN];
+	struct in6_addr addr;
+	ip_list list = NULL, *curr = &list;
+	async_pending done, p;
+	async_negative neg;
+	async_pkt pk, next;
+	u_int len, plen, weight;
+
+	if('A' != line[0]
+	   || NULL == (tok = strtok_r(line + 1, " \t\r", &save)) || 1 != inet_pton(AF_INET6, tok, &addr)
+	   || NULL == (tok = strtok_r(NULL, " \t\r", &save)) || (len = strtoul(tok, NULL, 10)) > 128)
+		return;
+
+	while(NULL != (tok = strtok_r(NULL, " \t\r", &save))) {
+		weight = SIXONE_WEIGHT_DEFAULT;
+		if(sscanf(tok, "%45[^/]/%u:%u", str, &plen, &weight) < 2 || plen > 128)
+			continue;
+		if(NULL == ((*curr) = alloc_ip_list()) || NULL == ((*curr)->ip = alloc_sixone_ip())) {
+			free(*curr);
+			*curr = NULL;
+			break;
+		}
+		if(1 != inet_pton(AF_INET6, str, &(*curr)->ip->ip)) {
+			free((*curr)->ip);
+			free(*curr);
+			*curr = NULL;
+			continue;
+		}
+		(*curr)->ip->pfx = plen;
+		(*curr)->weight = weight;
+		curr = &(*curr)->next;
+	}
+
+	lpm_mask(&addr, len);
+	pthread_mutex_lock(&async->lock);
+	async->answers++;
+	free_answer(lpm_insert(async->cache, &addr, len, NULL != list ? list : &async_none));
+	if(NULL == list && NULL != (neg = malloc(sizeof(struct async_negative_)))) {
+		neg->addr = addr;
+		neg->len = len;
+		neg->generation = async->generation;
+		wheel_add(async->negative, &neg->timer, async_now_ms() * 1000 + async->negative_ms * 1000ULL);
+	}
+	// the answer covers the whole prefix, so possibly more than the address asked for
+	done = pending_take(async, &addr, len);
+	for(p = done; p != NULL; p = p->next)
+		async->released += p->depth;
+	async->releasing++;
+	pthread_mutex_unlock(&async->lock);
+
+	for(; done != NULL; done = p) {
+		p = done->next;
+		for(pk = done->head; pk != NULL; pk = next) {
+			next = pk->next;
+			// back to the worker of its flow, if there are workers
+			if(NULL != global_rss)
+				rss_dispatch(global_rss, release_packet, pk->args, &pk->hdr, pk->data);
+			else
+				release_packet(pk->args, &pk->hdr, pk->data);
+			free(pk);
+		}
+		free(done);
+	}
+
+	// async_drain() waits for the packets as well
+	pthread_mutex_lock(&async->lock);
+	if(0 == --async->releasing && 0 == async->pending_c)
+		pthread_cond_broadcast(&async->idle);
+	pthread_mutex_unlock(&async->lock);
+}
+
+/**
+ * @brief What pending_expire() collects
+ */
+struct async_expired {
+	sixone_async async;
+	async_pending done;
+};
+
+/**
+ *  @brief Timer callback, unlinks a query that was not answered in time (lock held)
+ */
+static void pending_expire(wheel_timer timer, void *arg)
+{
+	struct async_expired *x = arg;
+	async_pending p = (async_pending)((char *)timer - offsetof(struct async_pending_, timer)), *pp;
+
+	for(pp = &x->async->pending[async_bucket(&p->addr)]; *pp != p; pp = &(*pp)->next)
+		;
+	*pp = p->next;
+	p->next = x->done;
+	x->done = p;
+	x->async->pending_c--;
+	x->async->dropped_timeout += p->depth;
+}
+
+/**
+ *  @brief Drops the queues of queries that were not answered in time, forgets old negative answers
+ */
+static void async_expire(sixone_async async)
+{
+	struct async_expired x = { async, NULL };
+	async_pending done, p;
+	u_int64_t now = async_now_ms() * 1000;
+
+	pthread_mutex_lock(&async->lock);
+	wheel_advance(async->expiry, now, pending_expire, &x);
+	wheel_advance(async->negative, now, negative_expire, async);
+	if(NULL != x.done && 0 == async->pending_c)
+		pthread_cond_broadcast(&async->idle);
+	done = x.done;
+	pthread_mutex_unlock(&async->lock);
+
+	for(; done != NULL; done = p) {
+		p = done->next;
+		free_pending(done);
+	}
+}
+
+/**
+ *  @brief Reader thread, takes the answers, expires queries and reconnects
+ */
+static void *async_reader(void *arg)
+{
+	sixone_async async = arg;
+	struct pollfd pfd;
+	char *buf, *nl, *line;
+	u_int len = 0;
+	ssize_t r;
+	int fd;
+
+	if(NULL == (buf = malloc(ASYNC_LINE_MAX)))
+		return NULL;
+
+	while(!async->stop) {
+		if(-1 == async->fd) {
+			// nothing goes out meanwhile, the parked packets time out
+			fd = async_connect(async->path);
+			pthread_mutex_lock(&async->lock);
+			async->fd = fd;
+			pthread_mutex_unlock(&async->lock);
+			if(-1 == fd)
+				usleep(100000);
+			async_expire(async);
+			continue;
+		}
+
+		pfd.fd = async->fd;
+		pfd.events = POLLIN;
+		if(poll(&pfd, 1, ASYNC_TICK_MS) > 0) {
+			r = read(async->fd, buf + len, ASYNC_LINE_MAX - 1 - len);
+			if(0 == r || (r < 0 && EAGAIN != errno && EINTR != errno)) {
+				fprintf(stderr, "Resolver %s: connection lost\n", async->path);
+				pthread_mutex_lock(&async->lock);
+				close(async->fd);
+				async->fd = -1;
+				pthread_mutex_unlock(&async->lock);
+				len = 0;
+				continue;
+			}
+			if(r > 0) {
+				len += r;
+				buf[len] = 0;
+				for(line = buf; NULL != (nl = strchr(line, '\n')); line = nl + 1) {
+					*nl = 0;
+					async_answer(async, line);
+				}
+				len -= line - buf;
+				memmove(buf, line, len);
+				// a line that doesn't fit is garbage
+				if(ASYNC_LINE_MAX - 1 == len)
+					len = 0;
+			}
+		}
+		async_expire(async);
+		// packets it released without workers may have armed timers here
+		timers_burst();
+	}
+	free(buf);
+	return NULL;
+}
+
+sixone_async alloc_sixone_async(const char *path, const char *arg)
+{
+	sixone_async async;
+	char opt[64], val[64];
+	int n;
+
+	if(NULL == (async = (sixone_async) calloc(1, sizeof(struct sixone_async_))))
+		return NULL;
+	async->timeout_ms = ASYNC_TIMEOUT_MS;
+	async->negative_ms = ASYNC_NEGATIVE_MS;
+	async->depth = ASYNC_DEPTH;
+	async->drop = ASYNC_DROP_HEAD;
+
+	for(; NULL != arg && 2 == sscanf(arg, " %63[^= ]=%63s%n", opt, val, &n); arg += n) {
+		if(0 == strcmp(opt, "timeout"))
+			async->timeout_ms = atoi(val);
+		else if(0 == strcmp(opt, "negative"))
+			async->negative_ms = atoi(val);
+		else if(0 == strcmp(opt, "depth"))
+			async->depth = atoi(val);
+		else if(0 == strcmp(opt, "drop") && (0 == strcmp(val, "head") || 0 == strcmp(val, "tail")))
+			async->drop = 0 == strcmp(val, "tail") ? ASYNC_DROP_TAIL : ASYNC_DROP_HEAD;
+		else {
+			fprintf(stderr, "Resolver %s: unknown option %s=%s\n", path, opt, val);
+			free(async);
+			return NULL;
+		}
+	}
+	if(0 == async->timeout_ms || 0 == async->depth) {
+		fprintf(stderr, "Resolver %s: timeout and depth must be positive\n", path);
+		free(async);
+		return NULL;
+	}
+
+	if(-1 == (async->fd = async_connect(path))) {
+		fprintf(stderr, "Resolver %s: cannot connect: %s\n", path, strerror(errno));
+		free(async);
+		return NULL;
+	}
+	async->path = strdup(path);
+	async->cache = alloc_sixone_lpm();
+	async->expiry = alloc_sixone_wheel(ASYNC_TICK_MS * 1000, async_now_ms() * 1000);
+	async->negative = alloc_sixone_wheel(ASYNC_TICK_MS * 1000, async_now_ms() * 1000);
+	pthread_mutex_init(&async->lock, NULL);
+	pthread_cond_init(&async->idle, NULL);
+	if(NULL == async->path || NULL == async->cache || NULL == async->expiry || NULL == async->negative
+	   || 0 != pthread_create(&async->reader, NULL, async_reader, async)) {
+		fprintf(stderr, "Resolver %s: out of resources\n", path);
+		close(async->fd);
+		free_sixone_wheel(async->expiry);
+		free_sixone_wheel(async->negative);
+		free_sixone_lpm(async->cache, NULL);
+		free(async->path);
+		free(async);
+		return NULL;
+	}
+	return async;
+}
+
+void free_sixone_async(sixone_async async)
+{
+	async_pending p, next;
+	u_int i;
+
+	if(NULL == async)
+		return;
+	async->stop = 1;
+	pthread_join(async->reader, NULL);
+
+	for(i = 0; i < ASYNC_BUCKETS; i++) {
+		for(p = async->pending[i]; p != NULL; p = next) {
+			next = p->next;
+			free_pending(p);
+		}
+	}
+	// the negative answers are only held by their timers
+	wheel_advance(async->negative, ~0ULL, negative_drop, NULL);
+	free_sixone_wheel(async->negative);
+	free_sixone_wheel(async->expiry);
+	free_sixone_lpm(async->cache, free_answer);
+	if(-1 != async->fd)
+		close(async->fd);
+	pthread_cond_destroy(&async->idle);
+	pthread_mutex_destroy(&async->lock);
+	free(async->path);
+	free(async);
+}
+
+int async_park(sixone_async async, sixone_pkt pkt, const struct pcap_pkthdr *header, u_char *args)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct in6_addr *addr;
+	async_pending p;
+	async_pkt pk;
+	char query[INET6_ADDRSTRLEN + 4];
+	u_int i;
+
+	// the same addresses inbound()/outbound() resolve
+	if(is_inbound(ip)) {
+		if(!bilateral_bit(ip))
+			return 0;
+		addr = &ip->ip6_src;
+	}
+	else if(is_outbound(ip))
+		addr = &ip->ip6_dst;
+	else
+		return 0;
+
+	pthread_mutex_lock(&async->lock);
+	if(NULL != lpm_lookup(async->cache, addr, NULL)) {
+		pthread_mutex_unlock(&async->lock);
+		return 0;
+	}
+
+	i = async_bucket(addr);
+	for(p = async->pending[i]; p != NULL && 0 != memcmp(&p->addr, addr, sizeof(*addr)); p = p->next)
+		;
+	if(NULL == p) {
+		if(async->pending_c >= ASYNC_MAX_PENDING || NULL == (p = calloc(1, sizeof(struct async_pending_)))) {
+			async->dropped_full++;
+			pthread_mutex_unlock(&async->lock);
+			return 1;
+		}
+		p->addr = *addr;
+		wheel_add(async->expiry, &p->timer, (async_now_ms() + async->timeout_ms) * 1000);
+		p->next = async->pending[i];
+		async->pending[i] = p;
+		async->pending_c++;
+
+		// a query that doesn't go out now times out and the next packet asks again
+		strcpy(query, "Q ");
+		inet_ntop(AF_INET6, addr, query + 2, INET6_ADDRSTRLEN);
+		strcat(query, "\n");
+		if(-1 != async->fd && (ssize_t)strlen(query) == write(async->fd, query, strlen(query)))
+			async->queries++;
+	}
+
+	if(p->depth >= async->depth) {
+		async->dropped_full++;
+		if(ASYNC_DROP_TAIL == async->drop) {
+			pthread_mutex_unlock(&async->lock);
+			return 1;
+		}
+		pk = p->head;
+		p->head = pk->next;
+		if(NULL == p->head)
+			p->tail = NULL;
+		p->depth--;
+		free(pk);
+	}
+
+	if(NULL == (pk = malloc(sizeof(struct async_pkt_) + header->caplen))) {
+		async->dropped_full++;
+		pthread_mutex_unlock(&async->lock);
+		return 1;
+	}
+	pk->next = NULL;
+	pk->args = args;
+	pk->hdr = *header;
+	memcpy(pk->data, pkt->data, header->caplen);
+	if(NULL == p->tail)
+		p->head = pk;
+	else
+		p->tail->next = pk;
+	p->tail = pk;
+	p->depth++;
+	async->parked++;
+
+	pthread_mutex_unlock(&async->lock);
+	return 1;
+}
+
+ip_list async_resolv(sixone_ip ip, u_int only_sixone)
+{
+	sixone_async async = global_async;
+	ip_list l, ret = NULL, *curr = &ret;
+
+	pthread_mutex_lock(&async->lock);
+	l = lpm_lookup(async->cache, &ip->ip, NULL);
+	// the callers own what they get, as with the other resolvers
+	for(; NULL != l && &async_none != l; l = l->next) {
+		if(NULL == ((*curr) = alloc_ip_list()) || NULL == ((*curr)->ip = alloc_sixone_ip()))
+			break;
+		*(*curr)->ip = *l->ip;
+		(*curr)->weight = l->weight;
+		curr = &(*curr)->next;
+	}
+	pthread_mutex_unlock(&async->lock);
+	return ret;
+}
+
+void async_flush(sixone_async async)
+{
+	pthread_mutex_lock(&async->lock);
+	lpm_flush(async->cache, free_answer);
+	async->generation++;
+	pthread_mutex_unlock(&async->lock);
+}
+
+void async_drain(sixone_async async)
+{
+	struct timespec until;
+
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += async->timeout_ms / 1000 + 1;
+
+	pthread_mutex_lock(&async->lock);
+	while((async->pending_c > 0 || async->releasing > 0) && ETIMEDOUT != pthread_cond_timedwait(&async->idle, &async->lock, &until))
+		;
+	pthread_mutex_unlock(&async->lock);
+}
+
+void async_report(sixone_async async)
+{
+	pthread_mutex_lock(&async->lock);
+	printf("  resolver: %u queries, %u answers, %u mappings cached, %u packets parked, %u released, %u dropped (queue full), %u dropped (timeout)\n",
+	       async->queries, async->answers, lpm_count(async->cache), async->parked, async->released,
+	       async->dropped_full, async->dropped_timeout);
+	pthread_mutex_unlock(&async->lock);
+}
@@ -0,0 +1,181 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneasync.h
+ *  @brief Six-One Router asynchronous mapping resolution with pending queues
+ *  @date 2026-10-19
+ *
+ *  The configuration names a resolver daemon (e.g. sixoneresolvd) on a
+ *  Unix socket:
+ *  @code
+ *  Resolver= /var/run/sixoneresolvd.sock [timeout=<ms>] [depth=<n>] [drop=head|tail] [negative=<ms>]
+ *  @endcode
+ *  The first packet to (or, bilateral inbound, from) an address without a
+ *  known mapping sends a query and is parked, like a packet waiting for
+ *  ARP; later packets for the same address queue up behind it, at most
+ *  depth of them, a full queue drops its oldest (head) or the new packet
+ *  (tail). The answer is cached and the queue is run through the router
+ *  again; a queue without an answer after timeout ms is dropped.
+ *
+ *  The protocol is one line per message:
+ *  @code
+ *  Q <addr>                                  router -> daemon
+ *  A <addr> <len>[ <prefix>/<len>:<weight>]*  daemon -> router
+ *  @endcode
+ *  The answer holds for all of <addr>/<len>, an answer without prefixes
+ *  means there is no mapping (a legacy host); that one is cached for
+ *  negative ms only, the host may upgrade. Query timeouts and negative
+ *  answers expire on timer wheels (sixonewheel.h) under the resolver lock.
+ */
+
+#ifndef SIXONEASYNC_H
+#define SIXONEASYNC_H
+
+#include <pthread.h>
+#include <pcap.h>
+
+#include "sixonetypes.h"
+#include "sixonelpm.h"
+#include "sixonepkt.h"
+#include "sixonewheel.h"
+
+/// @brief Default time to wait for an answer (ms)
+#define ASYNC_TIMEOUT_MS 1000
+/// @brief Default time a negative answer is cached (ms)
+#define ASYNC_NEGATIVE_MS 30000
+/// @brief Default packets parked per address
+#define ASYNC_DEPTH 16
+/// @brief Addresses waiting for an answer at once, packets for more are dropped
+#define ASYNC_MAX_PENDING 1024
+/// @brief Hash buckets of the pending table
+#define ASYNC_BUCKETS 256
+
+/// @brief A full queue drops its oldest packet
+#define ASYNC_DROP_HEAD 0
+/// @brief A full queue drops the packet that does not fit
+#define ASYNC_DROP_TAIL 1
+
+/**
+ * @brief A parked packet, a copy of what got_packet() was given
+ */
+typedef struct async_pkt_ *async_pkt;
+struct async_pkt_ {
+	async_pkt next;
+	u_char *args;
+	struct pcap_pkthdr hdr;
+	u_char data[];
+};
+
+/**
+ * @brief An address waiting for its mapping and the packets parked for it
+ */
+typedef struct async_pending_ *async_pending;
+struct async_pending_ {
+	async_pending next;     /// hash chain
+	struct in6_addr addr;
+	struct wheel_timer_ timer; /// drops the queue when the answer takes too long
+	async_pkt head, tail;
+	u_int depth;
+};
+
+/**
+ * @brief State of the asynchronous resolver
+ */
+typedef struct sixone_async_ {
+	char *path;             /// socket of the daemon
+	int fd;                 /// -1 while disconnected
+	u_int timeout_ms;
+	u_int negative_ms;
+	u_int depth;
+	int drop;               /// ASYNC_DROP_*
+	sixone_lpm cache;       /// answered addr/len -> ip_list, addresses without mappings -> a marker
+	async_pending pending[ASYNC_BUCKETS];
+	u_int pending_c;
+	sixone_wheel expiry;    /// pending query timeouts
+	sixone_wheel negative;  /// negative answers to forget
+	u_int generation;       /// bumped by async_flush(), older negative answers are gone already
+	u_int releasing;        /// answers whose packets are being run through the router
+	u_int queries;          /// queries sent
+	u_int answers;          /// answers received
+	u_int parked;           /// packets parked
+	u_int released;         /// parked packets run through the router
+	u_int dropped_full;     /// packets dropped for a full queue (or too many addresses pending)
+	u_int dropped_timeout;  /// parked packets dropped for want of an answer
+	int stop;
+	pthread_t reader;
+	pthread_mutex_t lock;
+	pthread_cond_t idle;    /// signalled when nothing is pending or being released any more
+} *sixone_async;
+
+/// @brief The asynchronous resolver, NULL when Resolver= is not configured
+extern sixone_async global_async;
+
+/**
+ *  @brief Connects to the daemon and starts the thread reading its answers
+ *  @param path The socket
+ *  @param arg Options, "timeout=<ms> depth=<n> drop=head|tail negative=<ms>", any of them may be left out
+ *  @return The resolver, NULL (with a message on stderr) on failure
+ */
+sixone_async alloc_sixone_async(const char *path, const char *arg);
+
+/**
+ *  @brief Stops the reader thread, drops whatever is parked and frees everything
+ */
+void free_sixone_async(sixone_async async);
+
+/**
+ *  @brief Parks pkt if the address it needs resolved has no mapping cached yet
+ *
+ *  Outbound packets need their destination resolved, bilateral inbound ones
+ *  their source, everything else goes ahead.
+ *  @param header, args As given to got_packet(), for release_packet()
+ *  @return 1 if the packet was parked (or dropped), 0 if it can be processed now
+ */
+int async_park(sixone_async async, sixone_pkt pkt, const struct pcap_pkthdr *header, u_char *args);
+
+/**
+ *  @brief sixone_resolv hook answering from the cache, installed by alloc_sixone_async()
+ */
+ip_list async_resolv(sixone_ip ip, u_int only_sixone);
+
+/**
+ *  @brief Forgets every cached answer, call when the mappings change
+ */
+void async_flush(sixone_async async);
+
+/**
+ *  @brief Waits until nothing is pending or being released, at most timeout_ms and a bit
+ */
+void async_drain(sixone_async async);
+
+/**
+ *  @brief Prints the counters
+ */
+void async_report(sixone_async async);
+
+#endif // SIXONEASYNC_H
@@ -0,0 +1,1312 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonebench.c
+ *  @brief Six-One Router micro benchmarks
+ *  @date 2026-10-19
+ *
+ *  Usage: sixonebench [suite ...], without arguments every suite is run.
+ *  Each suite verifies that the implementations it compares agree before timing them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+
+#include <sys/types.h>
+
+#include "sixonebpf.h"
+#include "sixonecksum.h"
+#include "sixonect.h"
+#include "sixoneicmp.h"
+#include "sixoneload.h"
+#include "sixonepolicy.h"
+#include "sixonerewrite.h"
+#include "sixonerss.h"
+
+/// @brief Bytes to push through a kernel per measurement
+#define BENCH_BYTES (256 * 1024 * 1024)
+/// @brief Addresses rewritten per rewrite measurement
+#define BENCH_REWRITES (32 * 1024 * 1024)
+/// @brief Conversations checked and hashed per rss measurement
+#define BENCH_RSS_FLOWS (64 * 1024)
+/// @brief Workers the rss spread is measured over
+#define BENCH_RSS_WORKERS 8
+/// @brief Legacy flows tracked per ct measurement
+#define BENCH_CT_FLOWS (1024 * 1024)
+/// @brief Flows per round of the small table the ct churn check rebuilds
+#define BENCH_CT_CHURN 256
+/// @brief Timers armed per wheel measurement
+#define BENCH_TIMERS (1024 * 1024)
+/// @brief Oversized packets per icmp measurement
+#define BENCH_ICMP_PKTS (1024 * 1024)
+/// @brief Frames each capture filter is checked and timed with
+#define BENCH_BPF_PKTS (64 * 1024)
+/// @brief Edge and transit nets of the site whose filter has to be coarsened
+#define BENCH_BPF_NETS 600
+
+/**
+ * @brief A benchmark suite
+ */
+struct bench {
+	const char *name;
+	const char *descr;
+	int (*run)();
+};
+
+/// @brief Defeats dead code elimination of the measured calls
+volatile u_int64_t bench_sink;
+
+static u_int64_t bench_rand_state = 1;
+
+static u_int64_t bench_rand()
+{
+	u_int64_t z = (bench_rand_state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static void bench_fill(u_char *buf, u_int len)
+{
+	u_int i;
+	for(i = 0; i < len; i++)
+		buf[i] = bench_rand();
+}
+
+static double bench_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *  @brief checksum() as used on the packet path, with the reference and every available kernel
+ */
+static int bench_cksum()
+{
+	static const u_int sizes[] = { 40, 64, 128, 256, 576, 1280, 1500, 4096, 9000, 0 };
+	static const char *kernels[] = { "scalar", "sse2", "avx2", NULL };
+	u_char *buf = malloc(9000 + 1);
+	u_int i, k, n, iter, len;
+	u_int16_t ref;
+	double t0, t, tk;
+	cksum_fn fn;
+
+	if(NULL == buf) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+	bench_fill(buf, 9001);
+
+	// verify against the reference for every length and alignment
+	for(len = 0; len <= 9000; len += (len < 130 ? 1 : 97)) {
+		ref = checksum_ref(0, buf + (len & 7), len);
+		for(k = 0; NULL != kernels[k]; k++) {
+			if(NULL == (fn = cksum_impl(kernels[k])))
+				continue;
+			if(cksum_fold(fn(buf + (len & 7), len)) != ref) {
+				printf("cksum: %s disagrees with checksum_ref() at %u bytes\n", kernels[k], len);
+				return 1;
+			}
+		}
+	}
+
+	printf("checksum() selected kernel: %s\n", cksum_selected());
+	printf("%8s %12s", "bytes", "ref ns");
+	for(k = 0; NULL != kernels[k]; k++)
+		printf(" %12s", kernels[k]);
+	printf("   (ns/call, speedup vs ref in parentheses)\n");
+
+	for(i = 0; 0 != sizes[i]; i++) {
+		iter = BENCH_BYTES / sizes[i] / 8;
+
+		t0 = bench_now();
+		for(n = 0; n < iter; n++)
+			bench_sink += checksum_ref(n, buf, sizes[i]);
+		t = (bench_now() - t0) * 1e9 / iter;
+		printf("%8u %12.1f", sizes[i], t);
+
+		for(k = 0; NULL != kernels[k]; k++) {
+			if(NULL == (fn = cksum_impl(kernels[k]))) {
+				printf(" %12s", "n/a");
+				continue;
+			}
+			iter = BENCH_BYTES / sizes[i];
+			t0 = bench_now();
+			for(n = 0; n < iter; n++)
+				bench_sink += cksum_fold(fn(buf, sizes[i]) + n);
+			tk = (bench_now() - t0) * 1e9 / iter;
+			printf(" %6.1f(%4.1fx)", tk, t / tk);
+		}
+		printf("\n");
+	}
+
+	// address sized sums, as in cksumNeutralIp()
+	iter = BENCH_BYTES / 16;
+	t0 = bench_now();
+	for(n = 0; n < iter; n++) {
+		buf[0] = n;
+		bench_sink += incksum16(buf);
+	}
+	t = (bench_now() - t0) * 1e9 / iter;
+	t0 = bench_now();
+	for(n = 0; n < iter; n++) {
+		buf[0] = n;
+		bench_sink += checksum(0, buf, 16);
+	}
+	printf("%8u incksum16() %.1f ns, checksum() %.1f ns\n", 16, t, (bench_now() - t0) * 1e9 / iter);
+
+	free(buf);
+	return 0;
+}
+
+/// @brief Flows hashed per policy measurement
+#define BENCH_FLOWS (1 << 20)
+
+/**
+ *  @brief A list of n transit prefixes 2001:db9:<i>::/48 with weights i+1
+ */
+static ip_list bench_list(u_int n)
+{
+	ip_list ret = NULL, *curr = &ret;
+	u_int i;
+
+	for(i = 0; i < n; i++) {
+		*curr = alloc_ip_list();
+		(*curr)->ip = alloc_sixone_ip();
+		(*curr)->ip->ip.s6_addr[0] = 0x20;
+		(*curr)->ip->ip.s6_addr[1] = 0x01;
+		(*curr)->ip->ip.s6_addr[2] = 0x0d;
+		(*curr)->ip->ip.s6_addr[3] = 0xb9;
+		(*curr)->ip->ip.s6_addr[5] = i;
+		(*curr)->ip->pfx = 48;
+		(*curr)->weight = i + 1;
+		curr = &(*curr)->next;
+	}
+	return ret;
+}
+
+/**
+ *  @brief policy_pick_weighted(): share per weight, flows moved on removal/addition, ns per pick
+ */
+static int bench_policy()
+{
+	static const u_int sizes[] = { 1, 2, 4, 8, 16, 0 };
+	ip_list list = bench_list(4), l;
+	sixone_ip *pick = malloc(BENCH_FLOWS * sizeof(sixone_ip)), p;
+	u_int count[4] = { 0 }, i, n, moved, wrong, total = 0;
+	double t0;
+
+	if(NULL == pick) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+
+	for(n = 0; n < BENCH_FLOWS; n++) {
+		pick[n] = policy_pick_weighted(list, n * 0x9E3779B1);
+		count[pick[n]->ip.s6_addr[5]]++;
+	}
+	for(l = list; l != NULL; l = l->next)
+		total += l->weight;
+	printf("%8s %8s %8s\n", "weight", "share", "expected");
+	for(i = 0, l = list; l != NULL; i++, l = l->next)
+		printf("%8u %7.2f%% %7.2f%%\n", l->weight, 100.0 * count[i] / BENCH_FLOWS, 100.0 * l->weight / total);
+
+	// drop the second prefix, only its flows may move
+	l = list->next;
+	list->next = l->next;
+	for(n = moved = wrong = 0; n < BENCH_FLOWS; n++) {
+		p = policy_pick_weighted(list, n * 0x9E3779B1);
+		if(p != pick[n]) {
+			moved++;
+			wrong += pick[n] != l->ip;
+		}
+	}
+	printf("removing weight %u: %.2f%% of the flows moved (%.2f%% expected), %u moved needlessly\n",
+	       l->weight, 100.0 * moved / BENCH_FLOWS, 100.0 * count[1] / BENCH_FLOWS, wrong);
+	list->next = l;
+	if(0 != wrong) {
+		printf("policy: flows moved that were not on the removed prefix\n");
+		return 1;
+	}
+
+	for(i = 0; 0 != sizes[i]; i++) {
+		l = bench_list(sizes[i]);
+		t0 = bench_now();
+		for(n = 0; n < BENCH_FLOWS; n++)
+			bench_sink += (u_int64_t)policy_pick_weighted(l, n);
+		printf("%8u prefixes %.1f ns/pick\n", sizes[i], (bench_now() - t0) * 1e9 / BENCH_FLOWS);
+	}
+
+	free(pick);
+	return 0;
+}
+
+/// @brief Lines in the generated mapping file
+#define BENCH_MAPPINGS 2000000
+/// @brief Random addresses fed to the IPv6 parsers
+#define BENCH_ADDRS 1000000
+
+/**
+ *  @brief A random address, often with a run of zero groups for "::"
+ *  @param first First group the run may start at
+ */
+static void bench_addr(struct in6_addr *a, u_int first)
+{
+	u_int i, from, n;
+
+	for(i = 0; i < 16; i++)
+		a->s6_addr[i] = bench_rand();
+	if(bench_rand() % 4) {
+		from = first + bench_rand() % (8 - first);
+		n = bench_rand() % (9 - from);
+		memset(&a->s6_addr[2 * from], 0, 2 * n);
+	}
+}
+
+/**
+ *  @brief Writes a in one of the ways people write addresses
+ */
+static void bench_addr_text(const struct in6_addr *a, char *buf, size_t size)
+{
+	static const char *fmt[] = { "%x:%x:%x:%x:%x:%x:%x:%x", "%04x:%04x:%04x:%04x:%04x:%04x:%04x:%04x",
+				     "%X:%X:%X:%X:%X:%X:%X:%X" };
+	u_int g[8], i, k = bench_rand() % 6;
+
+	if(k >= 3) {
+		inet_ntop(AF_INET6, a, buf, size);
+		return;
+	}
+	for(i = 0; i < 8; i++)
+		g[i] = a->s6_addr[2 * i] << 8 | a->s6_addr[2 * i + 1];
+	snprintf(buf, size, fmt[k], g[0], g[1], g[2], g[3], g[4], g[5], g[6], g[7]);
+}
+
+/**
+ *  @brief The reader load_mappings() replaces: fgets(), sscanf(), inet_pton() and maptab_add() line by line
+ *  @param tab The table to fill, NULL to only parse
+ */
+static int bench_load_old(const char *file, sixone_maptab tab)
+{
+	FILE *fh;
+	char line[1024];
+	struct sixone_mapping m;
+
+	if(NULL == (fh = fopen(file, "r")))
+		return -1;
+	while(NULL != fgets(line, sizeof(line), fh))
+		if(0 == maptab_parse(line, &m) && NULL != tab)
+			maptab_add(tab, &m);
+	fclose(fh);
+	return 0;
+}
+
+static void bench_free_list(ip_list l)
+{
+	ip_list next;
+
+	for(; l != NULL; l = next) {
+		next = l->next;
+		free(l->ip);
+		free(l);
+	}
+}
+
+/**
+ *  @brief Whether two tables resolve addr the same
+ */
+static int bench_same(sixone_maptab a, sixone_maptab b, const struct in6_addr *addr)
+{
+	ip_list la = maptab_resolve(a, addr), lb = maptab_resolve(b, addr), l, next;
+	int same = 1;
+
+	for(l = la, next = lb; l != NULL && next != NULL; l = l->next, next = next->next)
+		same &= 0 == memcmp(l->ip, next->ip, sizeof(*l->ip)) && l->weight == next->weight;
+	same &= NULL == l && NULL == next;
+	bench_free_list(la);
+	bench_free_list(lb);
+	return same;
+}
+
+/**
+ *  @brief Mapping file start up: IPv6 text parsers, load_mappings() on 1 - n threads, maptab_build()
+ */
+static int bench_load()
+{
+	static const char *kernels[] = { "scalar", "sse2", NULL };
+	static const char *bad[] = { "1:2:3", "1::2::3", "12345::", ":1::", "1:2:3:4:5:6:7:8:9", "1:2:3:4:5:6:7::8",
+				     "::ffff:1.2.3.4", "1:", ":::", "g::" };
+	char file[] = "/tmp/sixonebench.XXXXXX", text[128], edge[64], tran[64];
+	struct sixone_mapping *ref = NULL, *m;
+	struct in6_addr *addr, a, got;
+	sixone_maptab old_tab, new_tab;
+	ip6_parse_fn fn;
+	u_int i, k, len, threads, cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	double t0, t_old, t_new;
+	int n_ref = 0, n, fd, ret = 1;
+	FILE *fh;
+
+	// the parsers against inet_ntop() and friends, and what they must refuse
+	for(i = 0; i < BENCH_ADDRS + sizeof(bad) / sizeof(bad[0]); i++) {
+		memset(text, 0, sizeof(text));
+		if(i < BENCH_ADDRS) {
+			bench_addr(&a, 0);
+			bench_addr_text(&a, text, sizeof(text));
+			len = strlen(text);
+			// the kernels must stop at the end of the address, whatever follows
+			strcpy(text + len, i % 2 ? "/64\t2001:db8::1 4" : "\n");
+			// inet_ntop() writes some as ::a.b.c.d, those are left to inet_pton()
+			if(NULL != memchr(text, '.', len))
+				len = 0;
+		}
+		else {
+			strcpy(text, bad[i - BENCH_ADDRS]);
+			len = 0;
+		}
+		for(k = 0; NULL != kernels[k]; k++) {
+			if(NULL == (fn = ip6_parse_impl(kernels[k])))
+				continue;
+			if(len != fn(text, text + sizeof(text), &got) || (len && 0 != memcmp(&got, &a, sizeof(a)))) {
+				text[strcspn(text, "/\n")] = 0;
+				printf("load: %s misread %s\n", kernels[k], text);
+				return 1;
+			}
+		}
+	}
+
+	// a file that looks like sixonegen's, with every address format
+	if(-1 == (fd = mkstemp(file)) || NULL == (fh = fdopen(fd, "w"))) {
+		printf("Could not create %s\n", file);
+		return 1;
+	}
+	for(i = 0; i < BENCH_MAPPINGS; i++) {
+		// zeroes only in the host part, or a few prefixes would collect most of the mappings
+		bench_addr(&a, 4);
+		bench_addr_text(&a, edge, sizeof(edge));
+		bench_addr(&a, 4);
+		bench_addr_text(&a, tran, sizeof(tran));
+		if(0 == i % 1000)
+			fprintf(fh, "# comment\n\n");
+		if(i % 4)
+			fprintf(fh, "%s/%u\t%s\t%u\n", edge, 32 + (u_int)bench_rand() % 5 * 8, tran, 1 + (u_int)bench_rand() % 8);
+		else
+			fprintf(fh, "%s/%u %s\n", edge, 48, tran);
+	}
+	fclose(fh);
+
+	// what the old reader made of it is the reference
+	old_tab = alloc_sixone_maptab();
+	new_tab = alloc_sixone_maptab();
+	addr = malloc(BENCH_FLOWS * sizeof(*addr));
+	if(NULL == old_tab || NULL == new_tab || NULL == addr) {
+		printf("Could not malloc()\n");
+		goto out;
+	}
+	t0 = bench_now();
+	bench_load_old(file, NULL);
+	printf("%-30s %8.3f s\n", "fgets/sscanf", bench_now() - t0);
+	t0 = bench_now();
+	bench_load_old(file, old_tab);
+	t_old = bench_now() - t0;
+	printf("%-30s %8.3f s, %u mappings\n", "fgets/sscanf + maptab_add", t_old, old_tab->count);
+
+	for(k = 0; NULL != kernels[k]; k++) {
+		if(NULL == (fn = ip6_parse_impl(kernels[k])))
+			continue;
+		for(threads = 1; ; threads = threads * 2 < cpus ? threads * 2 : cpus) {
+			t0 = bench_now();
+			n = load_mappings(file, threads, fn, &m);
+			t_new = bench_now() - t0;
+			if(NULL == ref) {
+				ref = m;
+				n_ref = n;
+			}
+			else {
+				if(n != n_ref || 0 != memcmp(m, ref, n * sizeof(*m))) {
+					printf("load: %s on %u threads read something else\n", kernels[k], threads);
+					free(m);
+					goto out;
+				}
+				free(m);
+			}
+			printf("load_mappings %-6s %2u thread%s %8.3f s, %d mappings\n", kernels[k], threads, 1 == threads ? " " : "s", t_new, n);
+			if(threads == cpus)
+				break;
+		}
+	}
+
+	t0 = bench_now();
+	for(i = 0; i < (u_int)n_ref; i++)
+		maptab_add(new_tab, &ref[i]);
+	printf("%-30s %8.3f s\n", "maptab_add", bench_now() - t0);
+	maptab_flush(new_tab);
+	t0 = bench_now();
+	if(0 != maptab_build(new_tab, ref, n_ref)) {
+		printf("Could not malloc()\n");
+		goto out;
+	}
+	printf("%-30s %8.3f s, %u mappings\n", "maptab_build", bench_now() - t0, new_tab->count);
+	maptab_flush(new_tab);
+
+	t0 = bench_now();
+	n = load_mappings(file, 0, NULL, &m);
+	maptab_build(new_tab, m, n);
+	free(m);
+	t_new = bench_now() - t0;
+	printf("start up: %.3f s -> %.3f s (%.1fx) on %u cpus\n", t_old, t_new, t_old / t_new, cpus);
+
+	// and both tables must resolve the same, for the mapped prefixes and random addresses
+	if(new_tab->count != old_tab->count) {
+		printf("load: %u mappings, the old reader has %u\n", new_tab->count, old_tab->count);
+		goto out;
+	}
+	for(i = 0; i < BENCH_FLOWS; i++) {
+		if(i % 2)
+			bench_addr(&addr[i], 0);
+		else
+			addr[i] = i % 4 ? ref[bench_rand() % n_ref].transit : ref[bench_rand() % n_ref].edge;
+		if(!bench_same(old_tab, new_tab, &addr[i])) {
+			inet_ntop(AF_INET6, &addr[i], text, sizeof(text));
+			printf("load: %s resolves differently\n", text);
+			goto out;
+		}
+	}
+	ret = 0;
+
+out:
+	unlink(file);
+	free(ref);
+	free(addr);
+	free_sixone_maptab(old_tab);
+	free_sixone_maptab(new_tab);
+	return ret;
+}
+
+/**
+ *  @brief Bit by bit splice, the reference for the rewrite kernels
+ */
+static void bench_splice_ref(struct in6_addr *addr, const struct in6_addr *prefix, u_int len)
+{
+	u_int i;
+	u_char bit;
+
+	for(i = 0; i < len && i < 128; i++) {
+		bit = 0x80 >> (i % 8);
+		addr->s6_addr[i / 8] = (addr->s6_addr[i / 8] & ~bit) | (prefix->s6_addr[i / 8] & bit);
+	}
+}
+
+/**
+ *  @brief Per packet splice of a prefix: run time bit offset, kernel looked up per packet, kernel bound per target
+ */
+static int bench_rewrite()
+{
+	static const u_int mix_aligned[] = { 48, 56, 64, 64, 0 };
+	static const u_int mix_any[] = { 3, 17, 29, 48, 52, 56, 61, 64, 77, 96, 113, 127, 0 };
+	static const struct { const char *name; const u_int *lens; } mixes[] = {
+		{ "/48 /56 /64", mix_aligned }, { "12 lengths, /3 - /127", mix_any }, { NULL, NULL }
+	};
+	struct sixone_rewrite_ rw[16];
+	struct in6_addr pfx[16], *addr, a, b, c;
+	u_int i, len, m, n_rw, n;
+	double t0, t_gen, t_dis, t_bnd;
+	rewrite_fn fn;
+
+	// every length against the bit by bit reference, prefixes with host bits set
+	for(len = 0; len <= 129; len++) {
+		for(i = 0; i < 64; i++) {
+			bench_fill(a.s6_addr, 16);
+			bench_fill(pfx[0].s6_addr, 16);
+			b = c = a;
+			bench_splice_ref(&a, &pfx[0], len);
+			rewrite_generic(&b, &pfx[0], len);
+			rewrite_kernel(len)(&c, &pfx[0]);
+			if(0 != memcmp(&a, &b, 16) || 0 != memcmp(&a, &c, 16)) {
+				printf("rewrite: /%u disagrees with the bit by bit splice\n", len);
+				return 1;
+			}
+		}
+	}
+
+	if(NULL == (addr = malloc(4096 * sizeof(*addr)))) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+	bench_fill((u_char *)addr, 4096 * sizeof(*addr));
+
+	printf("%-24s %12s %13s %11s   (ns/address, speedup vs generic)\n", "lengths", "generic", "looked up", "bound");
+	for(m = 0; NULL != mixes[m].name; m++) {
+		for(n_rw = 0; 0 != mixes[m].lens[n_rw]; n_rw++) {
+			bench_fill(pfx[n_rw].s6_addr, 16);
+			rewrite_bind(&rw[n_rw], &pfx[n_rw], mixes[m].lens[n_rw]);
+		}
+
+		t0 = bench_now();
+		for(n = 0; n < BENCH_REWRITES; n++)
+			rewrite_generic(&addr[n % 4096], &pfx[n % n_rw], mixes[m].lens[n % n_rw]);
+		t_gen = (bench_now() - t0) * 1e9 / BENCH_REWRITES;
+
+		t0 = bench_now();
+		for(n = 0; n < BENCH_REWRITES; n++) {
+			fn = rewrite_kernel(mixes[m].lens[n % n_rw]);
+			fn(&addr[n % 4096], &pfx[n % n_rw]);
+		}
+		t_dis = (bench_now() - t0) * 1e9 / BENCH_REWRITES;
+
+		t0 = bench_now();
+		for(n = 0; n < BENCH_REWRITES; n++)
+			rewrite_apply(&rw[n % n_rw], &addr[n % 4096]);
+		t_bnd = (bench_now() - t0) * 1e9 / BENCH_REWRITES;
+
+		printf("%-24s %12.2f %7.2f(%3.1fx) %5.2f(%3.1fx)\n", mixes[m].name, t_gen, t_dis, t_gen / t_dis, t_bnd, t_gen / t_bnd);
+	}
+	for(i = 0; i < 4096; i++)
+		bench_sink += addr[i].s6_addr[i % 16];
+	free(addr);
+	return 0;
+}
+
+/**
+ *  @brief Writes an ethernet/IPv6 frame with an optional fragment header and an upper layer header
+ *  @param f The frame, at least 14 + 40 + 8 + 20 bytes, 2 bytes off a 4 byte boundary
+ *  @param frag -1 for no fragment header, else the fragment offset (8 byte units), later fragments carry no ports
+ *  @param sport, dport Ports (network order)
+ *  @return The frame length
+ */
+static u_int bench_frame(u_char *f, const struct in6_addr *src, const struct in6_addr *dst, u_int8_t proto,
+			 int frag, u_int16_t sport, u_int16_t dport)
+{
+	struct ip6_hdr *ip = (struct ip6_hdr *)(f + 14);
+	u_char *l4 = f + 14 + sizeof(*ip);
+	u_int16_t offlg;
+
+	memset(f, 0, 14 + sizeof(*ip) + 8 + 20);
+	f[12] = 0x86;
+	f[13] = 0xdd;
+	ip->ip6_vfc = 0x60;
+	ip->ip6_hlim = 64;
+	ip->ip6_nxt = proto;
+	memcpy(&ip->ip6_src, src, sizeof(*src));
+	memcpy(&ip->ip6_dst, dst, sizeof(*dst));
+	if(0 <= frag) {
+		ip->ip6_nxt = IPPROTO_FRAGMENT;
+		l4[0] = proto;
+		offlg = htons(frag << 3 | 1);
+		memcpy(l4 + 2, &offlg, 2);
+		l4 += 8;
+	}
+	memcpy(l4, &sport, 2);
+	memcpy(l4 + 2, &dport, 2);
+	if(IPPROTO_TCP == proto)
+		l4[12] = 5 << 4;
+	ip->ip6_plen = htons(l4 + 20 - (u_char *)(ip + 1));
+	return l4 + 20 - f;
+}
+
+/**
+ *  @brief The address prefix/64 with a random interface identifier
+ */
+static void bench_host(struct in6_addr *a, const struct in6_addr *prefix)
+{
+	memcpy(a->s6_addr, prefix->s6_addr, 8);
+	bench_fill(a->s6_addr + 8, 8);
+}
+
+/**
+ *  @brief rss_hash(): both directions of a flow, before and after the rewrite or a hairpin, hash alike; spread and ns per packet
+ */
+static int bench_rss()
+{
+	struct in6_addr edge, transit, r_edge, r_transit, legacy, e, t, re, rt, l, hp, ht;
+	struct sixone_pkt_ *pkts, pkt;
+	u_char buf[2 + 128], *f = buf + 2, *frames;
+	u_int i, len, count[BENCH_RSS_WORKERS], max;
+	u_int16_t a, b;
+	u_int32_t h;
+	u_int8_t proto;
+	double t0;
+
+	inet_pton(AF_INET6, "fd00:1::", &edge);
+	inet_pton(AF_INET6, "2001:db8:1::", &transit);
+
+	frames = malloc(BENCH_RSS_FLOWS * 128);
+	pkts = malloc(BENCH_RSS_FLOWS * sizeof(*pkts));
+	if(NULL == frames || NULL == pkts) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+
+	for(i = 0; i < BENCH_RSS_FLOWS; i++) {
+		// a remote six/one site (edge fd00:2:<i>::/64 behind transit 2001:db8:2:<i>::/64) or a legacy host
+		inet_pton(AF_INET6, "fd00:2::", &r_edge);
+		inet_pton(AF_INET6, "2001:db8:2::", &r_transit);
+		inet_pton(AF_INET6, "2001:db8:99::", &legacy);
+		r_edge.s6_addr[4] = r_transit.s6_addr[6] = i >> 8;
+		r_edge.s6_addr[5] = r_transit.s6_addr[7] = i;
+		bench_host(&e, &edge);
+		memcpy(&t, &e, sizeof(t));
+		memcpy(t.s6_addr, transit.s6_addr, 8);
+		bench_host(&re, &r_edge);
+		memcpy(&rt, &re, sizeof(rt));
+		memcpy(rt.s6_addr, r_transit.s6_addr, 8);
+		bench_host(&l, &legacy);
+		bench_host(&hp, &edge);
+		memcpy(&ht, &hp, sizeof(ht));
+		memcpy(ht.s6_addr, transit.s6_addr, 8);
+		a = bench_rand();
+		b = bench_rand();
+		proto = i % 2 ? IPPROTO_TCP : IPPROTO_UDP;
+
+		// outbound before the rewrite
+		len = bench_frame(f, &e, i % 3 ? &re : &l, proto, -1, a, b);
+		if(0 != parse_packet(&pkt, f, len)) {
+			printf("rss: frame %u does not parse\n", i);
+			return 1;
+		}
+		h = rss_hash(&pkt);
+		memcpy(frames + i * 128, f, len);
+
+		// the answer after the remote (or nobody) rewrote it
+		len = bench_frame(f, i % 3 ? &rt : &l, &t, proto, -1, b, a);
+		parse_packet(&pkt, f, len);
+		if(h != rss_hash(&pkt)) {
+			printf("rss: flow %u hashes differently inbound\n", i);
+			return 1;
+		}
+		// the fragments of a datagram stay together
+		len = bench_frame(f, &e, &re, proto, 0, a, b);
+		parse_packet(&pkt, f, len);
+		h = rss_hash(&pkt);
+		len = bench_frame(f, &e, &re, proto, 185, 0, 0);
+		parse_packet(&pkt, f, len);
+		if(h != rss_hash(&pkt)) {
+			printf("rss: fragments of flow %u hash differently\n", i);
+			return 1;
+		}
+		// a hairpin to our transit address of another edge host (hp), and its answer after hairpin()
+		len = bench_frame(f, &e, &ht, proto, -1, a, b);
+		parse_packet(&pkt, f, len);
+		h = rss_hash(&pkt);
+		len = bench_frame(f, &hp, &t, proto, -1, b, a);
+		parse_packet(&pkt, f, len);
+		if(h != rss_hash(&pkt)) {
+			printf("rss: hairpin flow %u hashes differently\n", i);
+			return 1;
+		}
+	}
+
+	for(i = 0; i < BENCH_RSS_FLOWS; i++)
+		parse_packet(&pkts[i], frames + i * 128, 128);
+	memset(count, 0, sizeof(count));
+	t0 = bench_now();
+	for(i = 0; i < BENCH_RSS_FLOWS * 16; i++)
+		count[(u_int64_t)rss_hash(&pkts[i % BENCH_RSS_FLOWS]) * BENCH_RSS_WORKERS >> 32]++;
+	printf("rss_hash() %.1f ns/packet, %u flows over %u workers:", (bench_now() - t0) * 1e9 / (BENCH_RSS_FLOWS * 16),
+	       BENCH_RSS_FLOWS, BENCH_RSS_WORKERS);
+	for(i = max = 0; i < BENCH_RSS_WORKERS; i++) {
+		printf(" %u", count[i] / 16);
+		max = count[i] > max ? count[i] : max;
+	}
+	printf(" (busiest %.2fx the mean)\n", (double)max * BENCH_RSS_WORKERS / (BENCH_RSS_FLOWS * 16));
+
+	free(frames);
+	free(pkts);
+	return 0;
+}
+
+/**
+ *  @brief An interface of net_c nets for the bpf suite, fill them in with bench_net()
+ */
+static sixone_if bench_if(const char *name, u_int net_c)
+{
+	sixone_if dev = calloc(1, sizeof(*dev));
+	u_int j;
+
+	if(NULL == dev || NULL == (dev->net_v = calloc(net_c, sizeof(sixone_net))))
+		return NULL;
+	dev->if_name = (u_char *)name;
+	dev->net_c = net_c;
+	for(j = 0; j < net_c; j++) {
+		if(NULL == (dev->net_v[j] = calloc(1, sizeof(struct sixone_net_))) ||
+		   NULL == (dev->net_v[j]->addr = calloc(1, sizeof(struct sixone_ip_))))
+			return NULL;
+	}
+	return dev;
+}
+
+static void bench_net(sixone_if dev, u_int j, const struct in6_addr *addr, int pfx, int edge)
+{
+	dev->net_v[j]->addr->ip = *addr;
+	dev->net_v[j]->addr->pfx = pfx;
+	dev->net_v[j]->edge = edge;
+}
+
+static void bench_free_if(sixone_if dev)
+{
+	u_int j;
+
+	for(j = 0; j < dev->net_c; j++) {
+		free(dev->net_v[j]->addr);
+		free(dev->net_v[j]);
+	}
+	free(dev->net_v);
+	free(dev);
+}
+
+static int bench_in_net(const struct in6_addr *a, sixone_ip net)
+{
+	int bits = net->pfx;
+
+	if(0 != memcmp(a, &net->ip, bits / 8))
+		return 0;
+	return 0 == bits % 8 || 0 == ((a->s6_addr[bits / 8] ^ net->ip.s6_addr[bits / 8]) & (0xff00 >> bits % 8));
+}
+
+/**
+ *  @brief What got_packet() wants from dev, the filter stands for this
+ */
+static int bench_bpf_want(sixone_settings settings, sixone_if dev, const u_char *f, u_int len)
+{
+	const struct ip6_hdr *ip = (const struct ip6_hdr *)(f + 14);
+	u_int i, j, from = 0, local = 0, transit = 0;
+	sixone_net net;
+
+	if(len < 14 + sizeof(*ip) + 1 || 0x86 != f[12] || 0xdd != f[13])
+		return 0;
+	if(IPPROTO_ICMPV6 == ip->ip6_nxt) switch(f[14 + sizeof(*ip)]) {
+	case ICMP6_DST_UNREACH: case ICMP6_TIME_EXCEEDED: case ICMP6_PARAM_PROB:
+		// inbound_error() takes these from transit, only an edge interface has no use for them
+		for(j = 0; j < dev->net_c && dev->net_v[j]->edge; j++)
+			;
+		if(j == dev->net_c)
+			return 0;
+		break;
+	case ND_ROUTER_SOLICIT: case ND_ROUTER_ADVERT: case ND_NEIGHBOR_SOLICIT:
+	case ND_NEIGHBOR_ADVERT: case ND_REDIRECT:
+		return 0;
+	}
+
+	for(j = 0; j < dev->net_c; j++) {
+		net = dev->net_v[j];
+		if(0 == memcmp(&ip->ip6_src, &net->addr->ip, sizeof(ip->ip6_src)))
+			return 0;
+		if(net->edge) {
+			from |= bench_in_net(&ip->ip6_src, net->addr);
+			local |= bench_in_net(&ip->ip6_dst, net->addr);
+		}
+		else
+			transit = 1;
+	}
+	// edge role, anywhere but the same link; transit role, to any of our transit nets
+	if(from && !local)
+		return 1;
+	for(i = 0; transit && i < settings->if_c; i++)
+		for(j = 0; j < settings->if_v[i]->net_c; j++)
+			if(!settings->if_v[i]->net_v[j]->edge && bench_in_net(&ip->ip6_dst, settings->if_v[i]->net_v[j]->addr))
+				return 1;
+	return 0;
+}
+
+/**
+ *  @brief An address from one of the site's nets (a host or the net's own address) or from nowhere in particular
+ */
+static void bench_bpf_addr(sixone_settings settings, struct in6_addr *a)
+{
+	sixone_if dev = settings->if_v[bench_rand() % settings->if_c];
+	sixone_net net = dev->net_v[bench_rand() % dev->net_c];
+
+	switch(bench_rand() % 8) {
+	case 0:
+		*a = net->addr->ip;
+		break;
+	case 1:
+	case 2:
+		bench_fill(a->s6_addr, sizeof(*a));
+		a->s6_addr[0] = 0x2a;
+		break;
+	default:
+		bench_host(a, &net->addr->ip);
+	}
+}
+
+/**
+ *  @brief Checks the filter of every interface of settings on frames against bench_bpf_want()
+ *  @param exact Non-zero if the filters must match exactly, else they may let a superset through
+ */
+static int bench_bpf_site(const char *site, sixone_settings settings, u_char *frames, int exact)
+{
+	static const u_int8_t icmp_types[] = { ICMP6_ECHO_REQUEST, ICMP6_ECHO_REPLY, ND_NEIGHBOR_SOLICIT,
+					       ICMP6_DST_UNREACH, ICMP6_PACKET_TOO_BIG };
+	struct bpf_program prog;
+	struct in6_addr src, dst;
+	u_char *f;
+	u_int i, k, len, want, got, accepted, extra;
+	u_int8_t proto;
+	double t0;
+
+	for(i = 0; i < BENCH_BPF_PKTS; i++) {
+		f = frames + i * 128 + 2;
+		bench_bpf_addr(settings, &src);
+		bench_bpf_addr(settings, &dst);
+		proto = bench_rand() % 3 ? IPPROTO_UDP : IPPROTO_ICMPV6;
+		bench_frame(f, &src, &dst, proto, -1, bench_rand(), bench_rand());
+		if(IPPROTO_ICMPV6 == proto)
+			f[14 + 40] = icmp_types[bench_rand() % sizeof(icmp_types)];
+		if(0 == bench_rand() % 64)
+			f[12] = 0x08, f[13] = 0x00;
+	}
+
+	for(k = 0; k < settings->if_c; k++) {
+		if(0 != build_filter(settings, settings->if_v[k], &prog)) {
+			printf("Could not malloc()\n");
+			return 1;
+		}
+		if(prog.bf_len > SIXONE_BPF_MAXINSNS) {
+			printf("bpf: %s %s filter has %u instructions\n", site, settings->if_v[k]->if_name, prog.bf_len);
+			return 1;
+		}
+		for(i = accepted = extra = 0; i < BENCH_BPF_PKTS; i++) {
+			f = frames + i * 128 + 2;
+			len = 14 + 40 + 8 + 20;
+			want = bench_bpf_want(settings, settings->if_v[k], f, len);
+			got = 0 != bpf_filter(prog.bf_insns, f, len, len);
+			if(got != want && (exact || want)) {
+				inet_ntop(AF_INET6, f + 14 + 8, (char *)frames, INET6_ADDRSTRLEN);
+				inet_ntop(AF_INET6, f + 14 + 24, (char *)frames + 64, 64);
+				printf("bpf: %s %s filter %s %s -> %s, proto %u\n", site, settings->if_v[k]->if_name,
+				       got ? "accepts" : "drops", frames, frames + 64, f[14 + 6]);
+				return 1;
+			}
+			accepted += got;
+			extra += got && !want;
+		}
+
+		t0 = bench_now();
+		for(i = 0; i < BENCH_BPF_PKTS * 16; i++)
+			bench_sink += bpf_filter(prog.bf_insns, frames + (i % BENCH_BPF_PKTS) * 128 + 2, 128, 128);
+		printf("bpf_filter() %s %s %.1f ns/packet, %u instructions, %u of %u accepted, %u past the exact filter\n",
+		       site, settings->if_v[k]->if_name, (bench_now() - t0) * 1e9 / (BENCH_BPF_PKTS * 16),
+		       prog.bf_len, accepted, BENCH_BPF_PKTS, extra);
+		pcap_freecode(&prog);
+	}
+	return 0;
+}
+
+/**
+ *  @brief build_filter(): the programs of a small and a coarsened site agree with the classification, and their cost
+ */
+static int bench_bpf()
+{
+	static const struct {
+		u_int k;
+		const char *src, *dst;
+		int want;
+	} cases[] = {
+		{ 0, "fd00:1::5", "2001:db9::1", 1 },  // outbound
+		{ 0, "fd00:1::5", "fd00:2::9", 1 },    // hairpin to another link
+		{ 0, "fd00:1::5", "2001:db8::9", 1 },  // hairpin to a transit address
+		{ 0, "fd00:1::5", "fd00:1::9", 0 },    // on the link, not ours
+		{ 0, "fd00:1::5", "fd00:3:0:7::9", 0 },
+		{ 0, "fd00:1::", "2001:db9::1", 0 },   // our own address
+		{ 0, "2001:db9::1", "fd00:1::5", 0 },
+		{ 1, "fd00:1::5", "fd00:2::9", 0 },    // not from em1's edge net
+		{ 2, "2001:db9::1", "2001:db8:1::5", 1 },
+		{ 2, "2001:db9::1", "fd00:1::5", 0 },
+	};
+	struct sixone_settings_ settings;
+	sixone_if if_v[2], small[3];
+	struct in6_addr a, b;
+	u_char *frames, *f;
+	u_int i, len;
+	struct bpf_program prog;
+	int ret = 0;
+
+	frames = malloc(BENCH_BPF_PKTS * 128);
+	small[0] = bench_if("em0", 2);
+	small[1] = bench_if("em1", 1);
+	small[2] = bench_if("em2", 2);
+	if(NULL == frames || NULL == small[0] || NULL == small[1] || NULL == small[2]) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+	memset(&settings, 0, sizeof(settings));
+	settings.if_c = 3;
+	settings.if_v = small;
+	inet_pton(AF_INET6, "fd00:1::", &a);
+	bench_net(small[0], 0, &a, 64, 1);
+	inet_pton(AF_INET6, "fd00:3::", &a);
+	bench_net(small[0], 1, &a, 48, 1);
+	inet_pton(AF_INET6, "fd00:2::", &a);
+	bench_net(small[1], 0, &a, 64, 1);
+	inet_pton(AF_INET6, "2001:db8::", &a);
+	bench_net(small[2], 0, &a, 64, 0);
+	inet_pton(AF_INET6, "2001:db8:1::", &a);
+	bench_net(small[2], 1, &a, 64, 0);
+
+	f = frames + 2;
+	for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		inet_pton(AF_INET6, cases[i].src, &a);
+		inet_pton(AF_INET6, cases[i].dst, &b);
+		len = bench_frame(f, &a, &b, IPPROTO_UDP, -1, 1, 2);
+		if(0 != build_filter(&settings, small[cases[i].k], &prog)) {
+			printf("Could not malloc()\n");
+			return 1;
+		}
+		if(cases[i].want != (0 != bpf_filter(prog.bf_insns, f, len, len))) {
+			printf("bpf: %s filter %s %s -> %s\n", small[cases[i].k]->if_name,
+			       cases[i].want ? "drops" : "accepts", cases[i].src, cases[i].dst);
+			return 1;
+		}
+		pcap_freecode(&prog);
+	}
+	ret |= bench_bpf_site("small", &settings, frames, 1);
+
+	// too many scattered nets for the instruction limit, the prefixes are coarsened
+	if_v[0] = bench_if("em0", BENCH_BPF_NETS);
+	if_v[1] = bench_if("em1", BENCH_BPF_NETS);
+	if(NULL == if_v[0] || NULL == if_v[1]) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+	for(i = 0; i < BENCH_BPF_NETS; i++) {
+		inet_pton(AF_INET6, "fd00::", &a);
+		bench_fill(a.s6_addr + 1, 7);
+		bench_net(if_v[0], i, &a, 64, 1);
+		inet_pton(AF_INET6, "2001:db8::", &a);
+		bench_fill(a.s6_addr + 4, 2);
+		bench_net(if_v[1], i, &a, 48, 0);
+	}
+	settings.if_c = 2;
+	settings.if_v = if_v;
+	ret |= bench_bpf_site("large", &settings, frames, 0);
+
+	for(i = 0; i < 3; i++)
+		bench_free_if(small[i]);
+	bench_free_if(if_v[0]);
+	bench_free_if(if_v[1]);
+	free(frames);
+	return ret;
+}
+
+/**
+ *  @brief Connection tracking: flow setup, refresh and reply lookup rates at BENCH_CT_FLOWS flows, expiry, setup over expired slots
+ */
+static int bench_ct()
+{
+	struct in6_addr edge, transit, legacy, e, t, l, found;
+	struct sixone_pkt_ *out, *in;
+	u_char *frames;
+	sixone_ct ct;
+	u_int i, r, len, bad;
+	u_int16_t a, b;
+	u_int64_t now = 1000 * 1000000ULL;
+	double t0;
+
+	inet_pton(AF_INET6, "fd00:1::", &edge);
+	inet_pton(AF_INET6, "2001:db8:1::", &transit);
+	inet_pton(AF_INET6, "2001:db8:99::", &legacy);
+
+	// the bench keeps time itself, as a replay does
+	timers_replay = 1;
+	timers_run(now);
+
+	frames = malloc((size_t)BENCH_CT_FLOWS * 2 * 128);
+	out = malloc(BENCH_CT_FLOWS * sizeof(*out));
+	in = malloc(BENCH_CT_FLOWS * sizeof(*in));
+	if(NULL == frames || NULL == out || NULL == in || NULL == (ct = alloc_sixone_ct(BENCH_CT_FLOWS))) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+
+	// flow i: edge host e behind transit address t talks to legacy host l, the edge address goes in the frame tail
+	for(i = 0; i < BENCH_CT_FLOWS; i++) {
+		bench_host(&e, &edge);
+		bench_host(&t, &transit);
+		bench_host(&l, &legacy);
+		a = bench_rand();
+		b = bench_rand();
+		len = bench_frame(frames + 2 + 2 * i * 128, &t, &l, i % 2 ? IPPROTO_TCP : IPPROTO_UDP, -1, a, b);
+		parse_packet(&out[i], frames + 2 + 2 * i * 128, len);
+		memcpy(frames + 2 + 2 * i * 128 + 96, &e, sizeof(e));
+		len = bench_frame(frames + 2 + (2 * i + 1) * 128, &l, &t, i % 2 ? IPPROTO_TCP : IPPROTO_UDP, -1, b, a);
+		parse_packet(&in[i], frames + 2 + (2 * i + 1) * 128, len);
+	}
+
+	t0 = bench_now();
+	for(i = 0; i < BENCH_CT_FLOWS; i++)
+		ct_track(ct, &out[i], (struct in6_addr *)(out[i].data + 96));
+	printf("ct_track() new flow %.1f ns, %u flows\n", (bench_now() - t0) * 1e9 / BENCH_CT_FLOWS, ct->table->live);
+
+	t0 = bench_now();
+	for(i = 0; i < BENCH_CT_FLOWS; i++)
+		ct_track(ct, &out[i], (struct in6_addr *)(out[i].data + 96));
+	printf("ct_track() known flow %.1f ns\n", (bench_now() - t0) * 1e9 / BENCH_CT_FLOWS);
+
+	bad = 0;
+	t0 = bench_now();
+	for(i = 0; i < BENCH_CT_FLOWS; i++)
+		bad += 0 != ct_lookup(ct, &in[i], &found) || 0 != memcmp(&found, out[i].data + 96, sizeof(found));
+	printf("ct_lookup() reply %.1f ns\n", (bench_now() - t0) * 1e9 / BENCH_CT_FLOWS);
+	if(bad) {
+		printf("ct: %u replies not restored to their edge address\n", bad);
+		return 1;
+	}
+
+	// the same hosts from other ports are not the flow
+	for(i = 0; i < BENCH_CT_FLOWS; i++)
+		PKT_L4(&in[i])[0] ^= 0x80;
+	t0 = bench_now();
+	for(i = 0; i < BENCH_CT_FLOWS; i++)
+		bad += 0 == ct_lookup(ct, &in[i], &found);
+	printf("ct_lookup() unknown %.1f ns\n", (bench_now() - t0) * 1e9 / BENCH_CT_FLOWS);
+	if(bad) {
+		printf("ct: %u unknown replies found\n", bad);
+		return 1;
+	}
+
+	// UDP times out first, TCP after a SYN-less packet lives on
+	t0 = bench_now();
+	timers_run(now + (CT_TIMEOUT_UDP + 1) * 1000000ULL);
+	printf("timers_run() %u flows expired in %.1f ms, %u left\n", ct->expired, (bench_now() - t0) * 1e3, ct->table->live);
+	if(ct->table->live != BENCH_CT_FLOWS / 2) {
+		printf("ct: expected the %u TCP flows to stay\n", BENCH_CT_FLOWS / 2);
+		return 1;
+	}
+	timers_run(now + (CT_TIMEOUT_TCP + 1) * 1000000ULL);
+
+	// as many new flows again, over the expired slots
+	timers_run(now + (CT_TIMEOUT_TCP + 2) * 1000000ULL);
+	t0 = bench_now();
+	for(i = 0; i < BENCH_CT_FLOWS; i++) {
+		PKT_L4(&out[i])[1] ^= 0x80;
+		ct_track(ct, &out[i], (struct in6_addr *)(out[i].data + 96));
+	}
+	printf("ct_track() new flow over expired slots %.1f ns, %u flows, %u rebuilds\n",
+	       (bench_now() - t0) * 1e9 / BENCH_CT_FLOWS, ct->table->live, ct->rebuilds);
+	free_sixone_ct(ct);
+
+	// churn on a small table: rebuilds come back to back, one within CT_RETIRE_US of the last must wait
+	if(NULL == (ct = alloc_sixone_ct(BENCH_CT_CHURN))) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+	now += (CT_TIMEOUT_TCP + 2) * 1000000ULL;
+	for(r = 0; r < 16; r++) {
+		for(i = 0; i < BENCH_CT_CHURN; i++) {
+			PKT_L4(&out[i])[0] = r;
+			ct_track(ct, &out[i], (struct in6_addr *)(out[i].data + 96));
+		}
+		now += (CT_TIMEOUT_TCP + 1) * 1000000ULL;
+		timers_run(now);
+	}
+	printf("ct churn: %u flows tracked, %u untracked (full), %u rebuilds, %u put off\n",
+	       ct->created, ct->full, ct->rebuilds, ct->deferred);
+	if(0 == ct->rebuilds || 0 == ct->deferred) {
+		printf("ct: back to back rebuilds were not put off\n");
+		return 1;
+	}
+
+	free_sixone_ct(ct);
+	free(frames);
+	free(out);
+	free(in);
+	return 0;
+}
+
+/// @brief Timers bench_wheel() saw fire
+static u_int bench_fired;
+
+static void bench_fire(wheel_timer t, void *arg)
+{
+	bench_fired++;
+}
+
+/**
+ *  @brief Timer wheel: arm, cancel and expire BENCH_TIMERS timers spread over two hours of 10 ms ticks
+ */
+static int bench_wheel()
+{
+	struct wheel_timer_ *timers;
+	sixone_wheel w;
+	u_int i, expired;
+	u_int64_t span = 2 * 3600 * 1000000ULL;
+	double t0;
+
+	timers = calloc(BENCH_TIMERS, sizeof(*timers));
+	if(NULL == timers || NULL == (w = alloc_sixone_wheel(TIMER_TICK_US, 0))) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+
+	t0 = bench_now();
+	for(i = 0; i < BENCH_TIMERS; i++)
+		wheel_add(w, &timers[i], bench_rand() % span);
+	printf("wheel_add() %.1f ns\n", (bench_now() - t0) * 1e9 / BENCH_TIMERS);
+
+	t0 = bench_now();
+	for(i = 0; i < BENCH_TIMERS; i += 2)
+		wheel_del(w, &timers[i]);
+	printf("wheel_del() %.1f ns\n", (bench_now() - t0) * 1e9 / (BENCH_TIMERS / 2));
+
+	bench_fired = 0;
+	t0 = bench_now();
+	expired = wheel_advance(w, span, bench_fire, NULL);
+	printf("wheel_advance() %.1f ns per timer expired, %.1f ns per tick\n",
+	       (bench_now() - t0) * 1e9 / expired, (bench_now() - t0) * 1e9 / (span / TIMER_TICK_US));
+	if(expired != BENCH_TIMERS / 2 || bench_fired != expired || 0 != w->count) {
+		printf("wheel: %u of %u timers expired\n", expired, BENCH_TIMERS / 2);
+		return 1;
+	}
+
+	free_sixone_wheel(w);
+	free(timers);
+	return 0;
+}
+
+/**
+ *  @brief Packet Too Big: a flood from one /64 and from all over is held to the rates, and the messages check out
+ */
+static int bench_icmp()
+{
+	struct in6_addr src, flooder, legacy, s, d;
+	struct sixone_pkt_ pkt;
+	sixone_icmp icmp;
+	u_char *frame, buf[ICMP_ERROR_MAX];
+	u_int i, len, n, bad = 0;
+	u_int64_t now = 1000 * 1000000ULL;
+	double t0;
+
+	inet_pton(AF_INET6, "fd00:1::1", &src);
+	inet_pton(AF_INET6, "2001:db8:66::", &flooder);
+	inet_pton(AF_INET6, "2001:db8:99::", &legacy);
+	frame = calloc(1, 2 + 14 + 9000);
+	if(NULL == frame || NULL == (icmp = alloc_sixone_icmp(ICMP_RATE))) {
+		printf("Could not malloc()\n");
+		return 1;
+	}
+
+	// one source, a packet every microsecond, a burst and the rate may go out
+	bench_host(&s, &flooder);
+	bench_host(&d, &legacy);
+	len = bench_frame(frame + 2, &s, &d, IPPROTO_UDP, -1, 1, 2);
+	parse_packet(&pkt, frame + 2, len);
+	t0 = bench_now();
+	for(i = 0; i < BENCH_ICMP_PKTS; i++)
+		icmp_allow(icmp, &pkt, now + i);
+	printf("icmp_allow() one source %.1f ns, %u sent, %u limited\n",
+	       (bench_now() - t0) * 1e9 / BENCH_ICMP_PKTS, icmp->sent, icmp->limited + icmp->limited_all);
+	if(icmp->sent > ICMP_RATE + (u_int64_t)ICMP_RATE * BENCH_ICMP_PKTS / 1000000 + 1) {
+		printf("icmp: one source got %u errors in %.1f s\n", icmp->sent, BENCH_ICMP_PKTS / 1e6);
+		return 1;
+	}
+
+	// a new source per packet, the overall bucket holds
+	n = icmp->sent;
+	now += 10 * 1000000ULL;
+	t0 = bench_now();
+	for(i = 0; i < BENCH_ICMP_PKTS; i++) {
+		bench_host(&s, &flooder);
+		memcpy(s.s6_addr + 4, &i, sizeof(i));
+		memcpy(&PKT_IP6(&pkt)->ip6_src, &s, sizeof(s));
+		icmp_allow(icmp, &pkt, now + i);
+	}
+	printf("icmp_allow() new source each %.1f ns, %u sent, %u limited overall\n",
+	       (bench_now() - t0) * 1e9 / BENCH_ICMP_PKTS, icmp->sent - n, icmp->limited_all);
+	if(icmp->sent - n > ICMP_RATE_ALL + (u_int64_t)ICMP_RATE_ALL * BENCH_ICMP_PKTS / 1000000 + 1) {
+		printf("icmp: all sources got %u errors in %.1f s\n", icmp->sent - n, BENCH_ICMP_PKTS / 1e6);
+		return 1;
+	}
+
+	// a jumbo packet, the quote stops at the minimum MTU
+	PKT_IP6(&pkt)->ip6_plen = htons(9000 - sizeof(struct ip6_hdr));
+	parse_packet(&pkt, frame + 2, 14 + 9000);
+	t0 = bench_now();
+	for(i = 0; i < BENCH_ICMP_PKTS; i++)
+		len = icmp_packet_too_big(buf, &src, &pkt, 1500);
+	printf("icmp_packet_too_big() %.1f ns, %u bytes\n", (bench_now() - t0) * 1e9 / BENCH_ICMP_PKTS, len);
+	n = len - sizeof(struct ip6_hdr);
+	bad = ICMP_ERROR_MAX != len;
+	bad |= 0xffff != checksum(checksum(checksum(IPPROTO_ICMPV6, buf + 8, 32), buf + 4, 2), buf + 40, n);
+	if(bad) {
+		printf("icmp: Packet Too Big of %u bytes does not check out\n", len);
+		return 1;
+	}
+
+	free_sixone_icmp(icmp);
+	free(frame);
+	return 0;
+}
+
+static struct bench benches[] = {
+	{ "cksum", "Internet checksum kernels, 40 B - 9 KB", bench_cksum },
+	{ "policy", "weighted rendezvous multipath, 1 - 16 prefixes", bench_policy },
+	{ "load", "mapping file start up, old reader against load_mappings() + maptab_build()", bench_load },
+	{ "rewrite", "prefix splice per address, run time bit offset against per length kernels", bench_rewrite },
+	{ "rss", "symmetric worker dispatch hash, both directions of a flow on one worker", bench_rss },
+	{ "bpf", "capture filter programs against the packet classification, exact and coarsened", bench_bpf },
+	{ "wheel", "timer wheel arm, cancel and expiry at a million timers", bench_wheel },
+	{ "ct", "legacy flow tracking, setup and lookup at a million flows", bench_ct },
+	{ "icmp", "Packet Too Big rate limits against a flood, message build", bench_icmp },
+	{ NULL, NULL, NULL }
+};
+
+int main(int argc, char *argv[])
+{
+	int i, j, ret = 0, found;
+
+	for(i = 0; NULL != benches[i].name; i++) {
+		found = (1 == argc);
+		for(j = 1; j < argc; j++)
+			found |= (0 == strcmp(argv[j], benches[i].name));
+		if(!found)
+			continue;
+
+		printf("== %s: %s\n", benches[i].name, benches[i].descr);
+		ret |= benches[i].run();
+	}
+
+	for(j = 1; j < argc; j++) {
+		for(i = 0; NULL != benches[i].name; i++)
+			if(0 == strcmp(argv[j], benches[i].name))
+				break;
+		if(NULL == benches[i].name) {
+			printf("Unknown suite %s, available:", argv[j]);
+			for(i = 0; NULL != benches[i].name; i++)
+				printf(" %s", benches[i].name);
+			printf("\n");
+			return 2;
+		}
+	}
+	return ret;
+}
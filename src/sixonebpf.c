@@ -0,0 +1,635 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonebpf.c
+ *  @brief Six-One Router capture filter compiler
+ *  @date 2026-10-19
+ */
+
+#include "sixonebpf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/socket.h> // required by ip6.h
+#include <netinet/in.h> // required by ip6.h
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+#include <net/ethernet.h>
+
+// Ethernet headers are allways 14 bytes long
+#define SIZE_ETHERNET_HDR 14
+#define BPF_OFF_ETHERTYPE 12
+#define BPF_OFF_NXT (SIZE_ETHERNET_HDR + 6)
+#define BPF_OFF_SRC (SIZE_ETHERNET_HDR + 8)
+#define BPF_OFF_DST (SIZE_ETHERNET_HDR + 24)
+#define BPF_OFF_ICMP_TYPE (SIZE_ETHERNET_HDR + 40)
+
+/// @brief jt/jf are 8 bits, a pending conditional jump is bounced through a 'ja' before it gets this far
+#define BPF_JMP_REACH 250
+/// @brief Label meaning "the next instruction"
+#define LBL_NEXT -1
+/// @brief Linear compares are cheaper than another jgt level below this many leaves
+#define BPF_SEARCH_LINEAR 4
+
+/// @brief Errors inbound_error() maps back to the edge, dropped in the kernel on an interface without transit nets (sorted, below ignored_icmp6)
+static const u_int8_t error_icmp6[] = {
+	ICMP6_DST_UNREACH,
+	ICMP6_TIME_EXCEEDED,
+	ICMP6_PARAM_PROB,
+};
+
+/// @brief Dropped in the kernel, keep in sync with the ignored types in process_packet() (sorted)
+static const u_int8_t ignored_icmp6[] = {
+	ND_ROUTER_SOLICIT,
+	ND_ROUTER_ADVERT,
+	ND_NEIGHBOR_SOLICIT,
+	ND_NEIGHBOR_ADVERT,
+	ND_REDIRECT,
+};
+
+/**
+ * @brief A prefix as the filter sees it: four host order words, masked to len
+ */
+struct bpf_pfx {
+	u_int32_t w[4];
+	int len;
+};
+
+/**
+ * @brief One compare on the current address word, either a match or the way into a longer group
+ */
+struct bpf_leaf {
+	u_int32_t val;
+	int label;
+};
+
+struct bpf_fixup {
+	u_int at;     /// instruction to patch
+	int label;
+	int cond;     /// 1 = jt, 2 = jf, 0 = k of a 'ja'
+};
+
+/**
+ * @brief Instruction buffer with forward labels
+ */
+struct bpf_asm {
+	struct bpf_insn *insn;
+	u_int len, cap;
+	int *label;             /// position of each label, -1 until placed
+	u_int label_c, label_cap;
+	struct bpf_fixup *fix;  /// references to labels not placed yet
+	u_int fix_c, fix_cap;
+	int oom;
+};
+
+static void *grow(void *p, u_int *cap, u_int need, size_t size, int *oom)
+{
+	u_int n;
+	void *q;
+
+	if(need <= *cap)
+		return p;
+	n = *cap ? *cap * 2 : 64;
+	while(n < need)
+		n *= 2;
+	q = realloc(p, n * size);
+	if(NULL == q) {
+		*oom = 1;
+		return p;
+	}
+	*cap = n;
+	return q;
+}
+
+static int new_label(struct bpf_asm *a)
+{
+	a->label = grow(a->label, &a->label_cap, a->label_c + 1, sizeof(int), &a->oom);
+	if(a->oom)
+		return LBL_NEXT;
+	a->label[a->label_c] = -1;
+	return a->label_c++;
+}
+
+static void add_fixup(struct bpf_asm *a, u_int at, int label, int cond)
+{
+	a->fix = grow(a->fix, &a->fix_cap, a->fix_c + 1, sizeof(*a->fix), &a->oom);
+	if(a->oom)
+		return;
+	a->fix[a->fix_c].at = at;
+	a->fix[a->fix_c].label = label;
+	a->fix[a->fix_c].cond = cond;
+	a->fix_c++;
+}
+
+static void patch(struct bpf_asm *a, struct bpf_fixup *f, u_int pos)
+{
+	u_int off = pos - f->at - 1;
+
+	switch(f->cond) {
+	case 1: a->insn[f->at].jt = off; break;
+	case 2: a->insn[f->at].jf = off; break;
+	default: a->insn[f->at].k = off;
+	}
+}
+
+static void place(struct bpf_asm *a, int label)
+{
+	u_int i = 0;
+
+	if(a->oom)
+		return;
+	a->label[label] = a->len;
+	while(i < a->fix_c) {
+		if(a->fix[i].label == label) {
+			patch(a, &a->fix[i], a->len);
+			a->fix[i] = a->fix[--a->fix_c];
+		}
+		else
+			i++;
+	}
+}
+
+static void put(struct bpf_asm *a, u_short code, u_int k, int jt, int jf)
+{
+	struct bpf_insn *in;
+
+	a->insn = grow(a->insn, &a->cap, a->len + 1, sizeof(*a->insn), &a->oom);
+	if(a->oom)
+		return;
+	in = &a->insn[a->len];
+	in->code = code;
+	in->jt = in->jf = 0;
+	in->k = k;
+	if(BPF_JMP == BPF_CLASS(code) && BPF_JA != (code & 0xf0)) {
+		if(LBL_NEXT != jt)
+			add_fixup(a, a->len, jt, 1);
+		if(LBL_NEXT != jf)
+			add_fixup(a, a->len, jf, 2);
+	}
+	a->len++;
+}
+
+/**
+ *  @brief Bounces every pending conditional jump through a 'ja' once the oldest gets close to its reach
+ */
+static void bounce(struct bpf_asm *a)
+{
+	u_int i, j, oldest = a->len, pending = 0, tramp;
+	int skip;
+
+	for(i = 0; i < a->fix_c; i++) {
+		if(a->fix[i].cond) {
+			pending++;
+			if(a->fix[i].at < oldest)
+				oldest = a->fix[i].at;
+		}
+	}
+	if(0 == pending || a->len + pending - oldest < BPF_JMP_REACH)
+		return;
+
+	skip = new_label(a);
+	put(a, BPF_JMP|BPF_JA, 0, LBL_NEXT, LBL_NEXT);
+	add_fixup(a, a->len - 1, skip, 0);
+	tramp = a->len;
+
+	for(i = 0; !a->oom && i < a->fix_c; i++) {
+		if(!a->fix[i].cond)
+			continue;
+		// one trampoline per label, everything pending for it lands there
+		for(j = 0; j < i; j++)
+			if(0 == a->fix[j].cond && a->fix[j].label == a->fix[i].label && a->fix[j].at >= tramp)
+				break;
+		if(j == i) {
+			put(a, BPF_JMP|BPF_JA, 0, LBL_NEXT, LBL_NEXT);
+			patch(a, &a->fix[i], a->len - 1);
+			a->fix[i].at = a->len - 1;
+			a->fix[i].cond = 0;
+		}
+		else {
+			patch(a, &a->fix[i], a->fix[j].at);
+			a->fix[i] = a->fix[--a->fix_c];
+			i--;
+		}
+	}
+	place(a, skip);
+}
+
+static void emit(struct bpf_asm *a, u_short code, u_int k)
+{
+	bounce(a);
+	put(a, code, k, LBL_NEXT, LBL_NEXT);
+}
+
+static void emit_jmp(struct bpf_asm *a, u_short code, u_int k, int jt, int jf)
+{
+	bounce(a);
+	if(BPF_JA == (code & 0xf0)) {
+		put(a, code, 0, LBL_NEXT, LBL_NEXT);
+		add_fixup(a, a->len - 1, jt, 0);
+	}
+	else
+		put(a, code, k, jt, jf);
+}
+
+static u_int32_t word_mask(int len, int w)
+{
+	int bits = len - 32 * w;
+
+	if(bits <= 0)
+		return 0;
+	if(bits >= 32)
+		return 0xffffffff;
+	return 0xffffffff << (32 - bits);
+}
+
+static void mask_pfx(struct bpf_pfx *p)
+{
+	int w;
+
+	for(w = 0; w < 4; w++)
+		p->w[w] &= word_mask(p->len, w);
+}
+
+static int cmp_pfx(const void *x, const void *y)
+{
+	const struct bpf_pfx *a = x, *b = y;
+	int w;
+
+	for(w = 0; w < 4; w++)
+		if(a->w[w] != b->w[w])
+			return a->w[w] < b->w[w] ? -1 : 1;
+	return a->len - b->len;
+}
+
+/// @brief a covers b (or is b)
+static int covers(struct bpf_pfx *a, struct bpf_pfx *b)
+{
+	int w;
+
+	if(a->len > b->len)
+		return 0;
+	for(w = 0; w < 4; w++)
+		if((b->w[w] & word_mask(a->len, w)) != a->w[w])
+			return 0;
+	return 1;
+}
+
+/// @brief a and b are the two halves of one prefix
+static int siblings(struct bpf_pfx *a, struct bpf_pfx *b)
+{
+	int w;
+
+	if(a->len != b->len || 0 == a->len)
+		return 0;
+	for(w = 0; w < 4; w++)
+		if((a->w[w] & word_mask(a->len - 1, w)) != (b->w[w] & word_mask(a->len - 1, w)))
+			return 0;
+	return 1;
+}
+
+/**
+ *  @brief Shortens the prefixes to at most lmax bits, sorts them, and drops/merges the redundant ones
+ *  @return The new number of prefixes in v
+ */
+static u_int normalize(struct bpf_pfx *v, u_int n, int lmax)
+{
+	u_int i, top = 0;
+
+	for(i = 0; i < n; i++) {
+		if(v[i].len > lmax)
+			v[i].len = lmax;
+		mask_pfx(&v[i]);
+	}
+	qsort(v, n, sizeof(*v), cmp_pfx);
+
+	// v is sorted, so anything covered comes right after what covers it and siblings end up next to each other
+	for(i = 0; i < n; i++) {
+		if(top > 0 && covers(&v[top - 1], &v[i]))
+			continue;
+		v[top++] = v[i];
+		while(top > 1 && siblings(&v[top - 2], &v[top - 1])) {
+			top--;
+			v[top - 1].len--;
+			mask_pfx(&v[top - 1]);
+		}
+	}
+	return top;
+}
+
+/**
+ *  @brief Binary search (jgt) down to short runs of jeq over the leaves, A holds the word
+ */
+static void emit_search(struct bpf_asm *a, struct bpf_leaf *leaf, u_int n, int miss)
+{
+	u_int i, mid;
+	int right;
+
+	if(n <= BPF_SEARCH_LINEAR) {
+		for(i = 0; i + 1 < n; i++)
+			emit_jmp(a, BPF_JMP|BPF_JEQ|BPF_K, leaf[i].val, leaf[i].label, LBL_NEXT);
+		emit_jmp(a, BPF_JMP|BPF_JEQ|BPF_K, leaf[n - 1].val, leaf[n - 1].label, miss);
+		return;
+	}
+
+	mid = n / 2;
+	right = new_label(a);
+	emit_jmp(a, BPF_JMP|BPF_JGT|BPF_K, leaf[mid - 1].val, right, LBL_NEXT);
+	emit_search(a, leaf, mid, miss);
+	place(a, right);
+	emit_search(a, leaf + mid, n - mid, miss);
+}
+
+/**
+ *  @brief Emits "address at off is in v", one level per 32 bit word
+ *
+ *  All of v agree on the words before w and are longer than 32*w bits.
+ *  Exact word values (whole prefixes ending on this word, or the way into
+ *  longer ones) are searched, prefixes ending inside the word are masked
+ *  and searched once per prefix length.
+ *  @param v Normalized prefixes, see normalize()
+ *  @param lt Where to go if the address is in v
+ *  @param lf Where to go if it is not
+ */
+static void emit_set(struct bpf_asm *a, struct bpf_pfx *v, u_int n, u_int off, int w, int lt, int lf)
+{
+	struct bpf_leaf *leaf, *part;
+	u_int i, j, leaf_c = 0, part_c, *group;
+	u_int32_t lens = 0;
+	int len, next, first = 1;
+
+	if(0 == n) {
+		emit_jmp(a, BPF_JMP|BPF_JA, 0, lf, LBL_NEXT);
+		return;
+	}
+	if(0 == v[0].len) {
+		emit_jmp(a, BPF_JMP|BPF_JA, 0, lt, LBL_NEXT);
+		return;
+	}
+
+	leaf = malloc(n * sizeof(*leaf));
+	part = malloc(n * sizeof(*part));
+	group = malloc((n + 1) * sizeof(*group));
+	if(NULL == leaf || NULL == part || NULL == group) {
+		a->oom = 1;
+		goto out;
+	}
+
+	for(i = 0; i < n; i = j) {
+		j = i + 1;
+		if(v[i].len < 32 * (w + 1)) {
+			lens |= 1u << (v[i].len - 32 * w);
+			continue;
+		}
+		leaf[leaf_c].val = v[i].w[w];
+		if(v[i].len == 32 * (w + 1))
+			leaf[leaf_c].label = lt;
+		else {
+			while(j < n && v[j].len > 32 * (w + 1) && v[j].w[w] == v[i].w[w])
+				j++;
+			leaf[leaf_c].label = new_label(a);
+		}
+		group[leaf_c++] = i;
+	}
+	group[leaf_c] = n;
+
+	emit(a, BPF_LD|BPF_W|BPF_ABS, off + 4 * w);
+	// the masks clobber A, keep the word in X
+	if((lens & (lens - 1)) || (lens && leaf_c))
+		emit(a, BPF_MISC|BPF_TAX, 0);
+
+	next = lens ? new_label(a) : lf;
+	if(leaf_c > 0)
+		emit_search(a, leaf, leaf_c, next);
+
+	for(len = 32 * w + 1; lens && len < 32 * (w + 1); len++) {
+		if(!(lens & (1u << (len - 32 * w))))
+			continue;
+		place(a, next);
+		lens &= ~(1u << (len - 32 * w));
+		next = lens ? new_label(a) : lf;
+
+		// v is sorted, so the values of one length come out sorted too
+		for(i = part_c = 0; i < n; i++) {
+			if(v[i].len != len)
+				continue;
+			part[part_c].val = v[i].w[w];
+			part[part_c++].label = lt;
+		}
+		if(!first || leaf_c > 0)
+			emit(a, BPF_MISC|BPF_TXA, 0);
+		first = 0;
+		emit(a, BPF_ALU|BPF_AND|BPF_K, word_mask(len, w));
+		emit_search(a, part, part_c, next);
+	}
+
+	for(i = 0; i < leaf_c; i++) {
+		if(leaf[i].label == lt)
+			continue;
+		// the group runs up to the next leaf or partial
+		for(j = group[i] + 1; j < n && v[j].len > 32 * (w + 1) && v[j].w[w] == v[group[i]].w[w]; j++)
+			;
+		place(a, leaf[i].label);
+		emit_set(a, v + group[i], j - group[i], off, w + 1, lt, lf);
+	}
+
+ out:
+	free(leaf);
+	free(part);
+	free(group);
+}
+
+/**
+ * @brief The prefix sets of one interface's filter
+ */
+struct bpf_sets {
+	struct bpf_pfx *own;     /// the interface's configured addresses, never captured as source
+	struct bpf_pfx *src;     /// the interface's edge nets
+	struct bpf_pfx *transit; /// every transit net
+	u_int own_c, src_c, transit_c;
+};
+
+static void to_pfx(struct bpf_pfx *p, struct in6_addr *ip, int len)
+{
+	int w;
+
+	for(w = 0; w < 4; w++)
+		p->w[w] = ((u_int32_t)ip->s6_addr[4*w] << 24) | (ip->s6_addr[4*w + 1] << 16) |
+			(ip->s6_addr[4*w + 2] << 8) | ip->s6_addr[4*w + 3];
+	p->len = len;
+	mask_pfx(p);
+}
+
+static int collect(struct bpf_sets *s, sixone_settings settings, sixone_if dev)
+{
+	u_int i, j, n = 0;
+	sixone_net net;
+
+	for(i = 0; i < settings->if_c; i++)
+		n += settings->if_v[i]->net_c;
+
+	memset(s, 0, sizeof(*s));
+	s->own = malloc((dev->net_c + 1) * sizeof(struct bpf_pfx));
+	s->src = malloc((dev->net_c + 1) * sizeof(struct bpf_pfx));
+	s->transit = malloc((n + 1) * sizeof(struct bpf_pfx));
+	if(NULL == s->own || NULL == s->src || NULL == s->transit)
+		return -1;
+
+	for(i = 0; i < settings->if_c; i++) {
+		for(j = 0; j < settings->if_v[i]->net_c; j++) {
+			net = settings->if_v[i]->net_v[j];
+			if(!net->edge)
+				to_pfx(&s->transit[s->transit_c++], &net->addr->ip, net->addr->pfx);
+		}
+	}
+	for(j = 0; j < dev->net_c; j++) {
+		net = dev->net_v[j];
+		to_pfx(&s->own[s->own_c++], &net->addr->ip, 128);
+		if(net->edge)
+			to_pfx(&s->src[s->src_c++], &net->addr->ip, net->addr->pfx);
+	}
+	return 0;
+}
+
+static void free_sets(struct bpf_sets *s)
+{
+	free(s->own);
+	free(s->src);
+	free(s->transit);
+}
+
+/**
+ *  @brief Lays out the whole program
+ *  @param exact 2 = everything, 1 = without the own address clause, 0 = also without "dst not on this link"
+ */
+static void assemble(struct bpf_asm *a, struct bpf_sets *s, int has_transit, int exact)
+{
+	int drop = new_label(a), accept = new_label(a), filter = new_label(a);
+	int edge = new_label(a), out = new_label(a), transit = new_label(a);
+	u_int i, leaf_c = 0;
+	struct bpf_leaf leaf[sizeof(error_icmp6) + sizeof(ignored_icmp6)];
+
+	emit(a, BPF_LD|BPF_H|BPF_ABS, BPF_OFF_ETHERTYPE);
+	emit_jmp(a, BPF_JMP|BPF_JEQ|BPF_K, ETHERTYPE_IPV6, LBL_NEXT, drop);
+
+	// ICMPv6 right after the IPv6 header, anything behind extension headers is left to got_packet()
+	emit(a, BPF_LD|BPF_B|BPF_ABS, BPF_OFF_NXT);
+	emit_jmp(a, BPF_JMP|BPF_JEQ|BPF_K, IPPROTO_ICMPV6, LBL_NEXT, filter);
+	emit(a, BPF_LD|BPF_B|BPF_ABS, BPF_OFF_ICMP_TYPE);
+	for(i = 0; !has_transit && i < sizeof(error_icmp6); i++) {
+		leaf[leaf_c].val = error_icmp6[i];
+		leaf[leaf_c++].label = drop;
+	}
+	for(i = 0; i < sizeof(ignored_icmp6); i++) {
+		leaf[leaf_c].val = ignored_icmp6[i];
+		leaf[leaf_c++].label = drop;
+	}
+	emit_search(a, leaf, leaf_c, filter);
+
+	place(a, filter);
+	if(exact > 1 && s->own_c)
+		emit_set(a, s->own, s->own_c, BPF_OFF_SRC, 0, drop, edge);
+	place(a, edge);
+
+	// edge role: from one of our edge nets, to anywhere but the same link (outbound or hairpin)
+	if(s->src_c) {
+		emit_set(a, s->src, s->src_c, BPF_OFF_SRC, 0, out, transit);
+		place(a, out);
+		// src is only exact while exact is, a coarsened set would drop what it must not
+		if(exact)
+			emit_set(a, s->src, s->src_c, BPF_OFF_DST, 0, drop, accept);
+		else
+			emit_jmp(a, BPF_JMP|BPF_JA, 0, accept, LBL_NEXT);
+	}
+	place(a, transit);
+
+	// transit role: to any of our transit nets
+	if(has_transit && s->transit_c)
+		emit_set(a, s->transit, s->transit_c, BPF_OFF_DST, 0, accept, drop);
+
+	place(a, drop);
+	emit(a, BPF_RET|BPF_K, 0);
+	place(a, accept);
+	emit(a, BPF_RET|BPF_K, (u_int)-1);
+}
+
+int build_filter(sixone_settings settings, sixone_if dev, struct bpf_program *prog)
+{
+	struct bpf_sets s;
+	struct bpf_asm a;
+	int lmax = 128, exact = 2, has_transit = 0;
+	u_int j;
+
+	memset(prog, 0, sizeof(*prog));
+	if(0 != collect(&s, settings, dev)) {
+		free_sets(&s);
+		return -1;
+	}
+	for(j = 0; j < dev->net_c; j++)
+		if(!dev->net_v[j]->edge)
+			has_transit = 1;
+
+	s.own_c = normalize(s.own, s.own_c, 128);
+
+	for(;;) {
+		memset(&a, 0, sizeof(a));
+		s.src_c = normalize(s.src, s.src_c, lmax);
+		s.transit_c = normalize(s.transit, s.transit_c, lmax);
+		// every prefix costs at least one instruction, don't bother assembling what can't fit
+		if(s.src_c + s.transit_c > SIXONE_BPF_MAXINSNS && lmax > 0) {
+			lmax = lmax > 8 ? lmax - 8 : 0;
+			exact = 0;
+			continue;
+		}
+		assemble(&a, &s, has_transit, exact);
+
+		if(a.oom || a.len <= SIXONE_BPF_MAXINSNS || 0 == lmax)
+			break;
+
+		// too big, let a superset through and have got_packet() sort it out
+		free(a.insn);
+		free(a.label);
+		free(a.fix);
+		if(exact)
+			exact--;
+		else
+			lmax = lmax > 8 ? lmax - 8 : 0;
+	}
+
+	free(a.label);
+	free(a.fix);
+	free_sets(&s);
+	if(a.oom) {
+		free(a.insn);
+		return -1;
+	}
+	prog->bf_len = a.len;
+	prog->bf_insns = a.insn;
+	return 0;
+}
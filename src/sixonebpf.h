@@ -0,0 +1,65 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonebpf.h
+ *  @brief Six-One Router capture filter compiler
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONEBPF_H
+#define SIXONEBPF_H
+
+#include <pcap.h>
+
+#include "sixonetypes.h"
+
+/// @brief Largest program the FreeBSD kernel accepts (sys/net/bpf.h), libpcap's own limit is larger
+#define SIXONE_BPF_MAXINSNS 512
+
+/**
+ *  @brief Builds the capture filter for one interface directly as cBPF.
+ *
+ *  The program only holds the clauses of the interface's role(s):
+ *  @li edge: src in one of the interface's edge nets and dst in none of them (outbound, or hairpinned to another interface's edge net)
+ *  @li transit: dst in any transit net (inbound)
+ *
+ *  Non-IPv6 frames and the ICMPv6 types process_packet() ignores are dropped
+ *  in the kernel: neighbour discovery everywhere, and the errors that
+ *  inbound_error() maps back to the edge on an interface without transit
+ *  nets, it only takes them from transit. The prefix sets are aggregated and emitted as a decision tree
+ *  on the address words. If the result does not fit in SIXONE_BPF_MAXINSNS
+ *  the prefixes are coarsened, the filter then lets through a superset and
+ *  got_packet() sorts out the rest.
+ *  @param settings The settings to take the nets from
+ *  @param dev The interface the filter is for
+ *  @param prog Filled in with a malloc()ed program, release with pcap_freecode()
+ *  @return 0 on success, -1 if out of memory
+ */
+int build_filter(sixone_settings settings, sixone_if dev, struct bpf_program *prog);
+
+#endif // SIXONEBPF_H
@@ -0,0 +1,304 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonecksum.c
+ *  @brief Six-One Router Internet checksum (RFC 1071) routines
+ *  @date 2026-10-19
+ *
+ *  The one's complement sum is byte order independent (RFC 1071, 2.B), so the
+ *  kernels add native order 32 bit words into 64 bit accumulators and only the
+ *  final fold swaps bytes. This leaves no carry handling in the inner loops.
+ */
+
+#include "sixonecksum.h"
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIXONE_CKSUM_X86 1
+#include <immintrin.h>
+#endif
+
+/// @brief Below this many bytes the vector setup costs more than it saves, checksum() stays scalar
+#define CKSUM_SIMD_MIN 128
+
+/// @brief Kernel used by checksum(), selected on first use
+static cksum_fn cksum_kernel;
+static const char *cksum_kernel_name;
+/// @brief The workers checksum at once, the first call picks the kernel for all of them
+static pthread_once_t cksum_once = PTHREAD_ONCE_INIT;
+
+u_int16_t cksum_fold(u_int64_t sum)
+{
+	u_int16_t ret;
+
+	sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+	sum = (sum & 0xFFFFFFFFULL) + (sum >> 32);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	ret = sum;
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+	ret = (ret << 8) | (ret >> 8);
+#endif
+	return ret;
+}
+
+/**
+ *  @brief Sums the last (less than 8) bytes, zero padded
+ */
+static u_int64_t cksum_tail(const u_char *p, u_int len)
+{
+	u_int32_t w[2] = { 0, 0 };
+
+	memcpy(w, p, len);
+	return (u_int64_t)w[0] + w[1];
+}
+
+u_int64_t cksum_partial_scalar(const void *_p, u_int len)
+{
+	const u_char *p = _p;
+	u_int64_t s0 = 0, s1 = 0;
+	u_int32_t w[4];
+
+	while(len >= 16) {
+		memcpy(w, p, 16);
+		s0 += (u_int64_t)w[0] + w[1];
+		s1 += (u_int64_t)w[2] + w[3];
+		p += 16;
+		len -= 16;
+	}
+	while(len >= 8) {
+		memcpy(w, p, 8);
+		s0 += (u_int64_t)w[0] + w[1];
+		p += 8;
+		len -= 8;
+	}
+	return s0 + s1 + cksum_tail(p, len);
+}
+
+#ifdef SIXONE_CKSUM_X86
+
+__attribute__((target("sse2")))
+static u_int64_t cksum_sse2(const void *_p, u_int len)
+{
+	const u_char *p = _p;
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc0 = zero, acc1 = zero, v;
+	u_int64_t lanes[2];
+
+	while(len >= 32) {
+		v = _mm_loadu_si128((const __m128i *)p);
+		acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+		acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+		v = _mm_loadu_si128((const __m128i *)(p + 16));
+		acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+		acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+		p += 32;
+		len -= 32;
+	}
+	_mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+
+	return lanes[0] + lanes[1] + cksum_partial_scalar(p, len);
+}
+
+__attribute__((target("avx2")))
+static u_int64_t cksum_avx2(const void *_p, u_int len)
+{
+	const u_char *p = _p;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = zero, acc1 = zero, v;
+	u_int64_t lanes[4];
+
+	while(len >= 64) {
+		v = _mm256_loadu_si256((const __m256i *)p);
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+		v = _mm256_loadu_si256((const __m256i *)(p + 32));
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+		p += 64;
+		len -= 64;
+	}
+	_mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + cksum_sse2(p, len);
+}
+
+cksum_fn cksum_partial_sse2 = cksum_sse2;
+cksum_fn cksum_partial_avx2 = cksum_avx2;
+
+#else
+
+cksum_fn cksum_partial_sse2 = NULL;
+cksum_fn cksum_partial_avx2 = NULL;
+
+#endif
+
+cksum_fn cksum_impl(const char *name)
+{
+	if(0 == strcmp(name, "scalar"))
+		return cksum_partial_scalar;
+#ifdef SIXONE_CKSUM_X86
+	__builtin_cpu_init();
+	if(0 == strcmp(name, "sse2") && __builtin_cpu_supports("sse2"))
+		return cksum_partial_sse2;
+	if(0 == strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+		return cksum_partial_avx2;
+#endif
+	return NULL;
+}
+
+int cksum_select(const char *name)
+{
+	static const char *order[] = { "avx2", "sse2", "scalar", NULL };
+	cksum_fn fn;
+	int i;
+
+	if(NULL != name) {
+		if(NULL == (fn = cksum_impl(name)))
+			return -1;
+		cksum_kernel_name = name;
+		cksum_kernel = fn;
+		return 0;
+	}
+
+	for(i = 0; NULL != order[i]; i++) {
+		if(NULL != (fn = cksum_impl(order[i]))) {
+			cksum_kernel_name = order[i];
+			cksum_kernel = fn;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/**
+ *  @brief The fastest kernel the CPU has, unless cksum_select() picked one already
+ */
+static void cksum_default()
+{
+	if(NULL == cksum_kernel)
+		cksum_select(NULL);
+}
+
+const char *cksum_selected()
+{
+	pthread_once(&cksum_once, cksum_default);
+	return cksum_kernel_name;
+}
+
+u_int16_t
+checksum(u_int16_t sum, const void *_p, u_int16_t len)
+{
+	u_int16_t t;
+
+	pthread_once(&cksum_once, cksum_default);
+
+	if(len < CKSUM_SIMD_MIN)
+		t = cksum_fold(cksum_partial_scalar(_p, len));
+	else
+		t = cksum_fold(cksum_kernel(_p, len));
+	sum += t;
+	if (sum < t) sum++;
+	return sum;
+}
+
+u_int16_t
+checksum_ref(u_int16_t sum, const void *_p, u_int16_t len)
+{
+	u_int16_t t;
+	const u_int8_t *p = _p;
+	const u_int8_t *end = p + len;
+
+	while(p < (end-1)) {
+		t = (p[0] << 8) + p[1];
+		sum += t;
+		if (sum < t) sum++;
+		p += 2;
+	}
+	if(p < end) {
+		t = (p[0] << 8) + 0;
+		sum += t;
+		if (sum < t) sum++;
+	}
+	return sum;
+}
+
+u_int16_t incksum16(const void *_p) {
+
+	const uint64_t *p = _p;
+	uint64_t s;
+	uint32_t u, v;
+	uint16_t x, y;
+	s = p[0];
+	s += p[1];
+	if (s < p[1]) s++;
+
+	v = s >> 32;
+	u = s;
+
+	u += v;
+	if (u < v) u++;
+
+	x = u >> 16;
+	y = u;
+
+	x += y;
+	if (x < y) x++;
+
+	return x;
+}
+
+u_int16_t cksum_update_word(u_int16_t cksum, u_int16_t prev, u_int16_t word)
+{
+	u_int32_t sum = (u_int16_t)~cksum;
+
+	sum += (u_int16_t)~prev;
+	sum += word;
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return ~sum;
+}
+
+u_int16_t cksum_update16(u_int16_t cksum, const void *prev, const void *addr)
+{
+	// HC' = ~(~HC + ~m + m'), all in native order words
+	u_int32_t sum = (u_int16_t)~cksum;
+
+	sum += (u_int16_t)~incksum16(prev);
+	sum += incksum16(addr);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return ~sum;
+}
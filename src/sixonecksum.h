@@ -0,0 +1,121 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonecksum.h
+ *  @brief Six-One Router Internet checksum (RFC 1071) routines
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONECKSUM_H
+#define SIXONECKSUM_H
+
+#include <sys/types.h>
+
+/**
+ *  @brief An one's complement summing kernel.
+ *
+ *  Sums len bytes at p as native order 32 bit words into a 64 bit accumulator,
+ *  without folding. An odd trailing byte is summed as if followed by a zero byte.
+ *  @param p The data (no alignment requirements)
+ *  @param len Number of bytes
+ *  @return The unfolded sum, see cksum_fold()
+ */
+typedef u_int64_t (*cksum_fn)(const void *p, u_int len);
+
+/**
+ *  @brief Folds an unfolded native order sum into a 16 bit sum of the big endian words (host order)
+ *  @param sum Value returned by a cksum_fn
+ *  @return The 16 bit one's complement sum
+ */
+u_int16_t cksum_fold(u_int64_t sum);
+
+/// @brief Portable kernel, 32 bit loads into a 64 bit accumulator
+u_int64_t cksum_partial_scalar(const void *p, u_int len);
+/// @brief SSE2 kernel (NULL on non-x86 builds, see cksum_impl())
+extern cksum_fn cksum_partial_sse2;
+/// @brief AVX2 kernel (NULL on non-x86 builds, see cksum_impl())
+extern cksum_fn cksum_partial_avx2;
+
+/**
+ *  @brief Look up a kernel by name
+ *  @param name "scalar", "sse2" or "avx2"
+ *  @return The kernel, NULL if it is not compiled in or not supported by this cpu
+ */
+cksum_fn cksum_impl(const char *name);
+
+/**
+ *  @brief Selects the kernel checksum() uses
+ *  @param name Kernel name (see cksum_impl()), NULL to pick the fastest the cpu supports
+ *  @return 0 on success, -1 if the kernel is not available
+ */
+int cksum_select(const char *name);
+
+/**
+ *  @brief Name of the kernel checksum() currently uses
+ */
+const char *cksum_selected();
+
+/**
+ *  @brief One's complement sum of the big endian 16 bit words in _p.
+ *  The kernel is picked on first use, see cksum_select(), short buffers always use the scalar one.
+ *  @param sum Sum to continue from (e.g. the next header value of a pseudo header)
+ *  @param _p The data
+ *  @param len Number of bytes, if odd the last byte is padded with zero
+ *  @return sum + the sum of _p (host order, not complemented)
+ */
+u_int16_t checksum(u_int16_t sum, const void *_p, u_int16_t len);
+
+/**
+ *  @brief Reference implementation of checksum(), folds 16 bits at a time.
+ *  Kept for verification and benchmarks.
+ */
+u_int16_t checksum_ref(u_int16_t sum, const void *_p, u_int16_t len);
+
+/**
+ * @brief Internet checksum of an IPv6 address (16 bytes) in network byte order.
+ */
+u_int16_t incksum16(const void *_p);
+
+/**
+ *  @brief Incremental checksum update (RFC 1624, eqn. 3) for a rewritten IPv6 address
+ *  @param cksum The checksum field as found in the packet (network byte order)
+ *  @param prev The address before the rewrite
+ *  @param addr The address after the rewrite
+ *  @return The checksum field to write back (network byte order)
+ */
+u_int16_t cksum_update16(u_int16_t cksum, const void *prev, const void *addr);
+
+/**
+ *  @brief Incremental checksum update (RFC 1624, eqn. 3) for one rewritten 16 bit word
+ *  @param cksum The checksum field as found in the packet
+ *  @param prev The word before the rewrite, in the same byte order
+ *  @param word The word after the rewrite
+ *  @return The checksum field to write back
+ */
+u_int16_t cksum_update_word(u_int16_t cksum, u_int16_t prev, u_int16_t word);
+
+#endif
@@ -0,0 +1,403 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonect.c
+ *  @brief Six-One Router connection tracking for legacy flows
+ *  @date 2026-10-19
+ */
+
+#include "sixonect.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+
+sixone_ct global_ct;
+
+/// @brief TCP flags that make a flow transitory
+#define CT_TCP_TRANS (0x01 | 0x02 | 0x04) // FIN, SYN, RST
+
+/**
+ *  @brief The clock a retired table is kept by (us)
+ *
+ *  Not timers_now(): a replay runs that by the packet timestamps, far
+ *  faster than the lookups still probing a table take.
+ */
+static u_int64_t ct_now_us()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ *  @brief Builds the key of pkt
+ *  @param out 1 if we are the source of pkt (outbound), 0 if we are its destination
+ *  @return The idle timeout of the flow (s)
+ */
+static u_int ct_key_of(sixone_pkt pkt, int out, struct ct_key *key)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	const u_char *l4 = PKT_L4(pkt);
+	u_int16_t p[2] = {0, 0};
+	u_int timeout = CT_TIMEOUT_OTHER;
+
+	if(0 != pkt->l4_off) {
+		switch(pkt->proto) {
+		case IPPROTO_TCP:
+			memcpy(p, l4, sizeof(p));
+			timeout = (l4[13] & CT_TCP_TRANS) ? CT_TIMEOUT_TCP_TRANS : CT_TIMEOUT_TCP;
+			break;
+		case IPPROTO_UDP:
+			memcpy(p, l4, sizeof(p));
+			timeout = CT_TIMEOUT_UDP;
+			break;
+		case IPPROTO_ICMPV6:
+			// the identifier is the same both ways, keep it in the local half
+			if((ICMP6_ECHO_REQUEST == pkt->icmp_type || ICMP6_ECHO_REPLY == pkt->icmp_type)
+			   && PKT_L4_LEN(pkt) >= sizeof(struct icmp6_hdr))
+				memcpy(&p[out ? 0 : 1], l4 + 4, sizeof(p[0]));
+			break;
+		}
+	}
+
+	key->local = out ? ip->ip6_src : ip->ip6_dst;
+	key->remote = out ? ip->ip6_dst : ip->ip6_src;
+	key->lport = out ? p[0] : p[1];
+	key->rport = out ? p[1] : p[0];
+	key->proto = pkt->proto;
+	return timeout;
+}
+
+/**
+ *  @brief Hashes a key
+ */
+static u_int32_t ct_hash(const struct ct_key *key)
+{
+	u_int32_t w[sizeof(*key) / 4], h = 0;
+	u_int i;
+
+	memcpy(w, key, sizeof(w));
+	for(i = 0; i < sizeof(w) / sizeof(w[0]); i++)
+		h = pkt_hash_mix(h, w[i]);
+	return h;
+}
+
+/**
+ *  @brief Allocates an empty table of slots slots (a power of two)
+ */
+static ct_table alloc_ct_table(u_int slots)
+{
+	ct_table t = calloc(1, sizeof(struct ct_table_) + (size_t)slots * sizeof(struct ct_entry_));
+
+	if(NULL != t)
+		t->mask = slots - 1;
+	return t;
+}
+
+/**
+ *  @brief Starts writing e, lookups retry until ct_write_end()
+ */
+static void ct_write_begin(ct_entry e)
+{
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void ct_write_end(ct_entry e)
+{
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  @brief Probes t for key without locking
+ *  @param edge Set to the edge address of the flow
+ *  @return The entry of the flow, NULL if there is none
+ */
+static ct_entry ct_find(ct_table t, const struct ct_key *key, u_int32_t h, struct in6_addr *edge)
+{
+	ct_entry e;
+	u_int32_t seq, state;
+	int match;
+	u_int i;
+
+	for(i = h & t->mask;; i = (i + 1) & t->mask) {
+		e = &t->slot[i];
+		for(;;) {
+			seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+			if(seq & 1)
+				continue;
+			state = e->state;
+			match = CT_LIVE == state && 0 == memcmp(&e->key, key, sizeof(*key));
+			if(match)
+				*edge = e->edge;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(seq == __atomic_load_n(&e->seq, __ATOMIC_RELAXED))
+				break;
+		}
+		if(match)
+			return e;
+		if(CT_FREE == state)
+			return NULL;
+	}
+}
+
+/**
+ *  @brief Moves the live flows of the current table to a new one, dropping the expired slots (table lock held)
+ *  @return 0, -1 if out of memory or the table the last rebuild replaced may still be probed
+ */
+static int ct_rebuild(sixone_ct ct)
+{
+	ct_table old = ct->table, t;
+	ct_entry e, n;
+	u_int i, j;
+	u_int64_t now = ct_now_us();
+
+	// lookups may still be probing (and refreshing deadlines in) the table the last rebuild replaced
+	if(NULL != ct->retired && now <= ct->retired_us + CT_RETIRE_US) {
+		ct->deferred++;
+		return -1;
+	}
+	if(NULL == (t = alloc_ct_table(old->mask + 1)))
+		return -1;
+
+	for(i = 0; i <= old->mask; i++) {
+		e = &old->slot[i];
+		if(CT_LIVE != e->state)
+			continue;
+		for(j = ct_hash(&e->key) & t->mask; CT_FREE != t->slot[j].state; j = (j + 1) & t->mask)
+			;
+		n = &t->slot[j];
+		n->state = CT_LIVE;
+		n->key = e->key;
+		n->edge = e->edge;
+		n->deadline_us = __atomic_load_n(&e->deadline_us, __ATOMIC_RELAXED);
+		n->flow = e->flow;
+		n->flow->slot = j;
+		t->live++;
+	}
+
+	free(ct->retired);
+	ct->retired = old;
+	ct->retired_us = now;
+	__atomic_store_n(&ct->table, t, __ATOMIC_RELEASE);
+	ct->rebuilds++;
+	return 0;
+}
+
+/**
+ *  @brief Timer callback, re-arms a flow that saw packets since or expires it
+ */
+static void ct_expire(sixone_timer timer)
+{
+	ct_flow f = (ct_flow)timer;
+	sixone_ct ct = f->ct;
+	ct_entry e;
+	u_int64_t deadline;
+
+	pthread_mutex_lock(&ct->lock);
+	e = &ct->table->slot[f->slot];
+	deadline = __atomic_load_n(&e->deadline_us, __ATOMIC_RELAXED);
+	if(deadline > timers_now()) {
+		timer_arm(timer, deadline);
+		pthread_mutex_unlock(&ct->lock);
+		return;
+	}
+	ct_write_begin(e);
+	e->state = CT_DEAD;
+	ct_write_end(e);
+	e->flow = NULL;
+	ct->table->live--;
+	ct->table->dead++;
+	ct->expired++;
+	pthread_mutex_unlock(&ct->lock);
+	free(f);
+}
+
+sixone_ct alloc_sixone_ct(u_int max)
+{
+	sixone_ct ct;
+	u_int slots = 2;
+
+	// at most half full, probes stay short
+	while(slots < 2 * (u_int64_t)max && slots < 1U << 31)
+		slots <<= 1;
+
+	if(NULL == (ct = calloc(1, sizeof(struct sixone_ct_))))
+		return NULL;
+	ct->max = max < slots / 2 ? max : slots / 2;
+	if(NULL == (ct->table = alloc_ct_table(slots))) {
+		free(ct);
+		return NULL;
+	}
+	pthread_mutex_init(&ct->lock, NULL);
+	return ct;
+}
+
+void free_sixone_ct(sixone_ct ct)
+{
+	u_int i;
+
+	for(i = 0; i <= ct->table->mask; i++) {
+		if(CT_LIVE != ct->table->slot[i].state)
+			continue;
+		timer_cancel(&ct->table->slot[i].flow->timer);
+		free(ct->table->slot[i].flow);
+	}
+	pthread_mutex_destroy(&ct->lock);
+	free(ct->retired);
+	free(ct->table);
+	free(ct);
+}
+
+int ct_track(sixone_ct ct, sixone_pkt pkt, const struct in6_addr *edge)
+{
+	struct ct_key key;
+	struct in6_addr found;
+	u_int64_t deadline = timers_now() + (u_int64_t)ct_key_of(pkt, 1, &key) * 1000000;
+	u_int32_t h = ct_hash(&key);
+	ct_table t;
+	ct_entry e, slot;
+	ct_flow f;
+	u_int i;
+
+	// a known flow only pushes its deadline
+	e = ct_find(__atomic_load_n(&ct->table, __ATOMIC_ACQUIRE), &key, h, &found);
+	if(NULL != e && 0 == memcmp(&found, edge, sizeof(found))) {
+		__atomic_store_n(&e->deadline_us, deadline, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	pthread_mutex_lock(&ct->lock);
+	if(NULL != ct->retired && ct_now_us() > ct->retired_us + CT_RETIRE_US) {
+		free(ct->retired);
+		ct->retired = NULL;
+	}
+	t = ct->table;
+	slot = NULL;
+	for(i = h & t->mask;; i = (i + 1) & t->mask) {
+		e = &t->slot[i];
+		if(CT_LIVE == e->state && 0 == memcmp(&e->key, &key, sizeof(key)))
+			break;
+		if(CT_DEAD == e->state && NULL == slot)
+			slot = e;
+		if(CT_FREE == e->state) {
+			e = NULL;
+			break;
+		}
+	}
+
+	if(NULL != e) {
+		// the address was reused by another edge host
+		if(0 != memcmp(&e->edge, edge, sizeof(*edge))) {
+			ct->collisions++;
+			ct_write_begin(e);
+			e->edge = *edge;
+			ct_write_end(e);
+		}
+		__atomic_store_n(&e->deadline_us, deadline, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&ct->lock);
+		return 0;
+	}
+
+	if(t->live >= ct->max || NULL == (f = malloc(sizeof(struct ct_flow_)))) {
+		ct->full++;
+		pthread_mutex_unlock(&ct->lock);
+		return -1;
+	}
+
+	// keep a quarter of the slots free, or a miss probes the whole table
+	if(NULL == slot && t->live + t->dead + 1 > (t->mask + 1) / 4 * 3 && 0 == ct_rebuild(ct)) {
+		t = ct->table;
+		for(i = h & t->mask; CT_FREE != t->slot[i].state; i = (i + 1) & t->mask)
+			;
+		slot = &t->slot[i];
+	}
+	else if(NULL == slot && t->live + t->dead + 1 > (t->mask + 1) / 8 * 7) {
+		// no rebuild now, and a probe must always reach a free slot
+		ct->full++;
+		pthread_mutex_unlock(&ct->lock);
+		free(f);
+		return -1;
+	}
+	else if(NULL == slot)
+		slot = &t->slot[i];
+	else
+		t->dead--;
+
+	ct_write_begin(slot);
+	slot->state = CT_LIVE;
+	slot->key = key;
+	slot->edge = *edge;
+	ct_write_end(slot);
+	__atomic_store_n(&slot->deadline_us, deadline, __ATOMIC_RELAXED);
+	slot->flow = f;
+	f->ct = ct;
+	f->slot = slot - t->slot;
+	timer_init(&f->timer, ct_expire);
+	timer_arm(&f->timer, deadline);
+	t->live++;
+	ct->created++;
+	pthread_mutex_unlock(&ct->lock);
+	return 0;
+}
+
+int ct_lookup(sixone_ct ct, sixone_pkt pkt, struct in6_addr *edge)
+{
+	struct ct_key key;
+	u_int64_t deadline = timers_now() + (u_int64_t)ct_key_of(pkt, 0, &key) * 1000000;
+	ct_entry e;
+
+	e = ct_find(__atomic_load_n(&ct->table, __ATOMIC_ACQUIRE), &key, ct_hash(&key), edge);
+	if(NULL == e) {
+		__atomic_fetch_add(&ct->misses, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+	__atomic_store_n(&e->deadline_us, deadline, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&ct->hits, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+int ct_lookup_sent(sixone_ct ct, sixone_pkt pkt, struct in6_addr *edge)
+{
+	struct ct_key key;
+
+	ct_key_of(pkt, 1, &key);
+	return NULL == ct_find(__atomic_load_n(&ct->table, __ATOMIC_ACQUIRE), &key, ct_hash(&key), edge) ? -1 : 0;
+}
+
+void ct_report(sixone_ct ct)
+{
+	printf("  conntrack: %u flows, %u tracked, %u expired, %u edge changes, %u untracked (full), %u rebuilds (%u put off)\n",
+	       ct->table->live, ct->created, ct->expired, ct->collisions, ct->full, ct->rebuilds, ct->deferred);
+	printf("  conntrack: %u replies restored, %u left to the legacy edge net\n", ct->hits, ct->misses);
+}
@@ -0,0 +1,194 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonect.h
+ *  @brief Six-One Router connection tracking for legacy flows
+ *  @date 2026-10-19
+ *
+ *  A legacy (unilateral) destination sees our transit address as the
+ *  source, the reply comes back to it without a mapping to undo the
+ *  rewrite with. Without tracking, inbound() can only splice the reply
+ *  into the last edge net of the configuration, which is wrong as
+ *  soon as there is more than one edge net. outbound() records each
+ *  legacy flow here, keyed on the translated 5-tuple, and inbound()
+ *  restores the exact edge address of the reply from it.
+ *
+ *  - the key: our transit side address, the remote address, the
+ *    protocol and the local/remote ports (the echo identifier for ICMPv6
+ *    echo, 0 otherwise), as outbound() leaves the packet
+ *  - lookups do not lock, entries are read under a per-entry sequence
+ *    count and a packet only refreshes the deadline of its entry
+ *  - new flows, expiry and rebuilds take the table lock, a rebuild
+ *    publishes a new table and frees the old one a second later; a
+ *    rebuild within that second is put off, the table fills up to 7/8
+ *    meanwhile and new flows past that are not tracked
+ *  - each flow has a timer (sixonetimer.h) on the thread that saw it
+ *    first, which re-arms it to the deadline or expires it: TCP after
+ *    RFC 5382 (2 h 4 min established, 4 min after SYN, FIN or RST), UDP
+ *    after 5 min (RFC 4787), anything else after 1 min
+ *
+ *  Non-first fragments carry no ports, they are never looked up here:
+ *  they go where their first fragment went (sixonefrag.h).
+ */
+
+#ifndef SIXONECT_H
+#define SIXONECT_H
+
+#include <pthread.h>
+
+#include "sixonepkt.h"
+#include "sixonetimer.h"
+
+/// @brief Flows tracked by default (--conntrack)
+#define CT_MAX 65536
+/// @brief How long a replaced table is kept for the lookups still probing it (us, monotonic clock)
+#define CT_RETIRE_US 1000000ULL
+/// @brief Idle timeout of an established TCP flow (s)
+#define CT_TIMEOUT_TCP 7440
+/// @brief Idle timeout after a SYN, FIN or RST (s)
+#define CT_TIMEOUT_TCP_TRANS 240
+/// @brief Idle timeout of a UDP flow (s)
+#define CT_TIMEOUT_UDP 300
+/// @brief Idle timeout of anything else (s)
+#define CT_TIMEOUT_OTHER 60
+
+/// @brief Slot never used, ends a probe
+#define CT_FREE 0
+/// @brief Slot holds a flow
+#define CT_LIVE 1
+/// @brief Slot held an expired flow, probes go on past it
+#define CT_DEAD 2
+
+/**
+ * @brief What a flow is looked up by, seen from our side
+ */
+struct ct_key {
+	struct in6_addr local;  /// our transit side address
+	struct in6_addr remote; /// the legacy host
+	u_int16_t lport;        /// local port or echo identifier (network order)
+	u_int16_t rport;        /// remote port (network order)
+	u_int32_t proto;
+};
+
+/**
+ * @brief The expiry timer of a flow, it stays put when a rebuild moves the flow
+ */
+typedef struct ct_flow_ *ct_flow;
+struct ct_flow_ {
+	struct sixone_timer_ timer;
+	struct sixone_ct_ *ct;
+	u_int slot;             /// where the flow is in the current table
+};
+
+/**
+ * @brief A tracked flow
+ */
+typedef struct ct_entry_ *ct_entry;
+struct ct_entry_ {
+	u_int32_t seq;          /// odd while the entry is written
+	u_int32_t state;        /// CT_*
+	struct ct_key key;
+	struct in6_addr edge;   /// the source address before the rewrite
+	u_int64_t deadline_us;  /// refreshed by every packet of the flow
+	ct_flow flow;
+};
+
+/**
+ * @brief Open addressing table, linear probing
+ */
+typedef struct ct_table_ {
+	u_int mask;             /// slots - 1
+	u_int live;
+	u_int dead;
+	struct ct_entry_ slot[];
+} *ct_table;
+
+/**
+ * @brief The connection tracker
+ */
+typedef struct sixone_ct_ {
+	ct_table table;         /// the current table, lookups load it once
+	ct_table retired;       /// the table a rebuild replaced
+	u_int64_t retired_us;   /// when it was replaced
+	u_int max;              /// most flows tracked at once
+	pthread_mutex_t lock;   /// new flows, expiry and rebuilds
+	u_int created;          /// flows tracked
+	u_int expired;          /// flows timed out
+	u_int collisions;       /// flows whose edge address changed
+	u_int full;             /// flows not tracked, the table was full
+	u_int rebuilds;         /// tables rebuilt to clear expired slots
+	u_int deferred;         /// rebuilds put off, the table before was replaced less than CT_RETIRE_US ago
+	u_int hits;             /// replies restored from a flow
+	u_int misses;           /// replies left to the legacy edge net
+} *sixone_ct;
+
+/// @brief The connection tracker, NULL when it is disabled
+extern sixone_ct global_ct;
+
+/**
+ *  @brief Allocates an empty tracker
+ *  @param max Most flows tracked at once
+ *  @return The tracker, NULL if it could not be allocated
+ */
+sixone_ct alloc_sixone_ct(u_int max);
+
+/**
+ *  @brief Frees the tracker and its flows, once no thread tracks or expires flows any more
+ */
+void free_sixone_ct(sixone_ct ct);
+
+/**
+ *  @brief Records (or refreshes) the flow of a rewritten outbound legacy packet
+ *  @param pkt The packet after outbound() rewrote its source
+ *  @param edge The source address before the rewrite
+ *  @return 0 if the flow is tracked, -1 if the table is full
+ */
+int ct_track(sixone_ct ct, sixone_pkt pkt, const struct in6_addr *edge);
+
+/**
+ *  @brief Finds the flow an inbound legacy packet replies to
+ *  @param pkt The packet, not rewritten yet
+ *  @param edge Set to the edge address to deliver to
+ *  @return 0 if the flow was found, -1 otherwise
+ */
+int ct_lookup(sixone_ct ct, sixone_pkt pkt, struct in6_addr *edge);
+
+/**
+ *  @brief Finds the flow of a packet outbound() sent, without refreshing it
+ *  (the packet an ICMPv6 error quotes, see parse_quote())
+ *  @param pkt The packet as it left the router
+ *  @param edge Set to the edge address it was sent from
+ *  @return 0 if the flow was found, -1 otherwise
+ */
+int ct_lookup_sent(sixone_ct ct, sixone_pkt pkt, struct in6_addr *edge);
+
+/**
+ *  @brief Prints the tracker counters (replay report)
+ */
+void ct_report(sixone_ct ct);
+
+#endif // SIXONECT_H
@@ -0,0 +1,435 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixoneegress.c
+ *  @brief Six-One Router sends outbound packets straight onto the transit interface
+ *  @date 2026-10-19
+ */
+
+#include "sixoneegress.h"
+#include "sixonepkt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <ifaddrs.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <net/if.h>
+#include <net/if_dl.h>
+#include <net/route.h>
+#include <arpa/inet.h>
+
+/// @brief Routing socket messages pad their addresses to a long (as ndp(8) reads them)
+#define EGRESS_ROUNDUP(a) ((a) > 0 ? (1 + (((a) - 1) | (sizeof(long) - 1))) : sizeof(long))
+
+sixone_egress global_egress;
+
+/**
+ *  @brief The index in if_v of the interface called name, -1 if it is not one of ours
+ */
+static int egress_if_of(sixone_egress egress, const char *name)
+{
+	u_int i;
+
+	for(i = 0; i < egress->if_c; i++)
+		if(0 == strcmp(name, (const char *)egress->if_v[i].name))
+			return i;
+	return -1;
+}
+
+static u_int egress_hash(u_int ifx, const struct in6_addr *addr)
+{
+	u_int32_t w[4], h = ifx;
+	int i;
+
+	memcpy(w, addr, sizeof(w));
+	for(i = 0; i < 4; i++)
+		h = pkt_hash_mix(h, w[i]);
+	return h;
+}
+
+static u_int64_t egress_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u_int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ *  @brief Runs route(8) to add or delete the host route to dst through gw
+ *  @return What system() returned
+ */
+static int egress_route_cmd(const char *verb, const struct in6_addr *dst, const struct in6_addr *gw)
+{
+	char cmd[256], dst_str[INET6_ADDRSTRLEN], gw_str[INET6_ADDRSTRLEN];
+
+	inet_ntop(AF_INET6, dst, dst_str, sizeof(dst_str));
+	inet_ntop(AF_INET6, gw, gw_str, sizeof(gw_str));
+	snprintf(cmd, sizeof(cmd), "route %s -inet6 %s/128 %s", verb, dst_str, gw_str);
+	return system(cmd);
+}
+
+/**
+ *  @brief Copies the frame header to addr on ifx
+ *  @return 0, -1 if the neighbour is not known
+ */
+static int neigh_copy(sixone_egress egress, u_int ifx, const struct in6_addr *addr, struct ether_header *eh)
+{
+	struct egress_neigh *e;
+	u_int h = egress_hash(ifx, addr), i;
+	u_int32_t seq;
+	int match;
+
+	for(i = 0; i < EGRESS_PROBE; i++) {
+		e = &egress->slot[(h + i) & (EGRESS_SLOTS - 1)];
+		for(;;) {
+			seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+			if(seq & 1)
+				continue;
+			match = 0 != e->gen && ifx == e->ifx && 0 == memcmp(&e->addr, addr, sizeof(*addr));
+			if(match && NULL != eh)
+				memcpy(eh, &e->eh, sizeof(*eh));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(seq == __atomic_load_n(&e->seq, __ATOMIC_RELAXED))
+				break;
+		}
+		if(match)
+			return 0;
+	}
+	return -1;
+}
+
+/**
+ *  @brief egress_learn() with the lock held
+ */
+static int neigh_store(sixone_egress egress, u_int ifx, const struct in6_addr *addr, const u_char *mac)
+{
+	struct egress_neigh *e, *free_e = NULL;
+	u_int h = egress_hash(ifx, addr), i;
+
+	for(i = 0; i < EGRESS_PROBE; i++) {
+		e = &egress->slot[(h + i) & (EGRESS_SLOTS - 1)];
+		if(0 != e->gen && ifx == e->ifx && 0 == memcmp(&e->addr, addr, sizeof(*addr)))
+			break;
+		if(NULL == free_e && (0 == e->gen || egress->gen != e->gen))
+			free_e = e;
+	}
+	// an entry the current read has not seen yet may be taken, the read forgets it anyway
+	if(EGRESS_PROBE == i && NULL == (e = free_e))
+		return -1;
+
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	e->gen = egress->gen;
+	e->ifx = ifx;
+	e->addr = *addr;
+	memcpy(e->eh.ether_dhost, mac, ETHER_ADDR_LEN);
+	memcpy(e->eh.ether_shost, egress->if_v[ifx].mac, ETHER_ADDR_LEN);
+	e->eh.ether_type = htons(ETHERTYPE_IPV6);
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int egress_learn(sixone_egress egress, u_int ifx, const struct in6_addr *addr, const u_char *mac)
+{
+	int rc;
+
+	if(ifx >= egress->if_c || !egress->if_v[ifx].has_mac)
+		return -1;
+	pthread_mutex_lock(&egress->lock);
+	rc = neigh_store(egress, ifx, addr, mac);
+	pthread_mutex_unlock(&egress->lock);
+	return rc;
+}
+
+int egress_refresh(sixone_egress egress)
+{
+	int mib[6] = { CTL_NET, PF_ROUTE, 0, AF_INET6, NET_RT_FLAGS, RTF_LLINFO };
+	char *buf, *next, *lim, name[IF_NAMESIZE];
+	struct rt_msghdr *rtm;
+	struct sockaddr_in6 *sin;
+	struct sockaddr_dl *sdl;
+	struct egress_neigh *e;
+	struct in6_addr addr;
+	size_t len;
+	int ifx, n = 0;
+	u_int i;
+
+	if(0 != sysctl(mib, 6, NULL, &len, NULL, 0))
+		return -1;
+	// room for what the table grows by before the second call
+	len += len / 2 + 1024;
+	if(NULL == (buf = malloc(len)))
+		return -1;
+	if(0 != sysctl(mib, 6, buf, &len, NULL, 0)) {
+		free(buf);
+		return -1;
+	}
+
+	pthread_mutex_lock(&egress->lock);
+	egress->gen++;
+	for(next = buf, lim = buf + len; next < lim; next += rtm->rtm_msglen) {
+		rtm = (struct rt_msghdr *)next;
+		if(0 == rtm->rtm_msglen)
+			break;
+		sin = (struct sockaddr_in6 *)(rtm + 1);
+		sdl = (struct sockaddr_dl *)((char *)sin + EGRESS_ROUNDUP(sin->sin6_len));
+		if(AF_INET6 != sin->sin6_family || AF_LINK != sdl->sdl_family || ETHER_ADDR_LEN != sdl->sdl_alen)
+			continue;
+		if(NULL == if_indextoname(sdl->sdl_index, name) || 0 > (ifx = egress_if_of(egress, name)) ||
+		   !egress->if_v[ifx].has_mac)
+			continue;
+		addr = sin->sin6_addr;
+		// the kernel keeps the scope of a link local address in its 3rd and 4th byte
+		if(IN6_IS_ADDR_LINKLOCAL(&addr))
+			addr.s6_addr[2] = addr.s6_addr[3] = 0;
+		if(0 == neigh_store(egress, ifx, &addr, (u_char *)LLADDR(sdl)))
+			n++;
+	}
+	// what the kernel no longer has goes to the tun device again
+	for(i = 0; i < EGRESS_SLOTS; i++) {
+		e = &egress->slot[i];
+		if(0 == e->gen || egress->gen == e->gen)
+			continue;
+		__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		e->gen = 0;
+		__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+	}
+	egress->learned = n;
+	pthread_mutex_unlock(&egress->lock);
+	free(buf);
+	return n;
+}
+
+/**
+ *  @brief The refresh thread, reads the table every EGRESS_REFRESH_US or when a packet missed
+ */
+static void *egress_run(void *arg)
+{
+	sixone_egress egress = arg;
+	struct timespec ts;
+
+	while(!egress->stop) {
+		egress_refresh(egress);
+		egress_withdraw(egress, 0);
+		usleep(EGRESS_WAKE_US);
+
+		pthread_mutex_lock(&egress->lock);
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += EGRESS_REFRESH_US / 1000000;
+		while(!egress->stop && !egress->want)
+			if(ETIMEDOUT == pthread_cond_timedwait(&egress->wake, &egress->lock, &ts))
+				break;
+		egress->want = 0;
+		pthread_mutex_unlock(&egress->lock);
+	}
+	return NULL;
+}
+
+sixone_egress alloc_sixone_egress(sixone_settings settings)
+{
+	struct ifaddrs *ifa, *a;
+	struct sockaddr_dl *sdl;
+	sixone_egress egress;
+	int ifx;
+
+	if(NULL == (egress = calloc(1, sizeof(*egress))))
+		return NULL;
+	if(NULL == (egress->if_v = calloc(settings->if_c, sizeof(*egress->if_v)))) {
+		free(egress);
+		return NULL;
+	}
+	egress->if_c = settings->if_c;
+	for(ifx = 0; ifx < settings->if_c; ifx++) {
+		egress->if_v[ifx].name = settings->if_v[ifx]->if_name;
+		egress->if_v[ifx].mtu = settings->if_v[ifx]->mtu;
+	}
+
+	// our link addresses, the source of every frame
+	if(0 == getifaddrs(&ifa)) {
+		for(a = ifa; NULL != a; a = a->ifa_next) {
+			if(NULL == a->ifa_addr || AF_LINK != a->ifa_addr->sa_family)
+				continue;
+			sdl = (struct sockaddr_dl *)a->ifa_addr;
+			if(ETHER_ADDR_LEN != sdl->sdl_alen || 0 > (ifx = egress_if_of(egress, a->ifa_name)))
+				continue;
+			memcpy(egress->if_v[ifx].mac, LLADDR(sdl), ETHER_ADDR_LEN);
+			egress->if_v[ifx].has_mac = 1;
+		}
+		freeifaddrs(ifa);
+	}
+	for(ifx = 0; ifx < egress->if_c; ifx++)
+		if(!egress->if_v[ifx].has_mac)
+			printf("--direct: %s has no ethernet address, its packets take the tun device\n", egress->if_v[ifx].name);
+
+	pthread_mutex_init(&egress->lock, NULL);
+	pthread_cond_init(&egress->wake, NULL);
+	if(0 > egress_refresh(egress))
+		printf("--direct: cannot read the neighbour table yet: %s\n", strerror(errno));
+	if(0 != pthread_create(&egress->thread, NULL, egress_run, egress)) {
+		pthread_cond_destroy(&egress->wake);
+		pthread_mutex_destroy(&egress->lock);
+		free(egress->if_v);
+		free(egress);
+		return NULL;
+	}
+	return egress;
+}
+
+void free_sixone_egress(sixone_egress egress)
+{
+	if(NULL == egress)
+		return;
+	pthread_mutex_lock(&egress->lock);
+	egress->stop = 1;
+	pthread_cond_signal(&egress->wake);
+	pthread_mutex_unlock(&egress->lock);
+	pthread_join(egress->thread, NULL);
+	egress_withdraw(egress, 1);
+	pthread_cond_destroy(&egress->wake);
+	pthread_mutex_destroy(&egress->lock);
+	free(egress->if_v);
+	free(egress);
+}
+
+void egress_attach(sixone_egress egress, const u_char *if_name, pcap_t *handle)
+{
+	int ifx;
+
+	if(0 <= (ifx = egress_if_of(egress, (const char *)if_name)))
+		__atomic_store_n(&egress->if_v[ifx].handle, handle, __ATOMIC_RELEASE);
+}
+
+int egress_known(sixone_egress egress, u_int ifx, const struct in6_addr *nh)
+{
+	return ifx < egress->if_c && 0 == neigh_copy(egress, ifx, nh, NULL);
+}
+
+int egress_send(sixone_egress egress, u_int ifx, const struct in6_addr *nh, const struct ip6_hdr *ip)
+{
+	// room for the largest payload length
+	static __thread u_char frame[ETHER_HDR_LEN + sizeof(struct ip6_hdr) + 0xFFFF];
+	u_int len = sizeof(*ip) + ntohs(ip->ip6_plen);
+	pcap_t *handle;
+
+	// anything larger than a frame on the link carries is for the kernel to answer
+	if(ifx < egress->if_c && len > egress->if_v[ifx].mtu) {
+		__atomic_fetch_add(&egress->too_big, 1, __ATOMIC_RELAXED);
+		return -2;
+	}
+	if(ifx >= egress->if_c || NULL == (handle = __atomic_load_n(&egress->if_v[ifx].handle, __ATOMIC_ACQUIRE)) ||
+	   0 != neigh_copy(egress, ifx, nh, (struct ether_header *)frame)) {
+		__atomic_fetch_add(&egress->missed, 1, __ATOMIC_RELAXED);
+		// one wake up until the thread has read the table
+		if(0 == __atomic_exchange_n(&egress->want, 1, __ATOMIC_RELAXED))
+			pthread_cond_signal(&egress->wake);
+		return -1;
+	}
+	memcpy(frame + ETHER_HDR_LEN, ip, len);
+	if(ETHER_HDR_LEN + len != pcap_inject(handle, frame, ETHER_HDR_LEN + len)) {
+		__atomic_fetch_add(&egress->failed, 1, __ATOMIC_RELAXED);
+		return -2;
+	}
+	__atomic_fetch_add(&egress->sent, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+int egress_route(sixone_egress egress, u_int ifx, const struct in6_addr *dst, const struct in6_addr *gw)
+{
+	struct egress_route *r, *free_r = NULL;
+	int rc = 0;
+	u_int i;
+
+	pthread_mutex_lock(&egress->lock);
+	for(i = 0; i < EGRESS_ROUTES; i++) {
+		r = &egress->route_v[i];
+		if(0 == r->until_us) {
+			if(NULL == free_r)
+				free_r = r;
+		}
+		else if(0 == memcmp(&r->dst, dst, sizeof(*dst)))
+			break;
+	}
+	if(EGRESS_ROUTES == i) {
+		if(NULL == free_r) {
+			egress->route_full++;
+			rc = -1;
+		}
+		// held over route(8), so a second miss to dst does not add it twice
+		else if(0 == egress_route_cmd("add", dst, gw)) {
+			free_r->until_us = egress_now_us() + EGRESS_ROUTE_US;
+			free_r->ifx = ifx;
+			free_r->dst = *dst;
+			free_r->gw = *gw;
+			egress->route_c++;
+			egress->routes++;
+		}
+		else
+			rc = -1;
+	}
+	pthread_mutex_unlock(&egress->lock);
+	return rc;
+}
+
+void egress_withdraw(sixone_egress egress, int all)
+{
+	struct egress_route gone[EGRESS_ROUTES];
+	struct egress_route *r;
+	u_int64_t now = egress_now_us();
+	u_int i, n = 0;
+
+	pthread_mutex_lock(&egress->lock);
+	for(i = 0; i < EGRESS_ROUTES; i++) {
+		r = &egress->route_v[i];
+		if(0 == r->until_us)
+			continue;
+		// frames reach the gateway now, or the kernel never resolved it
+		if(all || r->until_us <= now || 0 == neigh_copy(egress, r->ifx, &r->gw, NULL)) {
+			gone[n++] = *r;
+			r->until_us = 0;
+			egress->route_c--;
+		}
+	}
+	pthread_mutex_unlock(&egress->lock);
+
+	for(i = 0; i < n; i++)
+		egress_route_cmd("delete", &gone[i].dst, &gone[i].gw);
+}
+
+void egress_report(sixone_egress egress)
+{
+	printf("  direct: %u sent as frames, %u missed the neighbour, %u not taken, %u above the MTU, %u neighbours\n",
+	       egress->sent, egress->missed, egress->failed, egress->too_big, egress->learned);
+	printf("  direct: %u fallback routes added, %u in place, %u packets got none (%u in use)\n",
+	       egress->routes, egress->route_c, egress->route_full, EGRESS_ROUTES);
+}
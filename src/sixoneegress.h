@@ -0,0 +1,194 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixoneegress.h
+ *  @brief Six-One Router sends outbound packets straight onto the transit interface
+ *  @date 2026-10-19
+ *
+ *  Without it every rewritten packet goes back into the kernel through the
+ *  tun device and outbound() installs a route for its destination so the
+ *  kernel can send it on. With --direct, forward_packet() puts a packet
+ *  whose source is in a transit net in an ethernet frame to the gateway of
+ *  that net, and a packet to one of our edge hosts in a frame to the host,
+ *  and injects it on the capture handle of the interface (BPF). The frame
+ *  header to each next hop is built when the neighbour is learned, sending
+ *  is one copy and one write.
+ *
+ *  The neighbour cache is seeded from the kernel's neighbour table (the
+ *  PF_ROUTE sysctl that ndp -a reads) and read again by its own thread
+ *  every EGRESS_REFRESH_US, or sooner when a packet missed. A packet to a
+ *  next hop the cache does not know yet takes the tun device as before,
+ *  which has the kernel resolve the neighbour, with a route for its
+ *  destination if it goes to transit. Lookups do not lock.
+ *
+ *  Those fallback routes are only there until the gateway is learned: the
+ *  refresh thread withdraws each one once the cache knows its gateway or
+ *  EGRESS_ROUTE_US after it was added, and at most EGRESS_ROUTES are in
+ *  the kernel at a time. A packet larger than the MTU of the interface is
+ *  not put in a frame, the tun device takes it (and the kernel answers
+ *  it with a Packet Too Big).
+ */
+
+#ifndef SIXONEEGRESS_H
+#define SIXONEEGRESS_H
+
+#include <pthread.h>
+#include <pcap.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <net/ethernet.h>
+
+#include "sixonetypes.h"
+
+/// @brief Neighbour cache slots (a power of two)
+#define EGRESS_SLOTS 4096
+/// @brief Slots a neighbour may sit in from the one it hashes to
+#define EGRESS_PROBE 8
+/// @brief How often the kernel's neighbour table is read (us)
+#define EGRESS_REFRESH_US (5 * 1000000ULL)
+/// @brief The table is read at most this often however many packets miss (us)
+#define EGRESS_WAKE_US (100 * 1000)
+/// @brief Fallback routes in the kernel at most
+#define EGRESS_ROUTES 256
+/// @brief How long a fallback route stays if its gateway is never learned (us)
+#define EGRESS_ROUTE_US (30 * 1000000ULL)
+
+/**
+ * @brief A neighbour and the frame header to it
+ */
+struct egress_neigh {
+	u_int32_t seq;          /// odd while the entry is written
+	u_int32_t gen;          /// the refresh that last saw it, 0 for an unused slot
+	u_int ifx;              /// index in if_v of the interface it is on
+	struct in6_addr addr;
+	struct ether_header eh; /// prebuilt, our address as the source
+};
+
+/**
+ * @brief An interface frames can leave on
+ */
+struct egress_if {
+	const u_char *name;
+	pcap_t *handle;         /// its capture handle, NULL until start_interface() attached it
+	u_char mac[ETHER_ADDR_LEN];
+	int has_mac;            /// 0 if the system has no link address for it, nothing leaves on it then
+	u_int mtu;              /// largest packet (IPv6 header and payload) a frame on it may carry
+};
+
+/**
+ * @brief A route added for a packet whose gateway was not known, withdrawn by the refresh thread
+ */
+struct egress_route {
+	u_int64_t until_us;     /// egress_now_us() it is withdrawn at, 0 for an unused entry
+	u_int ifx;              /// index in if_v of the interface the gateway is on
+	struct in6_addr dst;
+	struct in6_addr gw;
+};
+
+/**
+ * @brief The interfaces and the neighbour cache
+ */
+typedef struct sixone_egress_ {
+	pthread_mutex_t lock;   /// writers
+	pthread_cond_t wake;    /// a miss wants the table read now
+	pthread_t thread;
+	int stop;
+	int want;               /// a miss since the last read
+	u_int gen;              /// refreshes so far
+	u_int if_c;
+	struct egress_if *if_v; /// parallel to if_v of the settings
+	u_int sent;             /// packets sent as frames
+	u_int missed;           /// packets that took the tun device, no neighbour (yet)
+	u_int failed;           /// frames the interface did not take
+	u_int too_big;          /// packets above the interface MTU, they took the tun device
+	u_int learned;          /// neighbours in the cache after the last read
+	u_int route_c;          /// fallback routes in the kernel
+	u_int routes;           /// fallback routes added
+	u_int route_full;       /// packets that got no fallback route, EGRESS_ROUTES were in use
+	struct egress_route route_v[EGRESS_ROUTES];
+	struct egress_neigh slot[EGRESS_SLOTS];
+} *sixone_egress;
+
+/// @brief The egress of --direct, NULL without it
+extern sixone_egress global_egress;
+
+/**
+ *  @brief Reads the link addresses of the interfaces, seeds the cache and starts the refresh thread
+ *  @return The egress, NULL if out of resources
+ */
+sixone_egress alloc_sixone_egress(sixone_settings settings);
+
+void free_sixone_egress(sixone_egress egress);
+
+/**
+ *  @brief Lets frames leave on the capture handle of an interface
+ */
+void egress_attach(sixone_egress egress, const u_char *if_name, pcap_t *handle);
+
+/**
+ *  @brief Adds or replaces a neighbour and builds the frame header to it
+ *  @return 0, -1 if the cache has no room for it
+ */
+int egress_learn(sixone_egress egress, u_int ifx, const struct in6_addr *addr, const u_char *mac);
+
+/**
+ *  @brief Whether frames to nh on interface ifx can be sent
+ */
+int egress_known(sixone_egress egress, u_int ifx, const struct in6_addr *nh);
+
+/**
+ *  @brief Sends a packet in a frame to the next hop nh on interface ifx
+ *  @return 0 if sent, -1 if nh is not known (yet), -2 if the packet is
+ *  larger than the MTU of ifx or the interface did not take it; the
+ *  caller takes the tun device for both
+ */
+int egress_send(sixone_egress egress, u_int ifx, const struct in6_addr *nh, const struct ip6_hdr *ip);
+
+/**
+ *  @brief Adds a route for dst through the gateway gw on interface ifx until gw is learned
+ *  @return 0 if the route is in place, -1 if EGRESS_ROUTES are in use or it could not be added
+ */
+int egress_route(sixone_egress egress, u_int ifx, const struct in6_addr *dst, const struct in6_addr *gw);
+
+/**
+ *  @brief Withdraws the fallback routes whose gateway is known or whose time is up, all of them if all is set
+ */
+void egress_withdraw(sixone_egress egress, int all);
+
+/**
+ *  @brief Reads the kernel's neighbour table into the cache, forgets neighbours it no longer has
+ *  @return The neighbours on our interfaces, -1 if the table could not be read
+ */
+int egress_refresh(sixone_egress egress);
+
+/**
+ *  @brief Prints the counters
+ */
+void egress_report(sixone_egress egress);
+
+#endif // SIXONEEGRESS_H
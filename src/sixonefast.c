@@ -0,0 +1,325 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonefast.c
+ *  @brief Six-One Router fast path for established mappings
+ *  @date 2026-10-19
+ */
+
+#include "sixonefast.h"
+#include "sixonelib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <netinet/icmp6.h>
+
+sixone_fast global_fastpath;
+
+/**
+ * @brief A learned mapping
+ */
+struct fast_entry {
+	u_int64_t until_us;  /// timers_now() past which the slow path resolves it again
+	ip_list list;        /// the prefixes, NULL for a legacy destination
+	struct in6_addr pfx; /// where it is in its table, for removing it
+	u_int len;
+};
+
+/**
+ * @brief The expired entries a sweep found
+ */
+struct fast_sweep {
+	u_int64_t now;
+	struct fast_entry **v;
+	u_int c, cap;
+};
+
+/**
+ *  @brief Copies list if all its prefixes have the same length
+ *  @param len Set to that length
+ *  @return The copy, NULL if the lengths differ (or out of memory)
+ */
+static ip_list copy_list(ip_list list, u_int *len)
+{
+	ip_list ret = NULL, *curr = &ret, l;
+
+	for(l = list; l != NULL; l = l->next)
+		if(l->ip->pfx != list->ip->pfx)
+			return NULL;
+
+	for(l = list; l != NULL; l = l->next) {
+		if(NULL == ((*curr) = alloc_ip_list()) || NULL == ((*curr)->ip = alloc_sixone_ip()))
+			break;
+		*(*curr)->ip = *l->ip;
+		(*curr)->weight = l->weight;
+		curr = &(*curr)->next;
+	}
+	*len = list->ip->pfx;
+	return ret;
+}
+
+static void free_list(ip_list l)
+{
+	ip_list next;
+
+	for(; l != NULL; l = next) {
+		next = l->next;
+		free(l->ip);
+		free(l);
+	}
+}
+
+static void free_entry(void *p)
+{
+	struct fast_entry *e = p;
+
+	if(NULL == e)
+		return;
+	free_list(e->list);
+	free(e);
+}
+
+/**
+ *  @brief Looks addr up in lpm, an expired entry is not found
+ */
+static struct fast_entry *fast_find(sixone_fast fast, sixone_lpm lpm, const struct in6_addr *addr)
+{
+	struct fast_entry *e = lpm_lookup(lpm, addr, NULL);
+
+	if(NULL != e && e->until_us < timers_now()) {
+		__atomic_fetch_add(&fast->expired, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	return e;
+}
+
+/**
+ *  @brief lpm_walk() callback collecting the expired entries
+ */
+static void fast_expired(const struct in6_addr *pfx, u_int len, void **val, void *arg)
+{
+	struct fast_sweep *sw = arg;
+	struct fast_entry *e = *val, **v;
+
+	if(NULL == e || e->until_us >= sw->now)
+		return;
+	if(sw->c == sw->cap) {
+		if(NULL == (v = realloc(sw->v, (sw->cap ? 2 * sw->cap : 64) * sizeof(*v))))
+			return;
+		sw->v = v;
+		sw->cap = sw->cap ? 2 * sw->cap : 64;
+	}
+	sw->v[sw->c++] = e;
+}
+
+/**
+ *  @brief Removes the entries of lpm that expired before now, with the write lock held
+ */
+static void fast_sweep(sixone_fast fast, sixone_lpm lpm, u_int64_t now)
+{
+	struct fast_sweep sw = { now, NULL, 0, 0 };
+	u_int i;
+
+	lpm_walk(lpm, fast_expired, &sw);
+	for(i = 0; i < sw.c; i++) {
+		lpm_remove(lpm, &sw.v[i]->pfx, sw.v[i]->len);
+		free_entry(sw.v[i]);
+	}
+	fast->removed += sw.c;
+	free(sw.v);
+}
+
+/**
+ *  @brief Stores list (taken over) for pfx/len in lpm, for SIXONE_FAST_TTL_US
+ */
+static void fast_learn(sixone_fast fast, sixone_lpm lpm, struct in6_addr *pfx, u_int len, ip_list list)
+{
+	struct fast_entry *e;
+	u_int64_t now = timers_now();
+
+	if(NULL == (e = malloc(sizeof(*e)))) {
+		free_list(list);
+		return;
+	}
+	e->until_us = now + SIXONE_FAST_TTL_US;
+	e->list = list;
+	e->pfx = *pfx;
+	e->len = len;
+
+	pthread_rwlock_wrlock(&fast->lock);
+	// whatever was never looked up again goes here, not only what the slow path learns anew
+	if(now >= fast->sweep_us) {
+		fast_sweep(fast, fast->out, now);
+		fast_sweep(fast, fast->in, now);
+		fast->sweep_us = now + SIXONE_FAST_SWEEP_US;
+	}
+	if(lpm_count(lpm) >= SIXONE_FAST_MAX && NULL == lpm_exact(lpm, pfx, len)) {
+		fast->full++;
+		pthread_rwlock_unlock(&fast->lock);
+		free_entry(e);
+		return;
+	}
+	free_entry(lpm_insert(lpm, pfx, len, e));
+	pthread_rwlock_unlock(&fast->lock);
+}
+
+sixone_fast alloc_sixone_fast(sixone_settings settings)
+{
+	sixone_fast fast;
+
+	if(0 == settings->image->edge_c || 0 == settings->image->transit_c)
+		return NULL;
+
+	fast = (sixone_fast) calloc(1, sizeof(struct sixone_fast_));
+	if(NULL == fast)
+		return NULL;
+	fast->out = alloc_sixone_lpm();
+	fast->in = alloc_sixone_lpm();
+	if(NULL == fast->out || NULL == fast->in) {
+		free_sixone_fast(fast);
+		return NULL;
+	}
+	pthread_rwlock_init(&fast->lock, NULL);
+
+	// the slow path rewrites to the last edge and transit net configured, so do we
+	fast->image = settings->image;
+	return fast;
+}
+
+void free_sixone_fast(sixone_fast fast)
+{
+	if(NULL == fast)
+		return;
+	free_sixone_lpm(fast->out, free_entry);
+	free_sixone_lpm(fast->in, free_entry);
+	pthread_rwlock_destroy(&fast->lock);
+	free(fast);
+}
+
+void fast_flush(sixone_fast fast)
+{
+	pthread_rwlock_wrlock(&fast->lock);
+	lpm_flush(fast->out, free_entry);
+	lpm_flush(fast->in, free_entry);
+	pthread_rwlock_unlock(&fast->lock);
+}
+
+int fast_path(sixone_fast fast, sixone_pkt pkt)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct in6_addr old, tracked;
+	sixone_image img = fast->image;
+	int edge;
+	sixone_ip pick;
+	struct fast_entry *e;
+	int ret = SIXONE_FAST_PUNT;
+
+	// ICMPv6 errors quote the offending packet, that is for the slow path
+	if(IPPROTO_ICMPV6 == pkt->proto && (0 == pkt->l4_off || pkt->icmp_type < ICMP6_ECHO_REQUEST)) {
+		__atomic_fetch_add(&fast->punts, 1, __ATOMIC_RELAXED);
+		return SIXONE_FAST_PUNT;
+	}
+
+	pthread_rwlock_rdlock(&fast->lock);
+
+	// same classification as is_inbound()/is_outbound()
+	if(0 <= image_find_transit(img, &ip->ip6_dst)) {
+		if(bilateral_bit(ip)) {
+			e = fast_find(fast, fast->in, &ip->ip6_src);
+			if(NULL != e && NULL != (pick = policy_pick_src(e->list, pkt->hash))) {
+				if(NULL != global_rtt)
+					rtt_inbound(global_rtt, pkt);
+				write_prefix(&ip->ip6_src, pick);
+				rewrite_apply(&img->edge, &ip->ip6_dst);
+				ret = SIXONE_FAST_INBOUND;
+			}
+		}
+		else {
+			old = ip->ip6_dst;
+			if(NULL != global_ct && 0 == ct_lookup(global_ct, pkt, &tracked)) {
+				ip->ip6_dst = tracked;
+				update_transport_checksum(pkt, &old, &ip->ip6_dst);
+			}
+			else {
+				rewrite_apply(&img->legacy_edge, &ip->ip6_dst);
+				fix_transport_checksum(pkt, &old, &ip->ip6_dst, img->edge_cksum[img->edge_c - 1]);
+			}
+			ret = SIXONE_FAST_INBOUND;
+		}
+	}
+	else if(0 > image_find_edge(img, &ip->ip6_dst) && 0 <= (edge = image_find_edge(img, &ip->ip6_src))) {
+		e = fast_find(fast, fast->out, &ip->ip6_dst);
+		if(NULL != e && NULL == e->list) {
+			old = ip->ip6_src;
+			rewrite_apply(&img->transit, &ip->ip6_src);
+			fix_transport_checksum(pkt, &old, &ip->ip6_src, img->edge_cksum[edge]);
+			if(NULL != global_ct)
+				ct_track(global_ct, pkt, &old);
+			ret = SIXONE_FAST_OUTBOUND;
+		}
+		else if(NULL != e && NULL != (pick = policy_pick_dst(e->list, pkt->hash))) {
+			write_prefix(&ip->ip6_dst, pick);
+			rewrite_apply(&img->transit, &ip->ip6_src);
+			set_bilateral_bit(ip, 1);
+			if(NULL != global_rtt)
+				rtt_outbound(global_rtt, pkt, pick);
+			ret = SIXONE_FAST_OUTBOUND;
+		}
+	}
+
+	pthread_rwlock_unlock(&fast->lock);
+
+	if(SIXONE_FAST_PUNT == ret) {
+		__atomic_fetch_add(&fast->punts, 1, __ATOMIC_RELAXED);
+		return ret;
+	}
+	__atomic_fetch_add(&fast->hits, 1, __ATOMIC_RELAXED);
+	forward_packet(ip);
+	return ret;
+}
+
+void fast_learn_out(sixone_fast fast, struct in6_addr *dst, ip_list list)
+{
+	ip_list copy = NULL;
+	u_int len = 128;
+
+	if(NULL != list && NULL == (copy = copy_list(list, &len)))
+		return;
+	fast_learn(fast, fast->out, dst, len, copy);
+}
+
+void fast_learn_in(sixone_fast fast, struct in6_addr *src, ip_list list)
+{
+	ip_list copy;
+	u_int len;
+
+	if(NULL == list || NULL == (copy = copy_list(list, &len)))
+		return;
+	fast_learn(fast, fast->in, src, len, copy);
+}
@@ -0,0 +1,124 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonefast.h
+ *  @brief Six-One Router fast path for established mappings
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONEFAST_H
+#define SIXONEFAST_H
+
+#include <pthread.h>
+
+#include "sixonetypes.h"
+#include "sixonelpm.h"
+#include "sixonepkt.h"
+
+/// @brief fast_path() left the packet to inbound()/outbound()
+#define SIXONE_FAST_PUNT 0
+/// @brief fast_path() rewrote and forwarded an inbound packet
+#define SIXONE_FAST_INBOUND 1
+/// @brief fast_path() rewrote and forwarded an outbound packet
+#define SIXONE_FAST_OUTBOUND 2
+/// @brief A learned mapping is used this long (us), then the slow path resolves it again and sees mapping changes
+#define SIXONE_FAST_TTL_US (30 * 1000000ULL)
+/// @brief Expired mappings are removed this often (us), when the slow path learns one
+#define SIXONE_FAST_SWEEP_US (SIXONE_FAST_TTL_US / 4)
+/// @brief Mappings a table holds at most, the slow path handles what does not fit
+#define SIXONE_FAST_MAX 65536
+
+/**
+ * @brief Tables the fast path works from
+ *
+ * The local nets come from the settings image, the mapping tables are
+ * filled by the slow path as it resolves (and routes) remote prefixes, so
+ * only established mappings take the fast path. Every entry expires
+ * SIXONE_FAST_TTL_US after it was learned; learning removes the expired
+ * ones every SIXONE_FAST_SWEEP_US, and holds each table to SIXONE_FAST_MAX.
+ */
+typedef struct sixone_fast_ {
+	sixone_image image;     /// our nets and the prefixes packets are rewritten to
+	sixone_lpm out;         /// remote edge prefix -> transit prefixes, legacy destinations (/128) -> no prefixes
+	sixone_lpm in;          /// remote transit prefix -> edge prefixes
+	u_int hits;             /// packets handled
+	u_int punts;            /// packets left to the slow path
+	u_int expired;          /// of the punts, packets whose mapping had expired
+	u_int removed;          /// expired mappings removed
+	u_int full;             /// mappings not learned, the table held SIXONE_FAST_MAX
+	u_int64_t sweep_us;     /// timers_now() the next learn removes expired mappings at
+	pthread_rwlock_t lock;  /// interface threads look up, the slow path learns
+} *sixone_fast;
+
+/// @brief The fast path, NULL when it is disabled
+extern sixone_fast global_fastpath;
+
+/**
+ *  @brief Sets up an empty fast path for the nets in settings
+ *  @return The fast path, NULL if settings has no edge or no transit net
+ */
+sixone_fast alloc_sixone_fast(sixone_settings settings);
+
+/**
+ *  @brief Frees the fast path and everything it learned
+ */
+void free_sixone_fast(sixone_fast fast);
+
+/**
+ *  @brief Forgets every learned mapping, call when the mappings change
+ */
+void fast_flush(sixone_fast fast);
+
+/**
+ *  @brief Classifies, rewrites and forwards pkt if it belongs to an established mapping.
+ *
+ *  Does what inbound()/outbound() do, without resolving or touching routes.
+ *  Unknown remote prefixes and ICMPv6 errors are punted.
+ *  @return SIXONE_FAST_INBOUND or SIXONE_FAST_OUTBOUND if the packet was forwarded, SIXONE_FAST_PUNT otherwise
+ */
+int fast_path(sixone_fast fast, sixone_pkt pkt);
+
+/**
+ *  @brief Records how the slow path resolved an outbound destination
+ *
+ *  Mappings are stored per remote edge prefix when all of list shares one
+ *  prefix length, legacy destinations per address. A mapping learned again
+ *  replaces the one there, a new one is not learned while the table is full.
+ *  @param dst The destination before rewriting
+ *  @param list The transit prefixes for dst (copied), NULL if dst is legacy
+ */
+void fast_learn_out(sixone_fast fast, struct in6_addr *dst, ip_list list);
+
+/**
+ *  @brief Records how the slow path resolved a bilateral inbound source
+ *  @param src The source before rewriting
+ *  @param list The edge prefixes for src (copied)
+ */
+void fast_learn_in(sixone_fast fast, struct in6_addr *src, ip_list list);
+
+#endif // SIXONEFAST_H
@@ -0,0 +1,207 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonefrag.c
+ *  @brief Six-One Router fragments without reassembly
+ *  @date 2026-10-19
+ */
+
+#include "sixonefrag.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+
+struct frag_stats frag_stats;
+int frag_per_thread;
+
+/// @brief The cache of a worker
+static __thread struct sixone_frag_ *frag_local;
+/// @brief The cache without workers
+static struct sixone_frag_ *frag_shared;
+
+static void frag_count(u_int *counter)
+{
+	__atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+sixone_frag frag_self()
+{
+	sixone_frag *f = frag_per_thread ? &frag_local : &frag_shared;
+	sixone_frag frag, none = NULL;
+
+	if(NULL != (frag = __atomic_load_n(f, __ATOMIC_ACQUIRE)))
+		return frag;
+	if(NULL == (frag = calloc(1, sizeof(*frag))))
+		return NULL;
+	frag->tail = &frag->head;
+	frag->shared = !frag_per_thread;
+	pthread_mutex_init(&frag->lock, NULL);
+	// the interface threads may all ask for the shared one at once, the first one wins
+	if(!__atomic_compare_exchange_n(f, &none, frag, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		pthread_mutex_destroy(&frag->lock);
+		free(frag);
+		return none;
+	}
+	return frag;
+}
+
+void frag_lock(sixone_frag frag)
+{
+	if(frag->shared)
+		pthread_mutex_lock(&frag->lock);
+}
+
+void frag_unlock(sixone_frag frag)
+{
+	if(frag->shared)
+		pthread_mutex_unlock(&frag->lock);
+}
+
+void frag_key_of(sixone_pkt pkt, struct frag_key *key)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+
+	memset(key, 0, sizeof(*key));
+	key->src = ip->ip6_src;
+	key->dst = ip->ip6_dst;
+	key->id = pkt->frag_id;
+}
+
+static struct frag_entry *frag_slot(sixone_frag frag, const struct frag_key *key)
+{
+	u_int32_t w[sizeof(*key) / 4], h = 0;
+	u_int i;
+
+	memcpy(w, key, sizeof(w));
+	for(i = 0; i < sizeof(w) / sizeof(w[0]); i++)
+		h = pkt_hash_mix(h, w[i]);
+	return &frag->slot[h & (FRAG_SLOTS - 1)];
+}
+
+/**
+ *  @brief Drops the held fragments past their deadline
+ */
+static void frag_expire(sixone_frag frag, u_int64_t now_us)
+{
+	frag_held h;
+
+	while(NULL != (h = frag->head) && now_us >= h->deadline_us) {
+		if(NULL == (frag->head = h->next))
+			frag->tail = &frag->head;
+		frag->held--;
+		frag_count(&frag_stats.expired);
+		free(h);
+	}
+}
+
+int frag_lookup(sixone_frag frag, sixone_pkt pkt, u_int64_t now_us)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct frag_entry *e;
+	struct frag_key key;
+
+	frag_expire(frag, now_us);
+	frag_key_of(pkt, &key);
+	e = frag_slot(frag, &key);
+	if(FRAG_MISS == e->fate || now_us >= e->expires_us || 0 != memcmp(&e->key, &key, sizeof(key)))
+		return FRAG_MISS;
+	if(FRAG_DROP == e->fate) {
+		frag_count(&frag_stats.dropped);
+		return FRAG_DROP;
+	}
+	ip->ip6_src = e->src;
+	ip->ip6_dst = e->dst;
+	frag_count(&frag_stats.followed);
+	return FRAG_FORWARD;
+}
+
+int frag_hold(sixone_frag frag, sixone_pkt pkt, u_int64_t now_us)
+{
+	frag_held h;
+
+	frag_expire(frag, now_us);
+	if(frag->held >= FRAG_HOLD || NULL == (h = malloc(sizeof(*h) + pkt->len))) {
+		frag_count(&frag_stats.full);
+		return -1;
+	}
+	h->next = NULL;
+	frag_key_of(pkt, &h->key);
+	h->deadline_us = now_us + FRAG_HOLD_US;
+	h->len = pkt->len;
+	memcpy(h->ip, PKT_IP6(pkt), pkt->len);
+	*frag->tail = h;
+	frag->tail = &h->next;
+	frag->held++;
+	frag_count(&frag_stats.held);
+	return 0;
+}
+
+void frag_record(sixone_frag frag, const struct frag_key *key, sixone_pkt pkt, int forwarded,
+		 u_int64_t now_us, frag_fn release)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct frag_entry *e = frag_slot(frag, key);
+	frag_held h, *pp;
+
+	e->key = *key;
+	e->fate = forwarded ? FRAG_FORWARD : FRAG_DROP;
+	e->src = ip->ip6_src;
+	e->dst = ip->ip6_dst;
+	e->expires_us = now_us + FRAG_TIMEOUT_US;
+	frag_count(&frag_stats.first);
+
+	frag_expire(frag, now_us);
+	for(pp = &frag->head; NULL != (h = *pp);) {
+		if(0 != memcmp(&h->key, key, sizeof(*key))) {
+			pp = &h->next;
+			continue;
+		}
+		if(NULL == (*pp = h->next))
+			frag->tail = pp;
+		frag->held--;
+		if(forwarded) {
+			((struct ip6_hdr *)h->ip)->ip6_src = e->src;
+			((struct ip6_hdr *)h->ip)->ip6_dst = e->dst;
+			frag_count(&frag_stats.released);
+			release((struct ip6_hdr *)h->ip);
+		}
+		else
+			frag_count(&frag_stats.dropped);
+		free(h);
+	}
+}
+
+void frag_report()
+{
+	printf("  fragments: %u first, %u followed, %u dropped with their first, %u held, %u released, %u expired, %u hold full\n",
+	       frag_stats.first, frag_stats.followed, frag_stats.dropped, frag_stats.held,
+	       frag_stats.released, frag_stats.expired, frag_stats.full);
+}
@@ -0,0 +1,190 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonefrag.h
+ *  @brief Six-One Router fragments without reassembly
+ *  @date 2026-10-19
+ *
+ *  Only the first fragment of a datagram carries the upper layer header,
+ *  so only it can be looked up by ports: a mapping picked by flow hash,
+ *  a tracked legacy flow, a checksum to update. The later fragments have
+ *  to be rewritten the same way or the datagram does not reassemble.
+ *
+ *  The first fragment goes through the packet path as any packet does,
+ *  then the cache records what became of it under (source, destination,
+ *  identification) as it arrived: the addresses it left with, or that it
+ *  was not forwarded. A later fragment with the same key gets the same
+ *  addresses written over its own and is forwarded, nothing is
+ *  reassembled or buffered. One that arrives before its first fragment
+ *  is held for FRAG_HOLD_US, at most FRAG_HOLD of them, and dropped if
+ *  the first fragment does not come.
+ *
+ *  With --workers every worker has a cache of its own, sixonerss.c
+ *  hashes all fragments of a datagram to the same worker (and a packet
+ *  the resolver parked goes back to it); without workers the interface
+ *  threads and the resolver share one cache, and take its lock around a
+ *  lookup and hold or a record (frag_lock()). Entries expire lazily: a slot
+ *  is taken over by a new datagram, a held fragment goes once a later
+ *  fragment finds it past its deadline.
+ */
+
+#ifndef SIXONEFRAG_H
+#define SIXONEFRAG_H
+
+#include <pthread.h>
+
+#include "sixonepkt.h"
+
+/// @brief Datagrams remembered per cache (a power of two)
+#define FRAG_SLOTS 1024
+/// @brief How long the fate of a first fragment applies to later ones (us)
+#define FRAG_TIMEOUT_US 10000000ULL
+/// @brief Fragments held per cache for a first fragment that has not come yet
+#define FRAG_HOLD 64
+/// @brief How long a fragment is held (us)
+#define FRAG_HOLD_US 50000ULL
+
+/// @brief No first fragment seen, hold the fragment (frag_lookup())
+#define FRAG_MISS 0
+/// @brief The first fragment was forwarded, the addresses are written
+#define FRAG_FORWARD 1
+/// @brief The first fragment was not forwarded, neither is this one
+#define FRAG_DROP 2
+
+/**
+ * @brief What identifies a datagram, as it arrived
+ */
+struct frag_key {
+	struct in6_addr src;
+	struct in6_addr dst;
+	u_int32_t id;           /// identification (network order)
+};
+
+/**
+ * @brief The fate of a first fragment
+ */
+struct frag_entry {
+	struct frag_key key;
+	u_int32_t fate;         /// FRAG_FORWARD or FRAG_DROP, FRAG_MISS for an unused slot
+	struct in6_addr src;    /// the addresses it was forwarded with
+	struct in6_addr dst;
+	u_int64_t expires_us;
+};
+
+/**
+ * @brief A fragment that came before its first fragment
+ */
+typedef struct frag_held_ *frag_held;
+struct frag_held_ {
+	frag_held next;         /// in arrival order, which is deadline order
+	struct frag_key key;
+	u_int64_t deadline_us;
+	u_int len;
+	u_char ip[];            /// the IPv6 packet
+};
+
+/**
+ * @brief A fragment cache
+ */
+typedef struct sixone_frag_ {
+	frag_held head;         /// held fragments, oldest first
+	frag_held *tail;
+	u_int held;
+	int shared;             /// the cache without workers, frag_lock() locks it
+	pthread_mutex_t lock;
+	struct frag_entry slot[FRAG_SLOTS];
+} *sixone_frag;
+
+/**
+ * @brief Counters over all caches (replay report)
+ */
+struct frag_stats {
+	u_int first;            /// first fragments recorded
+	u_int followed;         /// later fragments rewritten as their first fragment
+	u_int dropped;          /// later fragments dropped with their first fragment
+	u_int held;             /// fragments held
+	u_int released;         /// held fragments their first fragment came for
+	u_int expired;          /// held fragments dropped, the first fragment did not come
+	u_int full;             /// fragments dropped, the hold was full
+};
+
+extern struct frag_stats frag_stats;
+
+/// @brief Non-zero when every thread has a cache of its own (--workers)
+extern int frag_per_thread;
+
+/**
+ *  @brief Called with each held fragment a first fragment releases, rewritten
+ */
+typedef void (*frag_fn)(struct ip6_hdr *ip);
+
+/**
+ *  @brief The cache of the calling thread (or the shared one), created on first use
+ *  @return The cache, NULL if it could not be allocated
+ */
+sixone_frag frag_self();
+
+/**
+ *  @brief Locks the shared cache, nothing for the cache of a worker
+ */
+void frag_lock(sixone_frag frag);
+void frag_unlock(sixone_frag frag);
+
+/**
+ *  @brief The key of a fragment
+ */
+void frag_key_of(sixone_pkt pkt, struct frag_key *key);
+
+/**
+ *  @brief Looks up the first fragment of a later one and rewrites it the same way
+ *  @return FRAG_FORWARD (the addresses are written), FRAG_DROP or FRAG_MISS
+ */
+int frag_lookup(sixone_frag frag, sixone_pkt pkt, u_int64_t now_us);
+
+/**
+ *  @brief Holds a copy of a later fragment for FRAG_HOLD_US
+ *  @return 0 if it is held, -1 if the hold is full (counted, the fragment is dropped)
+ */
+int frag_hold(sixone_frag frag, sixone_pkt pkt, u_int64_t now_us);
+
+/**
+ *  @brief Records the fate of a first fragment and releases the fragments held for it
+ *  @param key The key of the fragment as it arrived (frag_key_of() before the packet path)
+ *  @param pkt The fragment after the packet path
+ *  @param forwarded Non-zero if the packet path forwarded it
+ *  @param release Sends a released fragment on
+ */
+void frag_record(sixone_frag frag, const struct frag_key *key, sixone_pkt pkt, int forwarded,
+		 u_int64_t now_us, frag_fn release);
+
+/**
+ *  @brief Prints the counters (replay report)
+ */
+void frag_report();
+
+#endif // SIXONEFRAG_H
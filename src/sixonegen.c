@@ -0,0 +1,647 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file sixonegen.c
+ *  @brief Synthetic workload generator for the Six-One Router
+ *  @date 2026-10-19
+ *
+ *  Writes a router configuration (load_settings() format), a mappings.txt
+ *  and a pcap of ethernet/IPv6 packets that exercise the router, suitable for
+ *  sixone --replay or for replaying onto an interface.
+ *  The same seed and parameters always give byte identical output.
+ *
+ *  Address plan:
+ *  @code
+ *  local edge net i     fd00:1:<i>::/64         on the edge interface
+ *  local transit net j  2001:db8:<j>::/64       on the transit interface, gw 2001:db8:<j>::fffe
+ *  remote site k        fd01:<k>::/64           (k split over two 16 bit groups)
+ *  remote transit k,t   2001:<db9+t>:<k>::/64   t < transit prefixes per remote site
+ *  legacy hosts         2001:db7::/32           below the transit space, so any -k is safe
+ *  @endcode
+ *
+ *  With -R the remote six/one sites answer the echo requests of outbound
+ *  flows, from transit prefix t of the site after the RTT given for t, so
+ *  the rtt policy (sixone --policy rtt) has something to measure. With -l
+ *  the legacy hosts answer too, to the transit address the router gave the
+ *  request, which only connection tracking takes back to the edge host.
+ *  That needs an edge net in incremental mode: a neutral one changes the
+ *  IID of the request, so the reply no longer matches it.
+ *
+ *  Transport checksums are what the hosts send: over the wire addresses,
+ *  except for bilateral packets from a six/one site, whose host summed the
+ *  edge addresses of both ends. The router rewrites those without fixing
+ *  the sum, so they leave it valid at our edge host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <pcap.h>
+
+#include <sys/types.h>
+#include <sys/socket.h> // required by ip6.h
+#include <netinet/in.h> // required by ip6.h
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+#include <netinet/udp.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+#define SIZE_ETHERNET_HDR 14
+#define GEN_MAX_PAYLOAD 9000
+/// @brief Most -R values
+#define GEN_MAX_RTT 16
+
+/**
+ * @brief One synthetic conversation
+ */
+typedef struct gen_flow_ {
+	struct in6_addr src;
+	struct in6_addr dst;
+	struct in6_addr sum_src;  /// the addresses the transport checksum covers, the edge ones of a bilateral packet
+	struct in6_addr sum_dst;
+	u_int16_t id;        /// ICMPv6 echo id or UDP source port
+	u_int16_t port;      /// UDP destination port
+	u_int16_t seq;
+	u_char bilateral;    /// set the six/one bilateral bit (flow label lsb)
+	u_char type;         /// ICMPv6 type, echo request unless this is an answer
+	u_char answered;     /// outbound to a six/one site answered with -R, or to a legacy host answered with -l
+	u_char legacy;       /// the remote end is a legacy host
+	u_int site;          /// remote site and transit prefix of an answered flow
+	u_int site_pfx;
+} *gen_flow;
+
+/**
+ * @brief An echo reply due at ts (us)
+ */
+struct gen_reply {
+	u_int64_t ts;
+	u_int flow;
+	u_int16_t seq;
+};
+
+/**
+ * @brief Scenario parameters, all of them settable from the command line
+ */
+struct gen_params {
+	u_int64_t seed;
+	u_int edge_c;        /// local edge nets
+	u_int transit_c;     /// local transit nets
+	u_int map_c;         /// remote six/one sites in mappings.txt
+	u_int map_pfx_c;     /// transit prefixes per remote site
+	u_int flow_c;
+	u_int pkt_c;
+	double bilateral;    /// fraction of flows towards/from six/one sites (rest is legacy)
+	double inbound;      /// fraction of flows arriving from transit
+	double zipf;         /// flow size skew, 0 => uniform
+	u_int payload;       /// bytes after the ICMPv6/UDP header
+	int udp;
+	u_int gap;           /// us between packets
+	u_int rtt[GEN_MAX_RTT]; /// -R, us per remote transit prefix index (cycled)
+	u_int rtt_c;
+	u_int legacy_rtt;    /// -l, us a legacy host takes to answer, 0 = they don't
+	char *edge_if;
+	char *transit_if;
+	char *dir;
+};
+
+/// @brief splitmix64 state, own generator so that a seed means the same on every libc
+static u_int64_t gen_state;
+
+static u_int64_t gen_rand()
+{
+	u_int64_t z = (gen_state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/// @brief Uniform double in [0,1)
+static double gen_uniform()
+{
+	return (gen_rand() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ *  @brief Write a 16 bit group into an address
+ *  @param addr The address
+ *  @param group Group index (0-7)
+ *  @param val Value in host byte order
+ */
+static void set_group(struct in6_addr *addr, int group, u_int16_t val)
+{
+	addr->s6_addr[group * 2] = val >> 8;
+	addr->s6_addr[group * 2 + 1] = val & 0xFF;
+}
+
+static struct in6_addr local_edge(u_int i)
+{
+	struct in6_addr a;
+	memset(&a, 0, sizeof(a));
+	set_group(&a, 0, 0xfd00);
+	set_group(&a, 1, 1);
+	set_group(&a, 2, i);
+	return a;
+}
+
+static struct in6_addr local_transit(u_int j)
+{
+	struct in6_addr a;
+	memset(&a, 0, sizeof(a));
+	set_group(&a, 0, 0x2001);
+	set_group(&a, 1, 0xdb8);
+	set_group(&a, 2, j);
+	return a;
+}
+
+static struct in6_addr remote_edge(u_int k)
+{
+	struct in6_addr a;
+	memset(&a, 0, sizeof(a));
+	set_group(&a, 0, 0xfd01);
+	set_group(&a, 1, k >> 16);
+	set_group(&a, 2, k & 0xFFFF);
+	return a;
+}
+
+static struct in6_addr remote_transit(u_int k, u_int t)
+{
+	struct in6_addr a;
+	memset(&a, 0, sizeof(a));
+	set_group(&a, 0, 0x2001);
+	set_group(&a, 1, 0xdb9 + t);
+	set_group(&a, 2, k >> 16);
+	set_group(&a, 3, k & 0xFFFF);
+	return a;
+}
+
+/// @brief Fill the interface identifier (lower 64 bits) with random bits
+static void random_host(struct in6_addr *a)
+{
+	u_int64_t h = gen_rand();
+	int i;
+	for(i = 0; i < 8; i++)
+		a->s6_addr[8 + i] = h >> (8 * i);
+}
+
+/**
+ *  @brief Standard one's complement sum, used for the transport checksums
+ */
+static u_int32_t gen_sum(u_int32_t sum, const void *_p, u_int len)
+{
+	const u_char *p = _p;
+	while(len > 1) {
+		sum += (p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+	}
+	if(len)
+		sum += p[0] << 8;
+	return sum;
+}
+
+static u_int16_t gen_fold(u_int32_t sum)
+{
+	while(sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	return sum;
+}
+
+/**
+ *  @brief Build the ethernet/IPv6/transport packet of a flow into buf
+ *  @return total packet length
+ */
+static u_int build_packet(u_char *buf, struct gen_params *p, gen_flow f)
+{
+	struct ether_header *eth = (struct ether_header *) buf;
+	struct ip6_hdr *ip = (struct ip6_hdr *) (eth + 1);
+	u_char *l4 = (u_char *) (ip + 1);
+	u_int l4_len = (p->udp ? sizeof(struct udphdr) : sizeof(struct icmp6_hdr)) + p->payload;
+	u_int32_t sum;
+	u_int16_t cksum;
+	u_int i;
+
+	memset(buf, 0, SIZE_ETHERNET_HDR + sizeof(*ip) + l4_len);
+
+	memcpy(eth->ether_dhost, "\x02\x00\x00\x00\x00\x01", ETHER_ADDR_LEN);
+	memcpy(eth->ether_shost, "\x02\x00\x00\x00\x00\x02", ETHER_ADDR_LEN);
+	eth->ether_type = htons(ETHERTYPE_IPV6);
+
+	ip->ip6_flow = htonl(0x60000000 | ((u_int32_t)f->id << 1) | f->bilateral);
+	ip->ip6_plen = htons(l4_len);
+	ip->ip6_nxt = p->udp ? IPPROTO_UDP : IPPROTO_ICMPV6;
+	ip->ip6_hlim = 64;
+	ip->ip6_src = f->src;
+	ip->ip6_dst = f->dst;
+
+	if(p->udp) {
+		struct udphdr *udp = (struct udphdr *) l4;
+		udp->uh_sport = htons(f->id);
+		udp->uh_dport = htons(f->port);
+		udp->uh_ulen = htons(l4_len);
+	}
+	else {
+		struct icmp6_hdr *icmp = (struct icmp6_hdr *) l4;
+		icmp->icmp6_type = f->type;
+		icmp->icmp6_id = htons(f->id);
+		icmp->icmp6_seq = htons(f->seq);
+	}
+	f->seq++;
+
+	// recognizable, but seq dependent, payload
+	for(i = 0; i < p->payload; i++)
+		l4[l4_len - p->payload + i] = (u_char)(i + f->seq);
+
+	// a six/one peer's host sums its own edge addresses, both routers rewrite without fixing it
+	sum = gen_sum(0, &f->sum_src, sizeof(f->sum_src));
+	sum = gen_sum(sum, &f->sum_dst, sizeof(f->sum_dst));
+	sum += l4_len + ip->ip6_nxt;
+	sum = gen_sum(sum, l4, l4_len);
+	cksum = htons(~gen_fold(sum));
+
+	if(p->udp)
+		((struct udphdr *) l4)->uh_sum = cksum ? cksum : 0xFFFF;
+	else
+		((struct icmp6_hdr *) l4)->icmp6_cksum = cksum;
+
+	return SIZE_ETHERNET_HDR + sizeof(*ip) + l4_len;
+}
+
+/**
+ *  @brief The edge addresses of a bilateral packet from site k, as the hosts at both ends know them
+ *
+ *  The router restores the source to the site's edge prefix and the
+ *  destination to our last edge net, keeping the interface identifiers.
+ */
+static void edge_side(struct gen_params *p, gen_flow f, u_int k)
+{
+	struct in6_addr src = remote_edge(k), dst = local_edge(p->edge_c - 1);
+
+	memcpy(&f->sum_src.s6_addr[0], &src.s6_addr[0], 8);
+	memcpy(&f->sum_dst.s6_addr[0], &dst.s6_addr[0], 8);
+}
+
+/**
+ *  @brief Pick a random remote host of one of the four flow kinds
+ */
+static void make_flow(struct gen_params *p, gen_flow f)
+{
+	int upgraded = gen_uniform() < p->bilateral && p->map_c > 0;
+	int in = gen_uniform() < p->inbound;
+	u_int k = p->map_c ? gen_rand() % p->map_c : 0;
+	u_int t = gen_rand() % p->map_pfx_c;
+	struct in6_addr legacy;
+
+	memset(&legacy, 0, sizeof(legacy));
+	set_group(&legacy, 0, 0x2001);
+	set_group(&legacy, 1, 0xdb7);
+	set_group(&legacy, 2, gen_rand());
+
+	if(in) {
+		// from transit, to one of our transit nets
+		f->src = upgraded ? remote_transit(k, t) : legacy;
+		f->dst = local_transit(gen_rand() % p->transit_c);
+	}
+	else {
+		// from one of our edge nets, to a remote edge or a legacy host
+		f->src = local_edge(gen_rand() % p->edge_c);
+		f->dst = upgraded ? remote_edge(k) : legacy;
+	}
+	random_host(&f->src);
+	random_host(&f->dst);
+
+	f->bilateral = in && upgraded;
+	f->sum_src = f->src;
+	f->sum_dst = f->dst;
+	if(f->bilateral)
+		edge_side(p, f, k);
+	f->type = ICMP6_ECHO_REQUEST;
+	f->answered = !in && !p->udp && (upgraded ? p->rtt_c > 0 : p->legacy_rtt > 0);
+	f->legacy = !upgraded;
+	f->site = k;
+	f->site_pfx = t;
+	f->id = gen_rand();
+	f->port = 1024 + gen_rand() % 64512;
+	f->seq = 0;
+}
+
+static FILE* open_out(char *dir, char *name)
+{
+	char path[1024];
+	FILE *fh;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	if(NULL == (fh = fopen(path, "w"))) {
+		printf("Cannot open file. %s\n", path);
+		exit(1);
+	}
+	return fh;
+}
+
+static char *ntop(struct in6_addr a, char *buf)
+{
+	return (char *) inet_ntop(AF_INET6, &a, buf, INET6_ADDRSTRLEN);
+}
+
+static void write_config(struct gen_params *p)
+{
+	FILE *fh = open_out(p->dir, "sixone.config");
+	struct in6_addr gw;
+	char a[INET6_ADDRSTRLEN], b[INET6_ADDRSTRLEN];
+	u_int i;
+
+	fprintf(fh, "# sixonegen seed=%llu edge=%u transit=%u\n", (unsigned long long)p->seed, p->edge_c, p->transit_c);
+	fprintf(fh, "[%s]\n", p->edge_if);
+	for(i = 0; i < p->edge_c; i++)
+		fprintf(fh, "Edge= %s 64\n", ntop(local_edge(i), a));
+
+	fprintf(fh, "[%s]\n", p->transit_if);
+	for(i = 0; i < p->transit_c; i++) {
+		gw = local_transit(i);
+		set_group(&gw, 7, 0xfffe);
+		fprintf(fh, "Transit= %s 64 %s\n", ntop(local_transit(i), a), ntop(gw, b));
+	}
+	fclose(fh);
+}
+
+static void write_mappings(struct gen_params *p)
+{
+	FILE *fh = open_out(p->dir, "mappings.txt");
+	char a[INET6_ADDRSTRLEN], b[INET6_ADDRSTRLEN];
+	u_int k, t;
+
+	// multihomed sites get weights 1..k, so the multipath policy has something to balance
+	for(k = 0; k < p->map_c; k++)
+		for(t = 0; t < p->map_pfx_c; t++)
+			if(1 == p->map_pfx_c)
+				fprintf(fh, "%s/64\t%s\n", ntop(remote_edge(k), a), ntop(remote_transit(k, t), b));
+			else
+				fprintf(fh, "%s/64\t%s\t%u\n", ntop(remote_edge(k), a), ntop(remote_transit(k, t), b), t + 1);
+	fclose(fh);
+}
+
+/**
+ *  @brief Min-heap (on ts) push
+ */
+static void reply_push(struct gen_reply *heap, u_int *n, struct gen_reply r)
+{
+	u_int i = (*n)++;
+
+	for(; i > 0 && heap[(i - 1) / 2].ts > r.ts; i = (i - 1) / 2)
+		heap[i] = heap[(i - 1) / 2];
+	heap[i] = r;
+}
+
+/**
+ *  @brief Min-heap pop, n must not be 0
+ */
+static struct gen_reply reply_pop(struct gen_reply *heap, u_int *n)
+{
+	struct gen_reply top = heap[0], last = heap[--(*n)];
+	u_int i = 0, c;
+
+	while((c = 2 * i + 1) < *n) {
+		if(c + 1 < *n && heap[c + 1].ts < heap[c].ts)
+			c++;
+		if(last.ts <= heap[c].ts)
+			break;
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = last;
+	return top;
+}
+
+/**
+ *  @brief Write the echo reply of the site (or legacy host) to request seq of flow f
+ */
+static void write_reply(struct gen_params *p, pcap_dumper_t *dump, u_char *buf, gen_flow f, struct gen_reply *r)
+{
+	struct gen_flow_ reply;
+	struct pcap_pkthdr hdr;
+	u_int i;
+
+	// from the site's transit prefix (or the legacy host) to our (last) transit net, as the router rewrote the request
+	memset(&reply, 0, sizeof(reply));
+	reply.src = f->legacy ? f->dst : remote_transit(f->site, f->site_pfx);
+	reply.dst = local_transit(p->transit_c - 1);
+	for(i = 8; i < 16; i++) {
+		reply.src.s6_addr[i] = f->dst.s6_addr[i];
+		reply.dst.s6_addr[i] = f->src.s6_addr[i];
+	}
+	reply.id = f->id;
+	reply.seq = r->seq;
+	reply.bilateral = !f->legacy;
+	reply.type = ICMP6_ECHO_REPLY;
+	reply.sum_src = reply.src;
+	reply.sum_dst = reply.dst;
+	if(!f->legacy)
+		edge_side(p, &reply, f->site);
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.caplen = hdr.len = build_packet(buf, p, &reply);
+	hdr.ts.tv_sec = r->ts / 1000000;
+	hdr.ts.tv_usec = r->ts % 1000000;
+	pcap_dump((u_char *) dump, &hdr, buf);
+}
+
+static void write_pcap(struct gen_params *p)
+{
+	struct gen_flow_ *flows;
+	double *cdf, total = 0;
+	u_char *buf;
+	pcap_t *dead;
+	pcap_dumper_t *dump;
+	struct pcap_pkthdr hdr;
+	char path[1024];
+	struct gen_reply *heap, r;
+	u_int i, lo, hi, mid, heap_c = 0;
+	u_int64_t ts;
+	double u;
+
+	flows = calloc(p->flow_c, sizeof(*flows));
+	cdf = calloc(p->flow_c, sizeof(*cdf));
+	buf = malloc(SIZE_ETHERNET_HDR + sizeof(struct ip6_hdr) + sizeof(struct udphdr) + GEN_MAX_PAYLOAD);
+	heap = calloc(p->pkt_c + 1, sizeof(*heap));
+	if(NULL == flows || NULL == cdf || NULL == buf || NULL == heap) {
+		printf("Could not malloc() flow table\n");
+		exit(1);
+	}
+
+	// flow i gets a share of 1/(i+1)^zipf of the packets
+	for(i = 0; i < p->flow_c; i++) {
+		make_flow(p, &flows[i]);
+		total += 1.0 / pow(i + 1, p->zipf);
+		cdf[i] = total;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", p->dir, "workload.pcap");
+	dead = pcap_open_dead(DLT_EN10MB, 65535);
+	if(NULL == (dump = pcap_dump_open(dead, path))) {
+		printf("Cannot open dump %s: %s\n", path, pcap_geterr(dead));
+		exit(1);
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	for(i = 0; i < p->pkt_c; i++) {
+		u = gen_uniform() * total;
+		lo = 0;
+		hi = p->flow_c - 1;
+		while(lo < hi) {
+			mid = (lo + hi) / 2;
+			if(cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		// answers due by now go first, the capture is in time order
+		ts = (u_int64_t)i * p->gap;
+		while(heap_c > 0 && heap[0].ts <= ts) {
+			r = reply_pop(heap, &heap_c);
+			write_reply(p, dump, buf, &flows[r.flow], &r);
+		}
+
+		if(flows[lo].answered) {
+			r.ts = ts + (flows[lo].legacy ? p->legacy_rtt : p->rtt[flows[lo].site_pfx % p->rtt_c]);
+			r.flow = lo;
+			r.seq = flows[lo].seq;
+			reply_push(heap, &heap_c, r);
+		}
+
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.caplen = hdr.len = build_packet(buf, p, &flows[lo]);
+		hdr.ts.tv_sec = ts / 1000000;
+		hdr.ts.tv_usec = ts % 1000000;
+		pcap_dump((u_char *) dump, &hdr, buf);
+	}
+	while(heap_c > 0) {
+		r = reply_pop(heap, &heap_c);
+		write_reply(p, dump, buf, &flows[r.flow], &r);
+	}
+
+	pcap_dump_close(dump);
+	pcap_close(dead);
+	free(heap);
+	free(buf);
+	free(cdf);
+	free(flows);
+}
+
+static void usage(char *name)
+{
+	printf("Usage: %s [options]\n", name);
+	printf("  -s seed          random seed (1)\n");
+	printf("  -e edge nets     local edge nets (1)\n");
+	printf("  -t transit nets  local transit nets (1)\n");
+	printf("  -m sites         remote six/one sites in mappings.txt (1000)\n");
+	printf("  -k prefixes      transit prefixes per remote site, weighted 1..k (1)\n");
+	printf("  -f flows         number of flows (1000)\n");
+	printf("  -n packets       number of packets (100000)\n");
+	printf("  -b fraction      bilateral (six/one) share of the flows (0.5)\n");
+	printf("  -i fraction      inbound share of the flows (0.5)\n");
+	printf("  -z exponent      zipf exponent of the flow sizes, 0 = uniform (1.0)\n");
+	printf("  -p bytes         payload size (56)\n");
+	printf("  -u               UDP instead of ICMPv6 echo\n");
+	printf("  -g us            time between packets (1)\n");
+	printf("  -R ms[,ms...]    six/one sites answer echo requests after ms, per transit prefix (off)\n");
+	printf("  -l ms            legacy hosts answer echo requests after ms (off)\n");
+	printf("  -E ifname        edge interface name (em0)\n");
+	printf("  -T ifname        transit interface name (em1)\n");
+	printf("  -o dir           output directory (.)\n");
+	exit(2);
+}
+
+/**
+ *  @brief Generate sixone.config, mappings.txt and workload.pcap
+ */
+int main(int argc, char *argv[])
+{
+	struct gen_params p;
+	char *ms;
+	int c;
+
+	memset(&p, 0, sizeof(p));
+	p.seed = 1;
+	p.edge_c = p.transit_c = 1;
+	p.map_c = 1000;
+	p.map_pfx_c = 1;
+	p.flow_c = 1000;
+	p.pkt_c = 100000;
+	p.bilateral = p.inbound = 0.5;
+	p.zipf = 1.0;
+	p.payload = 56;
+	p.gap = 1;
+	p.edge_if = "em0";
+	p.transit_if = "em1";
+	p.dir = ".";
+
+	while(-1 != (c = getopt(argc, argv, "s:e:t:m:k:f:n:b:i:z:p:ug:R:l:E:T:o:h"))) {
+		switch(c) {
+		case 's': p.seed = strtoull(optarg, NULL, 0); break;
+		case 'e': p.edge_c = atoi(optarg); break;
+		case 't': p.transit_c = atoi(optarg); break;
+		case 'm': p.map_c = atoi(optarg); break;
+		case 'k': p.map_pfx_c = atoi(optarg); break;
+		case 'f': p.flow_c = atoi(optarg); break;
+		case 'n': p.pkt_c = atoi(optarg); break;
+		case 'b': p.bilateral = atof(optarg); break;
+		case 'i': p.inbound = atof(optarg); break;
+		case 'z': p.zipf = atof(optarg); break;
+		case 'p': p.payload = atoi(optarg); break;
+		case 'u': p.udp = 1; break;
+		case 'g': p.gap = atoi(optarg); break;
+		case 'R':
+			for(ms = strtok(optarg, ","); NULL != ms && p.rtt_c < GEN_MAX_RTT; ms = strtok(NULL, ","))
+				p.rtt[p.rtt_c++] = atof(ms) * 1000;
+			break;
+		case 'l': p.legacy_rtt = atof(optarg) * 1000; break;
+		case 'E': p.edge_if = optarg; break;
+		case 'T': p.transit_if = optarg; break;
+		case 'o': p.dir = optarg; break;
+		default: usage(argv[0]);
+		}
+	}
+
+	if(optind != argc || 0 == p.edge_c || 0 == p.transit_c || 0 == p.map_pfx_c
+	   || 0 == p.flow_c || p.edge_c > 0xFFFF || p.transit_c > 0xFFFF
+	   || p.map_pfx_c > 0xFF || p.payload > GEN_MAX_PAYLOAD)
+		usage(argv[0]);
+
+	gen_state = p.seed;
+
+	write_config(&p);
+	write_mappings(&p);
+	write_pcap(&p);
+
+	printf("%s: seed %llu, %u edge, %u transit nets, %u mappings, %u flows, %u packets written to %s\n",
+	       argv[0], (unsigned long long)p.seed, p.edge_c, p.transit_c,
+	       p.map_c * p.map_pfx_c, p.flow_c, p.pkt_c, p.dir);
+	return 0;
+}
@@ -0,0 +1,188 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneicmp.c
+ *  @brief Six-One Router ICMPv6 error generation
+ *  @date 2026-10-19
+ */
+
+#include "sixoneicmp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+
+#include "sixonecksum.h"
+
+sixone_icmp global_icmp;
+
+/// @brief A whole token in the millionths a bucket counts
+#define ICMP_TOKEN 1000000ULL
+
+sixone_icmp alloc_sixone_icmp(u_int rate)
+{
+	sixone_icmp icmp;
+	u_int i;
+
+	if(NULL == (icmp = calloc(1, sizeof(*icmp))))
+		return NULL;
+	icmp->rate = 0 == rate ? 1 : rate;
+	icmp->all.tokens = ICMP_RATE_ALL * ICMP_TOKEN;
+	for(i = 0; i < ICMP_BUCKETS; i++)
+		icmp->bucket[i].tokens = icmp->rate * ICMP_TOKEN;
+	pthread_mutex_init(&icmp->lock, NULL);
+	return icmp;
+}
+
+void free_sixone_icmp(sixone_icmp icmp)
+{
+	if(NULL == icmp)
+		return;
+	pthread_mutex_destroy(&icmp->lock);
+	free(icmp);
+}
+
+/**
+ *  @brief Refills a bucket of rate tokens a second (and as many at most) up to now
+ *  @return 0 if it holds a whole token
+ */
+static int icmp_refill(struct icmp_bucket *b, u_int rate, u_int64_t now_us)
+{
+	u_int64_t full = rate * ICMP_TOKEN;
+
+	// another thread's clock may be a little behind, that is no time at all
+	if(now_us > b->stamp_us) {
+		if(now_us - b->stamp_us >= 1000000ULL)
+			b->tokens = full;
+		else if((b->tokens += (now_us - b->stamp_us) * rate) > full)
+			b->tokens = full;
+		b->stamp_us = now_us;
+	}
+	return b->tokens >= ICMP_TOKEN ? 0 : -1;
+}
+
+int icmp_allow(sixone_icmp icmp, sixone_pkt pkt, u_int64_t now_us)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct icmp_bucket *b;
+	u_int32_t w[2];
+	u_int64_t pfx;
+	int ret = -1;
+
+	// RFC 4443 2.4 (e): not about an error, not to a source that cannot be replied to
+	if(IN6_IS_ADDR_UNSPECIFIED(&ip->ip6_src) || IN6_IS_ADDR_MULTICAST(&ip->ip6_src) ||
+	   (IPPROTO_ICMPV6 == pkt->proto && 0 != pkt->l4_off && pkt->icmp_type < ICMP6_ECHO_REQUEST)) {
+		pthread_mutex_lock(&icmp->lock);
+		icmp->refused++;
+		pthread_mutex_unlock(&icmp->lock);
+		return -1;
+	}
+
+	memcpy(&pfx, ip->ip6_src.s6_addr, sizeof(pfx));
+	memcpy(w, &pfx, sizeof(w));
+	pthread_mutex_lock(&icmp->lock);
+	b = &icmp->bucket[pkt_hash_mix(pkt_hash_mix(0, w[0]), w[1]) & (ICMP_BUCKETS - 1)];
+	if(b->pfx != pfx) {
+		b->pfx = pfx;
+		b->stamp_us = now_us;
+		b->tokens = icmp->rate * ICMP_TOKEN;
+	}
+	if(0 != icmp_refill(b, icmp->rate, now_us))
+		icmp->limited++;
+	else if(0 != icmp_refill(&icmp->all, ICMP_RATE_ALL, now_us))
+		icmp->limited_all++;
+	else {
+		b->tokens -= ICMP_TOKEN;
+		icmp->all.tokens -= ICMP_TOKEN;
+		icmp->sent++;
+		ret = 0;
+	}
+	pthread_mutex_unlock(&icmp->lock);
+	return ret;
+}
+
+int icmp_source(sixone_image image, const struct ip6_hdr *ip, struct in6_addr *src)
+{
+	int i;
+
+	if(0 <= (i = image_find_edge(image, &ip->ip6_src)))
+		*src = image->edge_self[i];
+	else if(0 <= (i = image_find_transit(image, &ip->ip6_dst)))
+		*src = image->transit_self[i];
+	else if(0 != image->transit_c)
+		*src = image->transit_self[0];
+	else if(0 != image->edge_c)
+		*src = image->edge_self[0];
+	else
+		return -1;
+	return 0;
+}
+
+u_int icmp_packet_too_big(u_char *buf, const struct in6_addr *src, sixone_pkt pkt, u_int32_t mtu)
+{
+	struct ip6_hdr *ip = (struct ip6_hdr *)buf;
+	struct icmp6_hdr *icmp = (struct icmp6_hdr *)(ip + 1);
+	u_int quote = pkt->len, plen;
+	u_int16_t sum;
+
+	// as much of the invoking packet as fits in the minimum MTU, never past what was captured
+	if(quote > ICMP_ERROR_MAX - sizeof(*ip) - sizeof(*icmp))
+		quote = ICMP_ERROR_MAX - sizeof(*ip) - sizeof(*icmp);
+	if(quote > pkt->caplen - pkt->l3_off)
+		quote = pkt->caplen - pkt->l3_off;
+	plen = sizeof(*icmp) + quote;
+
+	memset(ip, 0, sizeof(*ip));
+	ip->ip6_flow = htonl(6 << 28);
+	ip->ip6_plen = htons(plen);
+	ip->ip6_nxt = IPPROTO_ICMPV6;
+	ip->ip6_hlim = 255;
+	ip->ip6_src = *src;
+	ip->ip6_dst = PKT_IP6(pkt)->ip6_src;
+
+	memset(icmp, 0, sizeof(*icmp));
+	icmp->icmp6_type = ICMP6_PACKET_TOO_BIG;
+	icmp->icmp6_mtu = htonl(mtu);
+	memcpy(icmp + 1, PKT_IP6(pkt), quote);
+
+	// pseudo header: the addresses, the upper layer length and the next header
+	sum = checksum(IPPROTO_ICMPV6, &ip->ip6_src, 2 * sizeof(struct in6_addr));
+	sum = checksum(sum, &ip->ip6_plen, sizeof(ip->ip6_plen));
+	sum = checksum(sum, icmp, plen);
+	icmp->icmp6_cksum = htons(~sum);
+	return sizeof(*ip) + plen;
+}
+
+void icmp_report(sixone_icmp icmp)
+{
+	printf("  icmp: %u errors sent, %u rate limited (%u per source, %u overall), %u not allowed\n",
+	       icmp->sent, icmp->limited + icmp->limited_all, icmp->limited, icmp->limited_all, icmp->refused);
+}
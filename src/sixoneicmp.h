@@ -0,0 +1,128 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneicmp.h
+ *  @brief Six-One Router ICMPv6 error generation
+ *  @date 2026-10-19
+ *
+ *  Errors are built in a buffer of their own (RFC 4443): the IPv6 header,
+ *  the ICMPv6 header and as much of the invoking packet as fits in the
+ *  minimum MTU, with the checksum over the pseudo header. They are sent
+ *  from our address in the net the invoking packet came from, the edge
+ *  net of its source or the transit net of its destination.
+ *
+ *  Every source /64 has a token bucket, ICMP_RATE errors a second with a
+ *  burst as large, and all sources share one more of ICMP_RATE_ALL. A
+ *  flood of oversized packets then costs the link at most ICMP_RATE_ALL
+ *  errors a second, and one source cannot use them up for the others.
+ *  The buckets are a fixed table indexed by a hash of the prefix, a new
+ *  prefix takes over the bucket of the one it collides with.
+ */
+
+#ifndef SIXONEICMP_H
+#define SIXONEICMP_H
+
+#include <pthread.h>
+
+#include "sixonepkt.h"
+#include "sixonetypes.h"
+
+/// @brief An ICMPv6 error with its quote fits in this (IPv6 minimum MTU)
+#define ICMP_ERROR_MAX 1280
+/// @brief Errors a second each source /64 gets by default (--icmp-rate)
+#define ICMP_RATE 10
+/// @brief Errors a second all sources together get
+#define ICMP_RATE_ALL 1000
+/// @brief Source prefixes limited at once (a power of two)
+#define ICMP_BUCKETS 4096
+
+/**
+ * @brief A token bucket, tokens in millionths so a microsecond of refill is exact
+ */
+struct icmp_bucket {
+	u_int64_t pfx;          /// the /64 it limits (the first 8 bytes as found in the address)
+	u_int64_t stamp_us;     /// the last refill
+	u_int64_t tokens;       /// millionths of a token
+};
+
+/**
+ * @brief The rate limiter of the errors the router sends
+ */
+typedef struct sixone_icmp_ {
+	u_int rate;             /// errors a second per source /64, the burst is as large
+	pthread_mutex_t lock;   /// the buckets
+	struct icmp_bucket all; /// shared by every source
+	u_int sent;             /// errors sent
+	u_int limited;          /// errors not sent, their source was over its rate
+	u_int limited_all;      /// errors not sent, all sources together were over ICMP_RATE_ALL
+	u_int refused;          /// no error allowed (an error about an error, unspecified or multicast source)
+	struct icmp_bucket bucket[ICMP_BUCKETS];
+} *sixone_icmp;
+
+/// @brief The ICMPv6 error limiter, NULL when the router sends no errors
+extern sixone_icmp global_icmp;
+
+/**
+ *  @brief Allocates a limiter with full buckets
+ *  @param rate Errors a second per source /64
+ *  @return The limiter, NULL if it could not be allocated
+ */
+sixone_icmp alloc_sixone_icmp(u_int rate);
+
+void free_sixone_icmp(sixone_icmp icmp);
+
+/**
+ *  @brief Checks that an error may be sent about pkt at all and takes a token for it
+ *  @param now_us The clock the buckets refill on (timers_now())
+ *  @return 0 if the error may be sent, -1 if not (counted as refused or limited)
+ */
+int icmp_allow(sixone_icmp icmp, sixone_pkt pkt, u_int64_t now_us);
+
+/**
+ *  @brief Our address to send an error about a packet from
+ *  @param ip The invoking packet
+ *  @param src Set to the address
+ *  @return 0 on success, -1 if the image has no nets
+ */
+int icmp_source(sixone_image image, const struct ip6_hdr *ip, struct in6_addr *src);
+
+/**
+ *  @brief Builds a Packet Too Big message about pkt
+ *  @param buf At least ICMP_ERROR_MAX bytes, the IPv6 header is written at the start
+ *  @param src The source of the message (icmp_source())
+ *  @param mtu The MTU of the link the packet did not fit
+ *  @return Bytes written (IPv6 header included)
+ */
+u_int icmp_packet_too_big(u_char *buf, const struct in6_addr *src, sixone_pkt pkt, u_int32_t mtu);
+
+/**
+ *  @brief Prints the limiter counters (replay report)
+ */
+void icmp_report(sixone_icmp icmp);
+
+#endif // SIXONEICMP_H
@@ -44,6 +44,7 @@
 
 #include "sixonelib.h"
 #include "sixonetypes.h"
+#include "sixoneload.h"
 
 #include <pcap.h>
 
@@ -70,33 +71,121 @@
 #include <pthread.h>
 
 #include <stdarg.h>
+#include <time.h>
 
-/// @brief DBG enable/disable debug output (should be an #ifdef really)
+/// @brief DBG enable/disable debug output, build with -DDBG=0 to silence it (e.g. for --replay measurements)
+#ifndef DBG
 #define DBG 1
-#ifdef DBG
+#endif
 #include "debug_pktheaders.h"
+#if DBG
 /// @brief DBG_P macro for debug printouts
 #define DBG_P( ... ) (printf("%s :: %d :: %s():: " , __FILE__, __LINE__, __FUNCTION__), printf(__VA_ARGS__) )
-//#define DBG_P // 
+#else
+#define DBG_P( ... ) ((void)0)
 #endif
 
 
 // Ethernet headers are allways 14 bytes long
 #define SIZE_ETHERNET_HDR 14
-#define SIXONE_MTU 12000
 #define ICMPV6_HDR_LEN 4
 
 /// @brief set IP version (currently only supporting 6)
 #define IP 6
 
+sixone_settings global_settings;
 char sixone_errbuf[PCAP_ERRBUF_SIZE];
 pcap_t **sixone_pcap_handles;
 u_int sixone_pcap_handles_count;
 pthread_t *sixone_threads;
 u_int sixone_threads_count;
-u_int sixone_packet_count;
 sixone_settings global_sixone_settings;
 
+/**
+ * @brief The packet counters of one thread, the reports add them up
+ *
+ * Every thread that runs packets (interface threads, workers, the async
+ * resolver releasing parked packets) counts into its own, so counting
+ * takes no lock and no shared cache line.
+ */
+struct sixone_counts {
+	u_int packets;
+	u_int inbound;
+	u_int outbound;
+	u_int ignored;
+	u_int malformed;
+	u_int hairpin;              /// packets hairpin() forwarded between edge nets
+	u_int hairpin_rewritten;    /// of them, packets to a transit address
+	u_int forwarded;            /// packets forward_packet() sent, process_packet() tells a forwarded first fragment by it
+	u_int unmapped;             /// packets dropped, their mapping went away between the lookups (replication)
+	u_int64_t replay_ns[4];     /// --replay processing time per direction (inbound, outbound, hairpin, other)
+	struct sixone_counts *next;
+};
+
+/// @brief The counters of this thread
+static __thread struct sixone_counts *sixone_counts_local;
+/// @brief The counters of every thread, linked in by counts_self()
+static struct sixone_counts *sixone_counts_all;
+static pthread_mutex_t sixone_counts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// @brief Dump that forward_packet() writes to in --replay mode (NULL when running live)
+pcap_dumper_t *sixone_replay_dumper;
+/// @brief Writes to the dump, a packet is two writes
+static pthread_mutex_t sixone_replay_lock = PTHREAD_MUTEX_INITIALIZER;
+/// @brief pcap header of the packet this thread is running (timestamp for the dump)
+static __thread const struct pcap_pkthdr *sixone_replay_hdr;
+
+/**
+ *  @brief The counters of the calling thread
+ */
+static struct sixone_counts *counts_self()
+{
+	struct sixone_counts *c = sixone_counts_local;
+
+	if(NULL != c)
+		return c;
+	if(NULL == (c = calloc(1, sizeof(*c)))) {
+		printf("Could not malloc()\n");
+		exit(1);
+	}
+	pthread_mutex_lock(&sixone_counts_lock);
+	c->next = sixone_counts_all;
+	sixone_counts_all = c;
+	pthread_mutex_unlock(&sixone_counts_lock);
+	return sixone_counts_local = c;
+}
+
+/**
+ *  @brief Adds up the counters of every thread into sum, zeroes them with reset set
+ */
+static void counts_sum(struct sixone_counts *sum, int reset)
+{
+	struct sixone_counts *c, *next;
+	u_int i;
+
+	memset(sum, 0, sizeof(*sum));
+	pthread_mutex_lock(&sixone_counts_lock);
+	for(c = sixone_counts_all; NULL != c; c = c->next) {
+		sum->packets += c->packets;
+		sum->inbound += c->inbound;
+		sum->outbound += c->outbound;
+		sum->ignored += c->ignored;
+		sum->malformed += c->malformed;
+		sum->hairpin += c->hairpin;
+		sum->hairpin_rewritten += c->hairpin_rewritten;
+		sum->forwarded += c->forwarded;
+		sum->unmapped += c->unmapped;
+		for(i = 0; i < 4; i++)
+			sum->replay_ns[i] += c->replay_ns[i];
+		if(reset) {
+			next = c->next;
+			memset(c, 0, sizeof(*c));
+			c->next = next;
+		}
+	}
+	pthread_mutex_unlock(&sixone_counts_lock);
+}
+
 u_int start_sixone(sixone_settings settings)
 {
 	int i, j,rc;
@@ -111,7 +200,6 @@ u_int start_sixone(sixone_settings settings)
 
 	global_settings = settings;
 	print_settings(global_settings);
-	sixone_packet_count = 0;
 
 	// Init out interface
 	global_settings->out_fd = sixone_start_out_if();
@@ -156,6 +244,141 @@ u_int start_sixone(sixone_settings settings)
 	return 0;
 }
 
+/// @brief Number of replayed packets skipped because they were truncated in the capture
+static u_int sixone_replay_truncated;
+
+/**
+ *  @brief pcap_loop() callback for --replay, got_packet() times the packet wherever it runs
+ */
+static void replay_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
+{
+	if(header->caplen < header->len) {
+		sixone_replay_truncated++;
+		return;
+	}
+
+	// the dispatcher only queues, the worker times the packet
+	if(NULL != global_rss)
+		rss_dispatch(global_rss, got_packet, args, header, packet);
+	else
+		got_packet(args, header, packet);
+}
+
+/**
+ *  @brief Print one line of the --replay report
+ */
+static void replay_report(const char *what, u_int pkts, u_int64_t ns)
+{
+	printf("  %-9s %10u pkts %10.1f ns/pkt\n", what, pkts, pkts ? (double)ns / pkts : 0.0);
+}
+
+u_int replay_sixone(sixone_settings settings, char *in_file, char *out_file)
+{
+	pcap_t *in, *out;
+	u_char** set_n_if;
+	struct timespec start, end;
+	struct sixone_counts sum;
+	double secs;
+	u_int other;
+
+	global_settings = settings;
+	if(0 == global_settings->if_c) {
+		fprintf(stderr, "No interfaces configured, nothing to replay against\n");
+		return 2;
+	}
+
+	in = pcap_open_offline(in_file, sixone_errbuf);
+	if(NULL == in) {
+		fprintf(stderr, "Couldn't open capture %s: %s\n", in_file, sixone_errbuf);
+		return 2;
+	}
+	if(DLT_EN10MB != pcap_datalink(in)) {
+		fprintf(stderr, "Capture %s is not an ethernet capture\n", in_file);
+		pcap_close(in);
+		return 2;
+	}
+
+	// forward_packet() hands over bare IPv6 packets, so dump them as raw IP
+	out = pcap_open_dead(DLT_RAW, 65535);
+	sixone_replay_dumper = pcap_dump_open(out, out_file);
+	if(NULL == sixone_replay_dumper) {
+		fprintf(stderr, "Couldn't open dump %s: %s\n", out_file, pcap_geterr(out));
+		pcap_close(out);
+		pcap_close(in);
+		return 2;
+	}
+
+	// got_packet() only uses the interface for diagnostics, pretend it came in on the first one
+	set_n_if = (u_char**) malloc(sizeof(sixone_settings) + sizeof(sixone_if));
+	set_n_if[0] = (u_char*)global_settings;
+	set_n_if[1] = (u_char*)global_settings->if_v[0];
+
+	counts_sum(&sum, 1);
+	sixone_replay_truncated = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pcap_loop(in, 0, replay_packet, (u_char*)set_n_if);
+	// packets still queued or waiting for a mapping belong to this replay
+	if(NULL != global_rss)
+		rss_drain(global_rss);
+	if(NULL != global_async)
+		async_drain(global_async);
+	if(NULL != global_rss)
+		rss_drain(global_rss);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	pcap_dump_close(sixone_replay_dumper);
+	sixone_replay_dumper = NULL;
+	pcap_close(out);
+	pcap_close(in);
+	free(set_n_if);
+
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	counts_sum(&sum, 0);
+	other = sum.packets - sum.inbound - sum.outbound - sum.hairpin;
+
+	printf("Replayed %u packets from %s to %s in %.6f s\n", sum.packets, in_file, out_file, secs);
+	printf("  %.0f pkts/s, %.1f ns/pkt\n",
+	       secs > 0 ? sum.packets / secs : 0.0,
+	       sum.packets ? secs * 1e9 / sum.packets : 0.0);
+	// with workers the time a worker spent on each packet, they run side by side
+	replay_report("inbound", sum.inbound, sum.replay_ns[0]);
+	replay_report("outbound", sum.outbound, sum.replay_ns[1]);
+	replay_report("hairpin", sum.hairpin, sum.replay_ns[2]);
+	replay_report("other", other, sum.replay_ns[3]);
+	if(NULL != global_rss)
+		rss_report(global_rss);
+	if(NULL != global_ct)
+		ct_report(global_ct);
+	if(NULL != global_pmtu)
+		pmtu_report(global_pmtu, global_settings->image);
+	if(NULL != global_icmp)
+		icmp_report(global_icmp);
+	if(0 != frag_stats.first || 0 != frag_stats.held)
+		frag_report();
+	if(sixone_replay_truncated)
+		printf("  skipped %u truncated packets\n", sixone_replay_truncated);
+	if(sum.malformed)
+		printf("  dropped %u malformed packets\n", sum.malformed);
+	if(sum.unmapped)
+		printf("  dropped %u packets whose mapping went away\n", sum.unmapped);
+	if(sum.hairpin_rewritten)
+		printf("  hairpin: %u packets to a transit address\n", sum.hairpin_rewritten);
+	if(NULL != global_fastpath)
+		printf("  fast path: %u handled, %u punted (%u expired), %u outbound / %u inbound mappings held, %u expired ones removed, %u not learned (full)\n",
+		       global_fastpath->hits, global_fastpath->punts, global_fastpath->expired,
+		       lpm_count(global_fastpath->out), lpm_count(global_fastpath->in),
+		       global_fastpath->removed, global_fastpath->full);
+	if(NULL != global_rtt)
+		rtt_report(global_rtt);
+	if(NULL != global_async)
+		async_report(global_async);
+	if(NULL != global_repl)
+		repl_report(global_repl);
+
+	return 0;
+}
+
 int sixone_start_out_if()
 {
 	struct stat buf;
@@ -196,6 +419,14 @@ void sixone_stop_out_if()
 	//  system(cmd);
 }
 
+/**
+ *  @brief pcap_loop() callback with --workers, queues the packet to the worker of its flow
+ */
+static void dispatch_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
+{
+	rss_dispatch(global_rss, got_packet, args, header, packet);
+}
+
 void start_interface(void* args)
 {
 	pcap_t *handle;
@@ -206,8 +437,8 @@ void start_interface(void* args)
 	DBG_P("threadid:%d\n",_dev->if_name, (int)pthread_self());
 	DBG_P("starting: %s\n", _dev->if_name );
   
-	// setup the device
-	handle = pcap_open_live(_dev->if_name, BUFSIZ, 0, 1000, sixone_errbuf);
+	// setup the device, a frame is at most the MTU with an ethernet header and a VLAN tag
+	handle = pcap_open_live(_dev->if_name, _dev->mtu + SIZE_ETHERNET_HDR + 4, 0, 1000, sixone_errbuf);
 	if (handle == NULL) {
 		fprintf(stderr, "Couldn't open device %s: %s\n", _dev->if_name, sixone_errbuf);
 		return;
@@ -216,188 +447,232 @@ void start_interface(void* args)
 	// Apply the filter(s)
 	DBG_P("passing to set_filter(%s)\n", _dev->if_name);
 	set_filter(handle, _dev);
+	// what we send (tun, --direct, hairpin) must not come back in
+	if(0 != pcap_setdirection(handle, PCAP_D_IN))
+		fprintf(stderr, "Couldn't capture inbound only on %s: %s\n", _dev->if_name, pcap_geterr(handle));
+	// --direct injects frames on the same handle
+	if(NULL != global_egress)
+		egress_attach(global_egress, _dev->if_name, handle);
   
 	// start blocking sixone_loop
 	DBG_P("[][][] Listening for packets threadid: %d [][][]\n", (int)pthread_self());
-	pcap_loop(handle, 0, got_packet, args);
+	// a burst at a time, the timers run after each and at least once a second (the read timeout)
+	while(0 <= pcap_dispatch(handle, -1, NULL != global_rss ? dispatch_packet : got_packet, args))
+		timers_burst();
   
 	DBG_P("(%s)\n",_dev->if_name);
 	pthread_exit(NULL);
 }
 
 
-/// @TODO: Fix destroy mutexes
-void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
+/**
+ *  @brief Everything got_packet() does after counting, any number of threads at once
+ */
+static void process_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
 {
-	pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
-	u_char *pkt = (u_char*) packet;
+	struct sixone_counts *c = counts_self();
+	struct sixone_pkt_ pkt;
 	struct ether_header *eth_hdr = (struct ether_header *) packet;
-	struct ip6_hdr *ip = (struct ip6_hdr *) (eth_hdr + 1); // +1 ethernet header length
-	struct icmp6_hdr *icmp = (struct icmp6_hdr *) (ip + 1); // +1 ip header length
+	struct ip6_hdr *ip;
 	u_char** set_n_if = (u_char**) args;
 	sixone_if _dev = (sixone_if)set_n_if[1];
+	int fast;
+	u_int mtu, forwarded = 0;
+	sixone_frag frag = NULL;
+	struct frag_key fkey;
 
 	u_char src_ip[INET6_ADDRSTRLEN];
 	u_char dst_ip[INET6_ADDRSTRLEN];
 
-	DBG_P("MUTEX LOCK\n");
-	pthread_mutex_lock( &_mutex );
+	DBG_P("[%s] Caught a packet! [%d]\n",_dev->if_name, c->packets);
+	sixone_replay_hdr = header;
 
-	DBG_P("%s:%d : [%s] Caught a packet! [%d]\n",_dev->if_name, ++sixone_packet_count);
-	sixone_packet_count += 1;
-
-	DBG_P("IP->LEN = %d\n", ip->ip6_plen );
-	if( ip->ip6_plen > SIXONE_MTU) {
-		packet_too_big(ip);
-		pthread_mutex_unlock( &_mutex);
-		DBG_P("MUTEX UNLOCK - ICMP packet too big!\n");
+	// one pass over the headers, everything below works on the descriptor
+	if(0 != parse_packet(&pkt, packet, header->caplen)) {
+		c->malformed++;
+		DBG_P("not a complete IPv6 packet\n");
+		return;
+	}
+	ip = PKT_IP6(&pkt);
+	pkt.ts_us = header->ts.tv_sec * 1000000ULL + header->ts.tv_usec;
+	if(NULL != global_rtt)
+		__atomic_store_n(&global_rtt->now_us, pkt.ts_us, __ATOMIC_RELAXED);
+	timers_packet(pkt.ts_us);
+
+	// a packet that cannot leave is answered before any lookup or rewrite
+	DBG_P("IP->LEN = %d\n", ntohs(ip->ip6_plen) );
+	mtu = pmtu_of(global_pmtu, global_settings->image, ip, timers_now());
+	if(pkt.len > mtu) {
+		if(NULL != global_pmtu)
+			__atomic_fetch_add(&global_pmtu->too_big, 1, __ATOMIC_RELAXED);
+		packet_too_big(&pkt, mtu);
+		DBG_P("ICMP packet too big!\n");
 		return;
 	}
+	// one compare unless an interface clamps the MSS, then the SYNs leave fitting that MTU too
+	if(0 != global_settings->image->mss_c)
+		pmtu_clamp_mss(global_pmtu, global_settings->image, &pkt, mtu);
 
 	// Ignore Neighborhood discovery messages, they'r being delivered to the router
 	// TODO: Sort out the filters so that messages to this specific router are not caught
-	switch(icmp->icmp6_type) {
+	// The capture filter drops these already unless they sit behind extension headers (see sixonebpf.c)
+	if(IPPROTO_ICMPV6 == pkt.proto && 0 != pkt.l4_off) switch(pkt.icmp_type) {
 	case ND_ROUTER_SOLICIT:
 	case ND_ROUTER_ADVERT:
 	case ND_NEIGHBOR_SOLICIT:
 	case ND_NEIGHBOR_ADVERT:
 	case ND_REDIRECT:
+		c->ignored++;
+		DBG_P("ignored ICMPtype\n");
+		return;
+	case ICMP6_PACKET_TOO_BIG:
 	case ICMP6_DST_UNREACH:
-		//case ICMP6_PACKET_TOO_BIG:
 	case ICMP6_TIME_EXCEEDED:
 	case ICMP6_PARAM_PROB:
-		pthread_mutex_unlock( &_mutex);
-		DBG_P("MUTEX UNLOCK - ignored ICMPtype\n");
-		//pthread_mutex_destroy(&_mutex);
-		//DBG_P("MUTEX DESTROY\n");
+		// between two of our edge hosts it goes across like any other packet
+		if(is_hairpin(ip))
+			break;
+		// an error from transit about a packet of ours goes back to the edge host it came from
+		if(is_inbound(ip)) {
+			DBG_P("inbound error!\n");
+			c->inbound++;
+			inbound_error(&pkt);
+			return;
+		}
+		if(ICMP6_PACKET_TOO_BIG == pkt.icmp_type)
+			break;
+		c->ignored++;
+		DBG_P("ignored ICMPtype\n");
 		return;
 	}
       
-	print_eth_header((void*)eth_hdr);
-	DBG_P(" incoming packet:\n");
-	print_ip_header((void*)ip);
-	//  print_icmp_header((void*)icmp);
+	if(DBG) {
+		print_eth_header((void*)eth_hdr);
+		DBG_P(" incoming packet:\n");
+		print_ip_header((void*)ip);
+		//  print_icmp_header((void*)icmp);
    
-	printf("[%d] \n", sixone_packet_count);
+		printf("[%d] \n", c->packets);
+	}
 
-	if(is_inbound(ip)) {
+	// a later fragment has no upper layer header to look up, it goes where its first fragment went
+	if((pkt.flags & SIXONE_PKT_FRAG) && NULL != (frag = frag_self())) {
+		if(!(pkt.flags & SIXONE_PKT_FIRST)) {
+			// one step, or its first fragment could be recorded between the miss and the hold
+			frag_lock(frag);
+			if(FRAG_FORWARD == (fast = frag_lookup(frag, &pkt, timers_now())))
+				forward_packet(ip);
+			else if(FRAG_MISS == fast)
+				frag_hold(frag, &pkt, timers_now());
+			frag_unlock(frag);
+			return;
+		}
+		frag_key_of(&pkt, &fkey);
+		forwarded = c->forwarded;
+	}
+
+	if(is_hairpin(ip)) {
+		DBG_P("hairpin!\n");
+		hairpin(&pkt);
+	}
+	else if(NULL != global_fastpath && SIXONE_FAST_PUNT != (fast = fast_path(global_fastpath, &pkt))) {
+		DBG_P("fast path!\n");
+		if(SIXONE_FAST_INBOUND == fast)
+			c->inbound++;
+		else
+			c->outbound++;
+	}
+	else if(NULL != global_async && async_park(global_async, &pkt, header, args)) {
+		// held (or dropped) until its mapping is resolved, release_packet() brings it back
+		DBG_P("parked!\n");
+		frag = NULL;
+	}
+	else if(is_inbound(ip)) {
 		DBG_P("inbound!\n");
-		inbound(ip);
+		c->inbound++;
+		inbound(&pkt);
 	}
 	else if(is_outbound(ip)) {
 		DBG_P("outbound!\n");
-		outbound(ip);
+		c->outbound++;
+		outbound(&pkt);
 	}
 	else {
 		/// if !is_inbound && !is_outbound ignore packet
 		/// however, it could be a packet directed _for_ the router
 		/// @todo handle packets directed for the router
+		c->ignored++;
 
 		inet_ntop(AF_INET6, &ip->ip6_src, src_ip,  sizeof(src_ip));
 		inet_ntop(AF_INET6, &ip->ip6_dst, dst_ip,  sizeof(dst_ip));
 		DBG_P("Ignoring packet: %s -> %s\n", src_ip, dst_ip );
 	}
 
-	pthread_mutex_unlock( &_mutex);
-	DBG_P("MUTEX UNLOCK\n");
-  
-	//pthread_mutex_destroy(&_mutex);
-	//DBG_P("MUTEX DESTROY");
-	return;
+	if((pkt.flags & SIXONE_PKT_FRAG) && NULL != frag) {
+		frag_lock(frag);
+		frag_record(frag, &fkey, &pkt, forwarded != c->forwarded, timers_now(), forward_packet);
+		frag_unlock(frag);
+	}
 }
 
-/// @TODO Abstract, encapsulate and beautify the parsing and filter-generation, this hould be a 10 lines function, not 100 lines.
-int set_filter(pcap_t *handle, sixone_if dev)
+void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
 {
-	int i,j,k,l;
-	int _strlen = 0;
-	char *bpf_exp, *bpf_exp_buff;
-	char str_net[INET6_ADDRSTRLEN], str_ip[INET6_ADDRSTRLEN];
-	struct in6_addr *tmp_net;
-	struct in6_addr *tmp_ip;
-  
-	struct bpf_program bpf_p;
-  
-	DBG_P(" : (start)set_filter(, %s)\n", dev->if_name);
-  
-	// All edge interfaces should 'hear' packets from the edge not to to the edge
-	// All transit interfaces should hear packets to the edge, not from the edge
-  
-	DBG_P("making filter\n");
-	for( i=0; i < global_settings->if_c; ++i) {
-		for( j=0; j < global_settings->if_v[i]->net_c; ++j) {
-			if( global_settings->if_v[i]->net_v[j]->edge) {
-				// dst net edge and src not edge
-				// OR
-				// src net edge and dst not edge
-				_strlen += strlen("( ");
-				_strlen += ( strlen("( ip6 dst net ") + INET6_ADDRSTRLEN + strlen(" and ") +
-					     strlen("not ip6 src net ") + INET6_ADDRSTRLEN + strlen(" ) ")+
-					     strlen(" or ") +
-					     strlen("( ip6 src net ") + INET6_ADDRSTRLEN + strlen(" and ") +
-					     strlen(" not ip6 dst net ") + INET6_ADDRSTRLEN + strlen(" ) ")
-					);
-
-				for(k=0;k < global_settings->if_c; ++k) {
-					_strlen += strlen(" and not ip6 src ") + INET6_ADDRSTRLEN;
-
-				}
-				_strlen += strlen( " )");
-			}
-			_strlen += (j-1) * strlen(" or ");
-		}
+	struct sixone_counts *c = counts_self();
+	struct timespec t0, t1;
+	u_int in_c, out_c, hp_c;
+	u_int64_t ns;
+
+	c->packets++;
+	if(NULL == sixone_replay_dumper) {
+		process_packet(args, header, packet);
+		return;
 	}
 
-	bpf_exp = (char*) malloc( _strlen +1 );// +1 null char
-	memset(bpf_exp,0, _strlen+1);
-  
-	for( i=0; i < global_settings->if_c; ++i) {
-		if(i > 0) {
-			strcat(bpf_exp, " or ");      
-		}
+	// a replay times each packet and accounts it to the direction it took
+	in_c = c->inbound;
+	out_c = c->outbound;
+	hp_c = c->hairpin;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	process_packet(args, header, packet);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ns = (t1.tv_sec - t0.tv_sec) * 1000000000ULL + t1.tv_nsec - t0.tv_nsec;
+	if(c->inbound != in_c)
+		c->replay_ns[0] += ns;
+	else if(c->outbound != out_c)
+		c->replay_ns[1] += ns;
+	else if(c->hairpin != hp_c)
+		c->replay_ns[2] += ns;
+	else
+		c->replay_ns[3] += ns;
+}
 
-		for( j=0; j < global_settings->if_v[i]->net_c; ++j) {
-			if(j > 0) {
-				strcat(bpf_exp, " or ");      
-			}
+void release_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
+{
+	process_packet(args, header, packet);
+}
 
-			tmp_net = extractPrefix(global_settings->if_v[i]->net_v[j]->addr);
-			inet_ntop( AF_INET6, tmp_net, str_net, INET6_ADDRSTRLEN );
-      
-			sprintf( bpf_exp + strlen(bpf_exp), "( ");
-			sprintf( bpf_exp + strlen(bpf_exp), "( ip6 dst net %s/%u and not ip6 src net %s/%u )", 
-				 str_net, global_settings->if_v[i]->net_v[j]->addr->pfx,
-				 str_net, global_settings->if_v[i]->net_v[j]->addr->pfx );
-			sprintf( bpf_exp + strlen(bpf_exp), " or ");
-			sprintf( bpf_exp + strlen(bpf_exp), "( ip6 src net %s/%u and not ip6 dst net %s/%u )", 
-				 str_net, global_settings->if_v[i]->net_v[j]->addr->pfx,
-				 str_net, global_settings->if_v[i]->net_v[j]->addr->pfx );
-
-			for(k=0; k < global_settings->if_c; ++k) {
-				for(l=0; l < global_settings->if_v[k]->net_c; ++l) {
-					inet_ntop( AF_INET6, global_settings->if_v[k]->net_v[l]->addr, str_ip, INET6_ADDRSTRLEN );
-					sprintf(bpf_exp + strlen(bpf_exp), " and not ip6 src %s", str_ip );
-				}
-			}
-
-			sprintf( bpf_exp + strlen(bpf_exp), " )");
-      
-		}
-    
-	}
-  
-	DBG_P("Applying filter\n\t\"%s\" to interface %s\n", bpf_exp, dev->if_name);
-  
-	if (pcap_compile(handle, &bpf_p, bpf_exp, 0, 0) == -1) {
-		fprintf(stderr, "Couldn't parse filter %s: %s\n", bpf_exp, pcap_geterr(handle));
+int set_filter(pcap_t *handle, sixone_if dev)
+{
+	struct bpf_program bpf_p;
+
+	DBG_P(" : (start)set_filter(, %s)\n", dev->if_name);
+
+	// Edge interfaces 'hear' packets from their edge nets to outside the edge,
+	// transit interfaces hear packets to the transit nets
+	if(0 != build_filter(global_settings, dev, &bpf_p)) {
+		fprintf(stderr, "Couldn't build filter for %s\n", dev->if_name);
 		return(2);
 	}
-  
-	DBG_P("pcap_setfilter()\n");
+
+	DBG_P("Applying a %u instruction filter to interface %s\n", bpf_p.bf_len, dev->if_name);
+
 	if (pcap_setfilter(handle, &bpf_p) == -1) {
-		fprintf(stderr, "Couldn't install filter %s: %s\n", bpf_exp, pcap_geterr(handle));
+		fprintf(stderr, "Couldn't install filter on %s: %s\n", dev->if_name, pcap_geterr(handle));
+		pcap_freecode(&bpf_p);
 		return(2);
 	}
+	pcap_freecode(&bpf_p);
 	return 0;
 }
 
@@ -438,8 +713,9 @@ struct in6_addr *extractPrefix(sixone_ip addr)
 	return _ip6addr;
 }
 
-void inbound(struct ip6_hdr *ip)
+void inbound(sixone_pkt pkt)
 {
+	struct ip6_hdr *ip = PKT_IP6(pkt);
 	int i= 0, j = 0;
 	u_char dbg_ip[INET6_ADDRSTRLEN];
 	ip_list list;
@@ -449,25 +725,43 @@ void inbound(struct ip6_hdr *ip)
 	u_char str_ip_dst[1024];
 	struct in6_addr ipBuffer;
 	u_char cmd[2048];
-	sixone_ip old, new;
+	struct in6_addr old;
+	struct sixone_ip_ key;
+	sixone_image img = global_settings->image;
 	u_int16_t cksumA, cksumB;
   
-	old = alloc_sixone_ip();
-	new = alloc_sixone_ip();
-	memset(str_ip_src, 0, strlen(str_ip_src));
-  
 	DBG_P(" <------ \n");
 
+	if(0 == img->edge_c) {
+		DBG_P("no edge net to deliver to, dropped\n");
+		return;
+	}
+	memset(str_ip_src, 0, strlen(str_ip_src));
+
 	// resolve to source edge
 	if( bilateral_bit(ip) ) {
 
 		// If you wish to add the remote net to some 'is-upgraded' database
 		// this addition should be here.
 
-		list = retrieve_mappings(((sixone_ip){&ip->ip6_src, 128}), 0);
-		ip_src = policy_pick_src(list);
+		key.ip = ip->ip6_src;
+		key.pfx = 128;
+		list = retrieve_mappings(&key, 0);
+		ip_src = policy_pick_src(list, pkt->hash);
 		DBG_P("ip_src:%p\n",ip_src);
 
+		if(NULL == ip_src) {
+			// no mapping (any more, with replication), nothing to restore the source to
+			DBG_P("no mapping for the source, dropped\n");
+			counts_self()->unmapped++;
+			return;
+		}
+
+		if(NULL != global_fastpath)
+			fast_learn_in(global_fastpath, &ip->ip6_src, list);
+		if(NULL != global_rtt)
+			rtt_inbound(global_rtt, pkt);
+
 		inet_ntop(AF_INET6, &ip_src->ip, str_ip_src,  sizeof(str_ip_src));
 
 		DBG_P("resolved mapping to: %s/%d\n", str_ip_src, ip_src->pfx);
@@ -476,14 +770,7 @@ void inbound(struct ip6_hdr *ip)
 		write_prefix(&ip->ip6_src, ip_src);
 
 		// rewrite destination
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(global_settings->if_v[i]->net_v[j]->edge) {
-					ip_dst = global_settings->if_v[i]->net_v[j]->addr;
-				}
-			}
-		}
-		write_prefix(&ip->ip6_dst, ip_dst);
+		rewrite_apply(&img->edge, &ip->ip6_dst);
     
 		// forward 
 		forward_packet(ip);
@@ -493,37 +780,142 @@ void inbound(struct ip6_hdr *ip)
 		// packet must have passed through, so just ignore
 		DBG_P(" - rewrite destination() (nxt:%hd)\n", ip->ip6_nxt);
 
+#ifndef NDEBUG
 		cksumA = get_icmp6_checksum(ip);
 		//DBG_P("cksumA = get_icmp6_checksum(ip) : %hX\n", cksumA);
 		//print_binary(&cksumA, 2); printf("\n");
-		memcpy( &old->ip , &ip->ip6_dst, sizeof(struct in6_addr));
-
-		// rewrite destination
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(global_settings->if_v[i]->net_v[j]->edge)
-					new = global_settings->if_v[i]->net_v[j]->addr;
-			}
+#endif
+		memcpy( &old , &ip->ip6_dst, sizeof(struct in6_addr));
+
+		// rewrite destination, back to the host the flow came from if it is tracked
+		if(DBG) print_ip_header((u_char *)ip);
+		if(NULL != global_ct && 0 == ct_lookup(global_ct, pkt, &ipBuffer)) {
+			// a checksum neutral rewrite left both addresses with the same sum
+			ip->ip6_dst = ipBuffer;
+			update_transport_checksum(pkt, &old, &ip->ip6_dst);
+		}
+		else {
+			rewrite_apply(&img->legacy_edge, &ip->ip6_dst);
+			fix_transport_checksum(pkt, &old, &ip->ip6_dst, img->edge_cksum[img->edge_c - 1]);
 		}
-		new->pfx = 64;
-		assert(new != 0);
-
-		print_ip_header((u_char *)ip);
-		write_prefix(&ip->ip6_dst, new);
     
-		print_ip_header((u_char *)ip);
+		if(DBG) print_ip_header((u_char *)ip);
 
+#ifndef NDEBUG
+		// full payload pass, only to verify the rewrite
 		cksumB = get_icmp6_checksum(ip);
 
-		assert( 0xFFFF == cksumB );
+		assert( IPPROTO_ICMPV6 != ip->ip6_nxt || 0xFFFF == cksumB );
+#endif
 
 		forward_packet(ip);
 	}
 	return;
 }
 
-void outbound(struct ip6_hdr *ip)
+void hairpin(sixone_pkt pkt)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	sixone_image img = global_settings->image;
+	struct sixone_counts *c = counts_self();
+	struct in6_addr old;
+	int e, t, s;
+
+	// the router's own addresses are the kernel's business
+	if(0 <= (e = image_find_edge(img, &ip->ip6_dst))) {
+		if(0 == memcmp(&ip->ip6_dst, &img->edge_self[e], sizeof(ip->ip6_dst))) {
+			c->ignored++;
+			return;
+		}
+	}
+	else {
+		t = image_find_transit(img, &ip->ip6_dst);
+		if(0 == memcmp(&ip->ip6_dst, &img->transit_self[t], sizeof(ip->ip6_dst)) || 0 == img->edge_c) {
+			c->ignored++;
+			return;
+		}
+		// the incremental update keeps the sums right whatever the checksum mode of either net
+		old = ip->ip6_dst;
+		rewrite_apply(&img->transit_edge[t], &ip->ip6_dst);
+		update_transport_checksum(pkt, &old, &ip->ip6_dst);
+		s = image_find_edge(img, &ip->ip6_src);
+		old = ip->ip6_src;
+		rewrite_apply(&img->edge_transit[s], &ip->ip6_src);
+		update_transport_checksum(pkt, &old, &ip->ip6_src);
+		c->hairpin_rewritten++;
+	}
+
+	c->hairpin++;
+	// dst is an edge address now: --direct sends it on that link, the tun otherwise,
+	// where the kernel's connected route takes it, forward_packet() installs no route for it
+	forward_packet(ip);
+}
+
+void inbound_error(sixone_pkt pkt)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct icmp6_hdr *icmp = (struct icmp6_hdr *)PKT_L4(pkt);
+	struct ip6_hdr *inner = (struct ip6_hdr *)(icmp + 1);
+	struct sixone_pkt_ quote;
+	struct in6_addr dst, src, inner_dst, edge;
+	sixone_image img = global_settings->image;
+	struct sixone_ip_ key;
+	sixone_ip ip_dst;
+	ip_list list;
+	u_int16_t *l4sum, l4old = 0, sum;
+
+	// the quote must hold a packet outbound() sent
+	if(PKT_L4_LEN(pkt) < sizeof(*icmp) + sizeof(*inner)
+	   || 0 != parse_quote(&quote, (u_char *)inner, PKT_L4_LEN(pkt) - sizeof(*icmp))
+	   || 0 > image_find_transit(img, &inner->ip6_src) || 0 == img->edge_c) {
+		DBG_P("error not about a packet of ours, dropped\n");
+		return;
+	}
+	dst = ip->ip6_dst;
+	src = inner->ip6_src;
+	inner_dst = inner->ip6_dst;
+	if(NULL != (l4sum = transport_cksum(&quote)))
+		l4old = *l4sum;
+
+	if(bilateral_bit(inner)) {
+		// both addresses were rewritten, with both back the quoted checksum is right again
+		key.ip = inner->ip6_dst;
+		key.pfx = 128;
+		list = retrieve_mappings(&key, 0);
+		if(NULL == (ip_dst = policy_pick_src(list, quote.hash))) {
+			DBG_P("no mapping for the quoted destination, dropped\n");
+			return;
+		}
+		write_prefix(&inner->ip6_dst, ip_dst);
+		rewrite_apply(&img->edge, &inner->ip6_src);
+	}
+	else if(NULL != global_ct && 0 == ct_lookup_sent(global_ct, &quote, &edge)) {
+		inner->ip6_src = edge;
+		update_transport_checksum(&quote, &src, &inner->ip6_src);
+	}
+	else {
+		rewrite_apply(&img->legacy_edge, &inner->ip6_src);
+		fix_transport_checksum(&quote, &src, &inner->ip6_src, img->edge_cksum[img->edge_c - 1]);
+	}
+
+	// deliver to the host the quote is back to, every word that changed goes into the error's checksum
+	ip->ip6_dst = inner->ip6_src;
+	sum = cksum_update16(icmp->icmp6_cksum, &dst, &ip->ip6_dst);
+	sum = cksum_update16(sum, &src, &inner->ip6_src);
+	sum = cksum_update16(sum, &inner_dst, &inner->ip6_dst);
+	if(NULL != l4sum)
+		sum = cksum_update_word(sum, l4old, *l4sum);
+	icmp->icmp6_cksum = sum;
+
+	if(ICMP6_PACKET_TOO_BIG == icmp->icmp6_type && NULL != global_pmtu)
+		pmtu_learn(global_pmtu, img, pkt, timers_now());
+
+	forward_packet(ip);
+}
+
+void outbound(sixone_pkt pkt)
 {
+	struct ip6_hdr *ip = PKT_IP6(pkt);
 	int i= 0, j = 0;
 	u_char dbg_ip[INET6_ADDRSTRLEN];
 	ip_list list;
@@ -532,54 +924,67 @@ void outbound(struct ip6_hdr *ip)
 	u_char str_ip_dst[1024];
 	struct in6_addr ipBuffer;
 	u_char cmd[2048];
-	sixone_ip old, new;
+	struct in6_addr old;
+	struct sixone_ip_ key;
+	sixone_image img = global_settings->image;
+	int edge;
 	u_int16_t cksumA, cksumB;
   
 	memset(str_ip_dst, 0, strlen(str_ip_dst));
   
 	DBG_P(" ------> \n");
 
+	if(0 == img->transit_c) {
+		DBG_P("no transit net to leave through, dropped\n");
+		return;
+	}
+
 	// first check if the target is upgraded or not
 	// YES, target is upgraded
-	if( is_sixone((sixone_ip){&ip->ip6_dst , 128}) ) {
+	key.ip = ip->ip6_dst;
+	key.pfx = 128;
+	if( is_sixone(&key) ) {
 		// resolve to transit dest
-		list = retrieve_mappings((sixone_ip)((sixone_ip){&ip->ip6_dst, 128}), 0);
-		ip_dst = policy_pick_dst(list);
+		list = retrieve_mappings(&key, 0);
+		ip_dst = policy_pick_dst(list, pkt->hash);
+
+		if(NULL == ip_dst) {
+			// the mapping went away since is_sixone() (replication), nothing to rewrite to
+			DBG_P("no mapping for the destination, dropped\n");
+			counts_self()->unmapped++;
+			return;
+		}
 
 		/// @todo More intelligent interface selection and/or policy based.
 		// add route to transit dst
 		// find an outgoing net  just take ANY
 		DBG_P( "Looking for an exit path...\n"  );
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(!global_settings->if_v[i]->net_v[j]->edge) {
-					add_route( &ip_dst->ip, ip_dst->pfx, 
-						   global_settings->if_v[i]->net_v[j]->gw);
-					break;
-				}
-			}
-		}
+		// --direct needs no route, forward_packet() adds one if the gateway is not known yet
+		if(NULL == global_egress)
+			for(i = 0; i < img->route_c; i++)
+				add_route( &ip_dst->ip, ip_dst->pfx, &img->transit_gw[img->route_v[i]]);
     
 		inet_ntop(AF_INET6, &ip_dst->ip, str_ip_dst,  sizeof(str_ip_dst));
 		DBG_P("outbound() : resolved mapping to: %s/%d\n", str_ip_dst, ip_dst->pfx);
+
+		// routed now, the following packets can take the fast path
+		if(NULL != global_fastpath)
+			fast_learn_out(global_fastpath, &ip->ip6_dst, list);
     
 
 		// rewrite destination
 		write_prefix(&ip->ip6_dst, ip_dst);
 
 		// rewrite source
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(!global_settings->if_v[i]->net_v[j]->edge)
-					ip_src = global_settings->if_v[i]->net_v[j]->addr;
-			}
-		}
-		write_prefix(&ip->ip6_src, ip_src);
+		rewrite_apply(&img->transit, &ip->ip6_src);
 
 		// Set bilateral bit
 		set_bilateral_bit(ip, 1);
 		DBG_P("diagnostic: bilateralbit %d\n", bilateral_bit(ip) );
 
+		if(NULL != global_rtt)
+			rtt_outbound(global_rtt, pkt, ip_dst);
+
 		// forward 
 		forward_packet(ip);
 
@@ -588,47 +993,40 @@ void outbound(struct ip6_hdr *ip)
 		// setup a nat rule
 		// packet must have passed through, so just ignore
 		DBG_P("rewrite source() Legacy target (nxt:%hd)\n", ip->ip6_nxt);
+#ifndef NDEBUG
 		cksumA = get_icmp6_checksum(ip);
 		DBG_P("cksumA = get_icmp6_checksum(ip) : %hX\n", cksumA);
+#endif
 
-		old = alloc_sixone_ip();
-
-		memcpy( &old->ip , &ip->ip6_src, 16);
+		memcpy( &old , &ip->ip6_src, 16);
     
 		// rewrite source to transit address
-		ip_src = 0;
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(!global_settings->if_v[i]->net_v[j]->edge){
-					new = global_settings->if_v[i]->net_v[j]->addr;
-				}
-			}
-		}
-
-		assert(new != 0);
+		rewrite_apply(&img->transit, &ip->ip6_src);
 
-		write_prefix(&ip->ip6_src, (sixone_ip)&new->ip); //printf("\n");
+		edge = image_find_edge(img, &old);
+		fix_transport_checksum(pkt, &old, &ip->ip6_src, 0 > edge ? SIXONE_CKSUM_NEUTRAL : img->edge_cksum[edge]);
 
-		cksumNeutralIp( &ip->ip6_src, &old->ip);
+		// remember where the replies go
+		if(NULL != global_ct)
+			ct_track(global_ct, pkt, &old);
     
+#ifndef NDEBUG
+		// full payload pass, only to verify the rewrite
 		cksumB = get_icmp6_checksum(ip);
 		DBG_P("cksumB = get_icmp6_checksum(ip) : %hX\n", cksumB);
 		//print_binary(&cksumB, 2); printf("\n");
     
-		assert( 0xFFFF == cksumB );
+		assert( IPPROTO_ICMPV6 != ip->ip6_nxt || 0xFFFF == cksumB );
+#endif
 
 		// add route to transit dst
 		// find an outgoing net  just take ANY
 		DBG_P( "Looking for an exit path...\n"  );
-		for(i = 0; i < global_settings->if_c; i++) {
-			for(j = 0; j < global_settings->if_v[i]->net_c; j++) {
-				if(!global_settings->if_v[i]->net_v[j]->edge) {
-					add_route( &ip->ip6_dst, 128, 
-						   global_settings->if_v[i]->net_v[j]->gw);
-					break;
-				}
-			}
-		}
+		if(NULL == global_egress)
+			for(i = 0; i < img->route_c; i++)
+				add_route( &ip->ip6_dst, 128, &img->transit_gw[img->route_v[i]]);
+		if(NULL != global_fastpath)
+			fast_learn_out(global_fastpath, &ip->ip6_dst, NULL);
 		forward_packet(ip);
 	}
 	return;
@@ -641,14 +1039,39 @@ void forward_packet(struct ip6_hdr *ip)
 	int fd = 0, nbytes, maxbytes = 0;
 	uint32_t family;
 	struct iovec ip_vec[2];
+	struct pcap_pkthdr dump_hdr;
+	u_int ip_len = sizeof(*ip) + ntohs(ip->ip6_plen);
+	sixone_image img = global_settings->image;
+	int t, rc;
 	//  DBG_P(" : forward_packet( ) : using fd:%d\n", __FILE__, __LINE__, global_settings->out_fd);
 
-	if((sizeof(*ip) + ip->ip6_plen) > 15000) {
-		DBG_P("IGNORING PACKET!!! (%d)\n", sizeof(*ip) + ip->ip6_plen);
-		/// @todo Send an ICMP - Fragmentation Needed packet.
+	counts_self()->forwarded++;
+
+	// Offline replay, write to the dump instead of the tun device
+	if(NULL != sixone_replay_dumper) {
+		dump_hdr.ts = sixone_replay_hdr->ts;
+		dump_hdr.caplen = dump_hdr.len = ip_len;
+		pthread_mutex_lock(&sixone_replay_lock);
+		pcap_dump((u_char *)sixone_replay_dumper, &dump_hdr, (u_char *)ip);
+		pthread_mutex_unlock(&sixone_replay_lock);
 		return;
 	}
 
+	// --direct, a packet to one of our hosts leaves as a frame to it on the link of its edge net
+	if(NULL != global_egress && 0 <= (t = image_find_edge(img, &ip->ip6_dst))) {
+		if(0 == egress_send(global_egress, img->edge_if[t], &ip->ip6_dst, ip))
+			return;
+	}
+	// and a packet from a transit address as a frame to the gateway of its net
+	else if(NULL != global_egress && 0 <= (t = image_find_transit(img, &ip->ip6_src))) {
+		if(0 == (rc = egress_send(global_egress, img->transit_if[t], &img->transit_gw[t], ip)))
+			return;
+		// through the kernel, which resolves the gateway for the next read of its table;
+		// the route goes again once the gateway is learned (egress_withdraw())
+		if(-1 == rc)
+			egress_route(global_egress, img->transit_if[t], &ip->ip6_dst, &img->transit_gw[t]);
+	}
+
 	fd = global_settings->out_fd;
 	if(0 == fd)
 		err(1,"no fd");
@@ -658,22 +1081,22 @@ void forward_packet(struct ip6_hdr *ip)
 	ip_vec[0].iov_base = &family;
 	ip_vec[0].iov_len = sizeof(family);
 	ip_vec[1].iov_base = ip;
-	ip_vec[1].iov_len = sizeof(*ip) + ip->ip6_plen;
+	ip_vec[1].iov_len = ip_len;
 
 	nbytes = writev(fd, ip_vec, 2);
         DBG_P(" : forward_packet( ) : wrote %d bytes.\n", __FILE__, __LINE__, nbytes);
-	DBG_P(" : forward_packet( ) : family:%hd, *ip:%d, ip6_len:%d .\n", AF_INET6, sizeof(*ip) , ip->ip6_plen );
+	DBG_P(" : forward_packet( ) : family:%hd, *ip:%d, ip6_len:%d .\n", AF_INET6, sizeof(*ip) , ntohs(ip->ip6_plen) );
   
 	//print_ip_header(ip);
 	//print_icmp_header( (struct icmp6_hdr *) (ip + 1) );
 
-	print_ip_header((u_char *)ip);
+	if(DBG) print_ip_header((u_char *)ip);
 
-	if( sizeof(*ip) + ip->ip6_plen > maxbytes) maxbytes = sizeof(*ip) + ip->ip6_plen;
-	DBG_P("Want to write %d bytes, max so far is %d\n", sizeof(*ip) + ip->ip6_plen, maxbytes);
+	if( ip_len > maxbytes) maxbytes = ip_len;
+	DBG_P("Want to write %d bytes, max so far is %d\n", ip_len, maxbytes);
 
-	if( nbytes != sizeof(family) + sizeof(*ip) + ip->ip6_plen) {
-		DBG_P(" too few written bytes %d should have written %d| error:%s (errorcode: %d)\n", nbytes, sizeof(family) + sizeof(*ip) + ip->ip6_plen,strerror(errno), errno);
+	if( nbytes != sizeof(family) + ip_len) {
+		DBG_P(" too few written bytes %d should have written %d| error:%s (errorcode: %d)\n", nbytes, sizeof(family) + ip_len,strerror(errno), errno);
 		perror("ioerror");
 		exit(1);
 	}
@@ -686,66 +1109,34 @@ void forward_packet(struct ip6_hdr *ip)
 
 int cmp_bits(void* left, void* right, u_int bits)
 {
-	u_int _bytes_to_malloc;
-	void* _left;
-	void* _right;
+	u_char *_left = left, *_right = right;
 	u_char _mask;
+	int ret;
 
-	_bytes_to_malloc = bits/8;
-
-
-	_left = (void*) malloc(_bytes_to_malloc);
-	_right = (void*) malloc(_bytes_to_malloc);
-
-	if( 0 != bits%8)
-	{
-		_bytes_to_malloc += 1; // if we got a tail of bits, include them
-		_mask = 0xFF << 8 - bits % 8; // prepare a mask for the last bits (8)
-	}
-
-	memcpy(_left, left, _bytes_to_malloc); // Copy the two bitstrings
-	memcpy(_right, right, _bytes_to_malloc);
-
-	if( 0 != bits%8) // if we
-	{
-		((u_char*)_left)[_bytes_to_malloc] &= _mask; // zero out any unessecary bit tail
-		((u_char*)_right)[_bytes_to_malloc] &= _mask;      
-	}
-
-	return memcmp(_left, _right, _bytes_to_malloc);
-  
+	// whole bytes first, then the tail of bits (if any) under a mask
+	if(0 != (ret = memcmp(_left, _right, bits / 8)) || 0 == bits % 8)
+		return ret;
+	_mask = 0xFF << (8 - bits % 8);
+	return (_left[bits / 8] & _mask) - (_right[bits / 8] & _mask);
 }
 
 void extract_postfix(u_char* buffer, u_int offset, u_int totLen)
 {
-	u_char _mask;
-	u_int _bitShift;
-
-	DBG_P(" (%p, %d)\n", buffer, offset);
 	memset(buffer, 0, offset/8); // zeroout the first bytes
-
-	_bitShift = offset % 8;
-	_mask = 0xFF >> _bitShift;
-	buffer[offset/8] &= _mask;
+	if( 0 != offset % 8 )
+		buffer[offset/8] &= 0xFF >> offset % 8;
 
 	return;
 }
 
 void extract_prefix(u_char* buffer, u_int offset, u_int totLen)
 {
-	u_char _mask;
-	u_int _bitShift;
-	u_int _tailLength;
-	int i;
-	DBG_P(" (%p, %d, %d)\n", buffer, offset, totLen);
 	if( 0 == offset % 8 ) {
-		memset(&buffer[offset/8], 0, totLen/8 - (offset/8));
+		memset(&buffer[offset/8], 0, totLen/8 - offset/8);
 	}
 	else {
-		memset(&buffer[offset/8+1], 0, totLen/8 - (offset/8-1));
-		_bitShift = 8 - offset % 8;
-		_mask = 0xFF << _bitShift;
-		buffer[offset/8] &= _mask;
+		memset(&buffer[offset/8+1], 0, totLen/8 - offset/8 - 1);
+		buffer[offset/8] &= 0xFF << (8 - offset % 8);
 	}
   
 	return;
@@ -759,113 +1150,43 @@ void or_arrays(u_char* buff1, u_char* buff2, u_int len)
 }
 
 
-/// @todo make this a macro (inline)
 u_int is_inbound(struct ip6_hdr *ip)
 {
-	int i,j, src=0, dst=0; // src,dst = 0 if transit, 1 if edge
-	sixone_if dev;
-	sixone_net net;
-
 	// if dst is our transit net, then go for it!
-
-	for (i = 0; i < global_settings->if_c; ++i)    {
-		dev = global_settings->if_v[i];
-    
-		for(j = 0; j < dev->net_c; ++j){
-			if(!dev->net_v[j]->edge) {
-				// is dst an edgenet?
-				if(0 == cmp_bits((void*) &ip->ip6_dst, &dev->net_v[j]->addr->ip, dev->net_v[j]->addr->pfx) ) {
-					return 1;
-				}
-			}
-		}
-	}
-	return 0;
+	return 0 <= image_find_transit(global_settings->image, &ip->ip6_dst);
 }
 
-/// @todo make this a macro (inline)
 u_int is_outbound(struct ip6_hdr *ip)
 {
-	int i,j, src=0, dst=0; // src,dst = 0 if transit, 1 if edge
-	sixone_if dev;
-	sixone_net net;
-	char str_net[INET6_ADDRSTRLEN], str_ip[INET6_ADDRSTRLEN];
-
 	// if src is an edge net and dst is not that very same edgenet
-	// we don't do horisontal routing
+	// horisontal routing is hairpin()'s, process_packet() asks is_hairpin() first
 	// packet is outbound if src=1 and dst=0
-	// redundant check, because the packet filtering checks the
-	// source:destination pair
-	// but let's futureproof
-  
-	for (i = 0; i < global_settings->if_c; ++i)    {
-		dev = global_settings->if_v[i];
-    
-		for(j = 0; j < dev->net_c; ++j) {
-			if(dev->net_v[j]->edge) {
-				// is dst an edgenet?
-				inet_ntop( AF_INET6, &ip->ip6_dst , str_ip, INET6_ADDRSTRLEN );
-				inet_ntop( AF_INET6,  &dev->net_v[j]->addr->ip , str_net, INET6_ADDRSTRLEN );
-
-				if(0 == cmp_bits((void*) &ip->ip6_dst, &dev->net_v[j]->addr->ip, dev->net_v[j]->addr->pfx) ) {
-					dst=1;
-				}
-				// is src an edgenet?
-				inet_ntop( AF_INET6, &ip->ip6_dst , str_ip, INET6_ADDRSTRLEN );
-				inet_ntop( AF_INET6,  &dev->net_v[j]->addr->ip , str_net, INET6_ADDRSTRLEN );
-
-				if(0 == cmp_bits((void*) &ip->ip6_src, &dev->net_v[j]->addr->ip, dev->net_v[j]->addr->pfx)) {
-					src=1;
-				}
-			}
-		}
-	}
+	return 0 > image_find_edge(global_settings->image, &ip->ip6_dst)
+		&& 0 <= image_find_edge(global_settings->image, &ip->ip6_src);
+}
 
-	return !(dst) && src;
+u_int is_hairpin(struct ip6_hdr *ip)
+{
+	sixone_image img = global_settings->image;
+
+	return 0 <= image_find_edge(img, &ip->ip6_src)
+		&& (0 <= image_find_edge(img, &ip->ip6_dst) || 0 <= image_find_transit(img, &ip->ip6_dst));
 }
 
-/// @todo make smart (binary tree?)
 u_int is_edge(struct in6_addr *ip)
 {
-	int i,j;
-	for ( i = 0; i < global_settings->if_c; i++)  {
-		for( j = 0; global_settings->if_v[i]->net_c; j++)  {
-			if( global_settings->if_v[i]->net_v[j]->edge 
-			    && 
-			    0 == cmp_bits((void*)ip, &global_settings->if_v[i]->net_v[j]->addr->ip, 128) 
-				)
-				return 1;
-		}
-	}
+	sixone_image img = global_settings->image;
+	u_int i;
+
+	for(i = 0; i < img->edge_c; i++)
+		if(0 == memcmp(ip, &img->edge_addr[i], sizeof(*ip)))
+			return 1;
 	return 0;
 }
 
-/// @todo Proper testing, has some (intresting) bugs.
 void write_prefix(struct in6_addr *addr, sixone_ip prefix)
 {
-	struct in6_addr ipbuffer_prefix;
-	u_char dbg_post[INET6_ADDRSTRLEN], dbg_pre[INET6_ADDRSTRLEN];
-
-	memcpy(&ipbuffer_prefix, &prefix->ip, 16);
-	inet_ntop( AF_INET6, &ipbuffer_prefix, dbg_pre, INET6_ADDRSTRLEN );
-	inet_ntop( AF_INET6, addr , dbg_post, INET6_ADDRSTRLEN );
-	//DBG_P("(%s, ((sixone_ip){%s, %u})) \n", dbg_post, dbg_pre, prefix->pfx);
-
-	inet_ntop( AF_INET6, &ipbuffer_prefix, dbg_pre, INET6_ADDRSTRLEN );
-	//DBG_P("pre: %s\n", dbg_pre);
-
-	extract_prefix((u_char *)&ipbuffer_prefix, prefix->pfx, 128);
-	inet_ntop( AF_INET6, &ipbuffer_prefix, dbg_post, INET6_ADDRSTRLEN );
-	//DBG_P("pre: %s\n", dbg_pre);
-  
-	extract_postfix((u_char *)addr, (u_int)prefix->pfx, 128);
-	inet_ntop( AF_INET6, addr , dbg_post, INET6_ADDRSTRLEN );
-	//DBG_P("post: %s\n", dbg_post);
-
-	or_arrays((u_char *)addr, (u_char *)&ipbuffer_prefix, 16);
-	inet_ntop( AF_INET6, addr , dbg_post, INET6_ADDRSTRLEN );
-	//DBG_P("result: %s\n", dbg_post);
-	return;
+	rewrite_kernel(prefix->pfx)(addr, &prefix->ip);
 }
 
 u_int bilateral_bit(struct ip6_hdr *ip)
@@ -908,91 +1229,68 @@ int is_sixone(sixone_ip ip)
 	return NULL != transit;
 }
 
-sixone_ip policy_pick_dst(ip_list list)
+sixone_ip policy_pick_dst(ip_list list, u_int32_t flow)
 {
 	DBG_P("\n");
 	if(global_settings->policy->sixone_policy_dst != NULL)
-		return global_settings->policy->sixone_policy_dst(list);
+		return global_settings->policy->sixone_policy_dst(list, flow);
 	else
-		return policy_pick_dst_default(list);
+		return policy_pick_dst_default(list, flow);
 }
 
-sixone_ip policy_pick_src(ip_list list)
+sixone_ip policy_pick_src(ip_list list, u_int32_t flow)
 {
 	DBG_P("\n");
 	if(global_settings->policy->sixone_policy_src != NULL)
-		return global_settings->policy->sixone_policy_src(list);
+		return global_settings->policy->sixone_policy_src(list, flow);
 	else
-		return policy_pick_src_default(list);
+		return policy_pick_src_default(list, flow);
 }
 
-sixone_ip policy_pick_dst_default(ip_list list)
+sixone_ip policy_pick_dst_default(ip_list list, u_int32_t flow)
 {
 	DBG_P("list: %p\n", list);
-	if (list == NULL) return NULL;
-	else return list->ip;
+	return policy_pick_weighted(list, flow);
 }
 
-sixone_ip policy_pick_src_default(ip_list list)
+sixone_ip policy_pick_src_default(ip_list list, u_int32_t flow)
 {
 	DBG_P("\n");
-	if (list == NULL) return NULL;
-	else return list->ip;
+	return policy_pick_weighted(list, flow);
 }
 
-ip_list retrieve_mappings_default(sixone_ip ip, u_int only_sixone)
-{
-	FILE* _fh;
-	u_int pfx_len;
-	ip_list ret;
-	ip_list *curr;
-	struct in6_addr edge_ip;
-	struct in6_addr tran_ip;
-	u_char strEdge[INET6_ADDRSTRLEN];
-	u_char strTran[INET6_ADDRSTRLEN];
-	u_char strOrig[INET6_ADDRSTRLEN];
-	u_char _string[1024];
+/// @brief mappings.txt as a table, read by the first retrieve_mappings_default() and not written after
+static sixone_maptab sixone_default_tab;
+static pthread_once_t sixone_default_once = PTHREAD_ONCE_INIT;
 
-	ret = NULL;
-	curr = &ret;
-
-	memset(strEdge, 0, INET6_ADDRSTRLEN);
-	memset(strTran, 0, INET6_ADDRSTRLEN);
-	memset(strOrig, 0, INET6_ADDRSTRLEN);
-	inet_ntop(AF_INET6, &(ip->ip), strOrig, sizeof(strOrig));
-
-	DBG_P(" got %s\n", strOrig);
+static void load_default_mappings()
+{
+	struct sixone_mapping *m;
+	int n;
 
-	if( NULL == ( _fh = fopen( "mappings.txt", "r") ) )  {
+	if((n = load_mappings("mappings.txt", 0, NULL, &m)) < 0) {
 		printf("Cannot open file mappings.txt.\n");
 		exit (1);
 	}
+	if(NULL == (sixone_default_tab = alloc_sixone_maptab()) || 0 != maptab_build(sixone_default_tab, m, n)) {
+		printf("Could not malloc()\n");
+		exit (1);
+	}
+	free(m);
+}
 
-	while( NULL != fgets(_string, sizeof(_string), _fh) ) {
-		sscanf(_string, "%[^/ ]/%d%s\n", strEdge,&pfx_len, strTran);
-		
-		inet_pton(AF_INET6, strEdge, &(edge_ip));
-		inet_pton(AF_INET6, strTran, &(tran_ip));
-		
-		if( 0 == cmp_bits(&ip->ip, &edge_ip, pfx_len)) {
-			(*curr) = (ip_list)alloc_ip_list();
-			(*curr)->ip = alloc_sixone_ip();
-			(*curr)->ip->ip = tran_ip;
-			(*curr)->ip->pfx = pfx_len;
-			curr = &(*curr)->next;
-		}
-   
-		if( 0 == cmp_bits(&ip->ip, &tran_ip, pfx_len)) {
-			(*curr) = (ip_list)alloc_ip_list();
-			(*curr)->ip = alloc_sixone_ip();
-			(*curr)->ip->ip = edge_ip;
-			(*curr)->ip->pfx = pfx_len;
-			curr = &(*curr)->next;
-		}
-    
+ip_list retrieve_mappings_default(sixone_ip ip, u_int only_sixone)
+{
+	u_char strOrig[INET6_ADDRSTRLEN];
+
+	if(DBG) {
+		inet_ntop(AF_INET6, &(ip->ip), strOrig, sizeof(strOrig));
+		DBG_P(" got %s\n", strOrig);
 	}
 
-	return ret;
+	// the table is complete before anyone reads it, the lookups need no lock
+	pthread_once(&sixone_default_once, load_default_mappings);
+	return maptab_resolve(sixone_default_tab, &ip->ip);
 }
 
 ip_list retrieve_mappings(sixone_ip ip, u_int only_sixone)
@@ -1008,6 +1306,19 @@ ip_list retrieve_mappings(sixone_ip ip, u_int only_sixone)
 		return retrieve_mappings_default(ip, only_sixone);
 }
 
+void retrieve_mappings_batch(u_int n, sixone_ip ip[], u_int only_sixone, ip_list out[])
+{
+	u_int i;
+
+	if(global_settings->resolv->sixone_resolv_batch != NULL) {
+		if(0 != global_settings->resolv->sixone_resolv_batch(n, ip, only_sixone, out))
+			memset(out, 0, n * sizeof(ip_list));
+		return;
+	}
+	for(i = 0; i < n; i++)
+		out[i] = retrieve_mappings(ip[i], only_sixone);
+}
+
 /// @deprecated
 int add_route(struct in6_addr * ip, u_int pfx, struct in6_addr* gw)
 {
@@ -1022,6 +1333,10 @@ int add_route(struct in6_addr * ip, u_int pfx, struct in6_addr* gw)
 	char* cmdListElement;
 
 	DBG_P("%d\n", cmdListLen);
+
+	// Offline replay never touches the kernel routing table
+	if(NULL != sixone_replay_dumper)
+		return 0;
   
 	assert(gw != NULL);
 	if(gw == NULL) {
@@ -1150,25 +1465,50 @@ int recalc_tcp_checksum(struct ip6_hdr *ip) {
 	return 1;
 }
 
-u_int16_t
-checksum(u_int16_t sum, const void *_p, u_int16_t len)
+void fix_transport_checksum(sixone_pkt pkt, struct in6_addr *prev, struct in6_addr *addr, int cksum_mode)
 {
-	u_int16_t t;
-	const u_int8_t *p = _p;
-	const u_int8_t *end = p + len;
-
-	while(p < (end-1)) {
-		t = (p[0] << 8) + p[1];
-		sum += t;
-		if (sum < t) sum++;
-		p += 2;
-	}
-	if(p < end) {
-		t = (p[0] << 8) + 0;
-		sum += t;
-		if (sum < t) sum++;
+	if(SIXONE_CKSUM_INCREMENTAL == cksum_mode)
+		update_transport_checksum(pkt, prev, addr);
+	else
+		cksumNeutralIp(addr, prev);
+}
+
+u_int16_t *transport_cksum(sixone_pkt pkt)
+{
+	u_char *l4 = PKT_L4(pkt);
+	u_int16_t *sum;
+
+	// non-first fragments carry no upper layer header, parse_packet() checked the header lengths
+	if(0 == pkt->l4_off)
+		return NULL;
+
+	switch(pkt->proto) {
+	case IPPROTO_TCP:
+		return &((struct tcphdr *)l4)->th_sum;
+	case IPPROTO_UDP:
+		sum = &((struct udphdr *)l4)->uh_sum;
+		// no checksum was computed, nothing to keep valid
+		return 0 == *sum ? NULL : sum;
+	case IPPROTO_ICMPV6:
+		return &((struct icmp6_hdr *)l4)->icmp6_cksum;
 	}
-	return sum;
+	return NULL;
+}
+
+int update_transport_checksum(sixone_pkt pkt, struct in6_addr *prev, struct in6_addr *addr)
+{
+	u_int16_t *sum;
+
+	if(NULL == (sum = transport_cksum(pkt)))
+		return 0;
+
+	*sum = cksum_update16(*sum, prev, addr);
+
+	// a computed UDP checksum of zero is transmitted as all ones (RFC 768)
+	if(IPPROTO_UDP == pkt->proto && 0 == *sum)
+		*sum = 0xFFFF;
+
+	return 1;
 }
 
 void cksumNeutralIp( struct in6_addr *target, struct in6_addr *prev )
@@ -1216,54 +1556,15 @@ u_int16_t getCksumDiff16(void* a, void* b) {
   
 }
 
-/**
- * @brief Internet checksum in network byte order.
- */
-u_int16_t incksum16(const void *_p) {
-
-	const uint64_t *p = _p;
-	uint64_t s;
-	uint32_t u, v;
-	uint16_t x, y;
-	DBG_P("\n");
-	s = p[0];
-	s += p[1];
-	if (s < p[1]) s++;
-
-	v = s >> 32;
-	u = s;
-
-	u += v;
-	if (u < v) u++;
-
-	x = u >> 16;
-	y = u;
-
-	x += y;
-	if (x < y) x++;
-
-	return x;
-}
-
-/// @todo Properly respond with ICMP-packet too big. This is only a stub (not properly working/tested)
-void packet_too_big(struct ip6_hdr *ip) {
-
-	struct icmp6_hdr *icmp = (void *)((char *)ip + sizeof(*ip));
-	struct in6_addr tmp;
-	DBG_P("\n");
-	memset(icmp, 0, ICMPV6_HDR_LEN);
-  
-	// Flip source/Dest
-	memcpy( &tmp, &ip->ip6_dst, sizeof(tmp));
-	memcpy( &ip->ip6_dst, &ip->ip6_src, sizeof(ip->ip6_dst) );
-	memcpy( &ip->ip6_src, &tmp, sizeof(ip->ip6_src) );
-
-	// build ICMP contents
-	icmp->icmp6_type = ICMP6_PACKET_TOO_BIG;
-	*icmp->icmp6_data32 = htonl(SIXONE_MTU);
-
-	ip->ip6_plen = SIXONE_MTU - sizeof(struct ip6_hdr);
+void packet_too_big(sixone_pkt pkt, u_int32_t mtu)
+{
+	u_char buf[ICMP_ERROR_MAX];
+	struct in6_addr src;
 
-	// reply to the sender
-	forward_packet(ip); 
+	if(NULL == global_icmp || 0 != icmp_allow(global_icmp, pkt, timers_now()))
+		return;
+	if(0 != icmp_source(global_settings->image, PKT_IP6(pkt), &src))
+		return;
+	icmp_packet_too_big(buf, &src, pkt, mtu);
+	forward_packet((struct ip6_hdr *)buf);
 }
@@ -34,6 +34,22 @@
 #define SIXONELIB_H
 
 #include "sixonetypes.h"
+#include "sixonecksum.h"
+#include "sixonepkt.h"
+#include "sixonebpf.h"
+#include "sixonefast.h"
+#include "sixonepolicy.h"
+#include "sixonertt.h"
+#include "sixoneplugin.h"
+#include "sixoneasync.h"
+#include "sixonerepl.h"
+#include "sixonerss.h"
+#include "sixonect.h"
+#include "sixoneicmp.h"
+#include "sixonepmtu.h"
+#include "sixonefrag.h"
+#include "sixoneegress.h"
+#include "sixonetimer.h"
 
 #include <pcap.h>
 
@@ -41,7 +57,7 @@
 #include <netinet/in.h> // required by ip6.h
 #include <netinet/ip6.h>
 
-sixone_settings global_settings;
+extern sixone_settings global_settings;
 
 /**
  *  @brief Start the sixone router with the given settings, starts a subthread for each interface.
@@ -51,6 +67,21 @@ sixone_settings global_settings;
  */
 u_int start_sixone();
 
+/**
+ *  @brief Run a capture file through the rewrite path instead of live interfaces.
+ *
+ *  Every packet of in_file (ethernet) is handed to got_packet() and what
+ *  forward_packet() would have written to the tun device is dumped (raw IPv6) to out_file.
+ *  No routes are installed. Throughput, ns/packet and a per-direction breakdown
+ *  are printed when the capture is exhausted; with --workers the breakdown is
+ *  the time the workers spent on each packet, summed over their counters.
+ *  @param settings The settings to use (assumed to be loaded by load_settings()
+ *  @param in_file pcap file to read from
+ *  @param out_file pcap file to write the rewritten packets to
+ *  @return 0 on success, 2 if the captures could not be opened
+ */
+u_int replay_sixone(sixone_settings settings, char *in_file, char *out_file);
+
 /**
  *  @brief Bring up the outgoing interface and return a filedescriptor to it
  *  @return The filedescriptor of the outgoing interface
@@ -79,11 +110,19 @@ void sixone_stop_out_if();
  */
 void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet);
 
+/**
+ *  @brief Runs a packet held back by async_park() through the router, like got_packet() but not counted again
+ *  @param args, header, packet As given to got_packet()
+ */
+void release_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet);
+
 /**
  *  @brief Sets the BPF for the listening pcap session (one per interface) (internal use only)
+ *
+ *  The program is generated by build_filter() from global_settings and only
+ *  holds the clauses for the role(s) of dev.
  *  @param handle The pcap handle that this filter should apply to
  *  @param dev the sixone_if that this filter applies to
- *  @param settings the sixone_settings type, to fech information about all edge nets from
  */
 int set_filter(pcap_t *handle, sixone_if dev);
 
@@ -101,19 +140,45 @@ void start_interface(void* args);
  */
 struct in6_addr *extractPrefix(sixone_ip addr);
 
+/**
+ * @brief Path of a packet between two of our edge hosts (is_hairpin())
+ *
+ * No mapping is looked up and no route installed. A packet to an edge
+ * address is forwarded as it is. A packet to the transit address of one of
+ * our hosts has both addresses rewritten in one pass, the destination to the
+ * edge net paired with its transit net and the source to the transit net
+ * paired with its edge net (sixone_image::transit_edge, edge_transit), so the
+ * replies come back the same way. A packet to
+ * one of the router's own addresses is left alone.
+ * @param pkt Packet to handle, as parsed by parse_packet()
+ */
+void hairpin(sixone_pkt pkt);
+
 /**
  * @brief Inbound program execution path
- * @param ip Packet to handle
+ * @param pkt Packet to handle, as parsed by parse_packet()
  *  @callergraph
  */
-void inbound(struct ip6_hdr *ip);
+void inbound(sixone_pkt pkt);
+
+/**
+ * @brief Inbound path of an ICMPv6 error from transit about a packet outbound() sent.
+ *
+ * The quoted packet is mapped back to the addresses the edge host sent it
+ * with (mappings for a bilateral peer, the tracked flow or the legacy edge
+ * net for our source), the error is addressed to that host and both the
+ * quoted transport checksum and the error's own are updated incrementally.
+ * A Packet Too Big is learned by the path MTU cache under the host's destination.
+ * @param pkt Packet to handle, as parsed by parse_packet()
+ */
+void inbound_error(sixone_pkt pkt);
 
 /**
  * @brief Outbound program execution path
- * @param ip Packet to handle
+ * @param pkt Packet to handle, as parsed by parse_packet()
  *  @callergraph
  */
-void outbound(struct ip6_hdr *ip);
+void outbound(sixone_pkt pkt);
 
 /**
  *  @brief Send the packet (all processing is done)
@@ -186,6 +251,13 @@ u_int is_inbound(struct ip6_hdr *ip);
  */
 u_int is_outbound(struct ip6_hdr *ip);
 
+/**
+ *  @brief Checks if a packet goes from one of our edge nets to another (or the same) one
+ *  @param ip The packet to check
+ *  @return true if ip_src is in an edge net and ip_dst in an edge or a transit net
+ */
+u_int is_hairpin(struct ip6_hdr *ip);
+
 /**
  * @return Returns true if the ip is listed as an edgenetwork of this router
  * @param ip The ipadress we check
@@ -201,6 +273,9 @@ u_int is_edge(struct in6_addr *ip);
  *  @param prefix Pointer to the prefix to copy
  *  @param prefix_len Number of bits to copy from the prefix (prefix length)
  *  @param src which addess to rewrite true => src, false => dst
+ *
+ *  Dispatches to the kernel of prefix->pfx (rewrite_kernel()), rewrite targets
+ *  known up front are bound once and applied with rewrite_apply() instead.
  */
 void write_prefix(struct in6_addr *addr, sixone_ip prefix);
 
@@ -247,40 +322,38 @@ int set_unilateral_bit(struct ip6_hdr *ip, u_char val);
 int is_sixone(sixone_ip ip );
 
 /**
- *  @brief If the settings->policy is set, it forwards the call
- *   else it runs the default policy
+ *  @brief The default dst policy, weighted multipath per flow (policy_pick_weighted())
  *  @param ip_lst The list of ips
+ *  @param flow The flow hash of the packet
  *  @return returns the preffered dst ip
- *  @todo Implement 
  */
-sixone_ip policy_pick_dst_default(ip_list list);
+sixone_ip policy_pick_dst_default(ip_list list, u_int32_t flow);
 
 /**
  *  @brief If the settings->policy is set, it forwards the call
  *   else it runs the default polcy
  *  @param ip_lst The list of ips
+ *  @param flow The flow hash of the packet
  *  @return returns the preffered dst ip
- *  @todo Implement 
  */
-sixone_ip policy_pick_dst(ip_list list);
+sixone_ip policy_pick_dst(ip_list list, u_int32_t flow);
 
 /**
- *  @brief If the settings->policy is set, it forwards the call
- *   else it runs the default policy
+ *  @brief The default src policy, weighted multipath per flow (policy_pick_weighted())
  *  @param ip_lst The list of ips
+ *  @param flow The flow hash of the packet
  *  @return returns the preffered dst ip
- *  @todo Implement 
  */
-sixone_ip policy_pick_src_default(ip_list list);
+sixone_ip policy_pick_src_default(ip_list list, u_int32_t flow);
 
 /**
  *  @brief If the settings->policy is set, it forwards the call
  *   else it runs the default policy
  *  @param list The list of ips
+ *  @param flow The flow hash of the packet
  *  @return returns the preffered src ip
- *  @todo Implement, and figure out behaviour
  */
-sixone_ip policy_pick_src(ip_list list);
+sixone_ip policy_pick_src(ip_list list, u_int32_t flow);
 
 /**
  *  @brief Retrieve mappings for the destination IP, 
@@ -293,8 +366,25 @@ sixone_ip policy_pick_src(ip_list list);
  */
 ip_list retrieve_mappings(sixone_ip ip, u_int only_sixone);
 
+/**
+ *  @brief Retrieve mappings for n addresses in one go
+ *
+ *  Hands the whole burst to settings->resolv->sixone_resolv_batch (e.g. a
+ *  plugin) if set, otherwise resolves them one by one through retrieve_mappings().
+ *  @param ip The addresses to look up
+ *  @param only_sixone As for retrieve_mappings()
+ *  @param out Set to the mappings of ip[i], NULL if there are none
+ */
+void retrieve_mappings_batch(u_int n, sixone_ip ip[], u_int only_sixone, ip_list out[]);
+
 /**
  *  @brief Retrieve mappings for the destination IP
+ *
+ *  Looks ip up in mappings.txt, one "<edge>/<len> <transit> [weight]" per
+ *  line, the weight (default SIXONE_WEIGHT_DEFAULT) is the share of flows
+ *  the default policy gives the line among the others for the same prefix.
+ *  The file is read once, by the first call, into a sixone_maptab; the
+ *  sixonemap.so plugin follows changes to it.
  *  @todo How to chose the "preffered" prefix
  *  @param ip the ip to lookup
  *  @param only_sixone Only return a list if the ip is an edge IP
@@ -322,7 +412,31 @@ int recalc_tcp_checksum(struct ip6_hdr *ip);
 /// @deprecated
 int recalc_udp_checksum(struct ip6_hdr *ip);
 
-u_int16_t checksum(u_int16_t sum, const void *_p, u_int16_t len);
+/**
+ *  @brief Keeps the transport checksum valid after one of the addresses was rewritten,
+ *  according to the checksum mode of the edge net (SIXONE_CKSUM_*).
+ *  @param pkt The (rewritten) packet
+ *  @param prev The address before the rewrite
+ *  @param addr The rewritten address in the packet (ip6_src or ip6_dst)
+ *  @param cksum_mode SIXONE_CKSUM_* of the edge net, see sixone_image edge_cksum
+ */
+void fix_transport_checksum(sixone_pkt pkt, struct in6_addr *prev, struct in6_addr *addr, int cksum_mode);
+
+/**
+ *  @brief Finds the TCP, UDP or ICMPv6 checksum of a packet
+ *  @return The checksum field, NULL if the packet carries none we know of (or a zero UDP checksum)
+ */
+u_int16_t *transport_cksum(sixone_pkt pkt);
+
+/**
+ *  @brief Applies an RFC 1624 update of an address rewrite to the TCP, UDP or ICMPv6 checksum. O(1).
+ *  A zero UDP checksum (none computed) is left alone.
+ *  @param pkt The (rewritten) packet
+ *  @param prev The address before the rewrite
+ *  @param addr The address after the rewrite
+ *  @return 1 if a checksum was updated, 0 if the packet carries none we know of
+ */
+int update_transport_checksum(sixone_pkt pkt, struct in6_addr *prev, struct in6_addr *addr);
 
 /**
  *  @brief Calculates the checksum difference when rewriting IP-addresses. Compensates for the difference by writing the difference into the 7th byte.
@@ -333,9 +447,11 @@ void cksumNeutralIp( struct in6_addr *target, struct in6_addr *prev );
 
 u_int16_t getCksumDiff16(void* a, void* b);
 
-u_int16_t incksum16(const void *_p);
-
-void packet_too_big(struct ip6_hdr *ip);
+/**
+ *  @brief Sends an ICMPv6 Packet Too Big about pkt back to its source, if the rate limits allow one
+ *  @param mtu The MTU of the link pkt did not fit
+ */
+void packet_too_big(sixone_pkt pkt, u_int32_t mtu);
 
 #endif
 
@@ -0,0 +1,391 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixoneload.c
+ *  @brief Six-One Router parallel mapping file loader
+ *  @date 2026-10-19
+ */
+
+#include "sixoneload.h"
+#include "sixonepolicy.h" // SIXONE_WEIGHT_DEFAULT
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIXONE_LOAD_X86 1
+#include <immintrin.h>
+#endif
+
+/// @brief Smallest chunk worth a thread of its own
+#define LOAD_CHUNK_MIN (1 << 20)
+/// @brief Longest IPv6 address text, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"
+#define IP6_TEXT_MAX 39
+/// @brief Bytes the SSE2 kernel looks at, three vectors
+#define IP6_SIMD_WINDOW 48
+
+/// @brief Hex digit values, -1 for anything else
+static const signed char hex_val[256] = {
+	['0'] = 0, ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4, ['5'] = 5, ['6'] = 6, ['7'] = 7,
+	['8'] = 8, ['9'] = 9, ['a'] = 10, ['b'] = 11, ['c'] = 12, ['d'] = 13, ['e'] = 14, ['f'] = 15,
+	['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15,
+};
+
+static int is_hex(char c)
+{
+	return 0 != hex_val[(u_char)c] || '0' == c;
+}
+
+/**
+ *  @brief Writes n groups, the "::" (if any) before group gap
+ *  @return 0 if the groups make an address
+ */
+static int ip6_groups(const u_int16_t *g, int n, int gap, struct in6_addr *out)
+{
+	int i, j;
+
+	if(gap < 0 ? 8 != n : n > 7)
+		return -1;
+	memset(out, 0, sizeof(*out));
+	for(i = 0; i < n; i++) {
+		j = gap < 0 || i < gap ? i : 8 - n + i;
+		out->s6_addr[2 * j] = g[i] >> 8;
+		out->s6_addr[2 * j + 1] = g[i];
+	}
+	return 0;
+}
+
+u_int ip6_parse_scalar(const char *s, const char *end, struct in6_addr *out)
+{
+	const char *p = s;
+	u_int16_t g[8];
+	int n = 0, gap = -1, d;
+	u_int v;
+
+	if(p + 1 < end && ':' == p[0] && ':' == p[1]) {
+		gap = 0;
+		p += 2;
+	}
+	while(p < end && is_hex(*p)) {
+		for(v = 0, d = 0; p < end && d < 4 && is_hex(*p); d++)
+			v = v << 4 | hex_val[(u_char)*p++];
+		if((p < end && is_hex(*p)) || 8 == n)
+			return 0;
+		g[n++] = v;
+		if(p >= end || ':' != *p)
+			break;
+		if(p + 1 < end && ':' == p[1]) {
+			if(gap >= 0)
+				return 0;
+			gap = n;
+			p += 2;
+		}
+		else if(++p >= end || !is_hex(*p))
+			return 0;
+	}
+	// IPv4-embedded addresses are left to inet_pton()
+	if(p == s || (p < end && ('.' == *p || ':' == *p)) || 0 != ip6_groups(g, n, gap, out))
+		return 0;
+	return p - s;
+}
+
+#ifdef SIXONE_LOAD_X86
+
+/**
+ *  @brief Classifies 16 characters
+ *  @param nib Set to the hex digit values (garbage where there is no hex digit)
+ */
+__attribute__((target("sse2")))
+static void ip6_classify(const char *s, u_char *nib, u_int64_t *colon, u_int64_t *hex, u_int shift)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)s);
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+	// '0'-'9' are 0x30-0x39, 'A'-'F' and 'a'-'f' 0x41-0x46 and 0x61-0x66
+	_mm_storeu_si128((__m128i *)nib, _mm_add_epi8(_mm_and_si128(v, _mm_set1_epi8(0x0f)),
+						    _mm_and_si128(alpha, _mm_set1_epi8(9))));
+	*colon |= (u_int64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(':'))) << shift;
+	*hex |= (u_int64_t)_mm_movemask_epi8(_mm_or_si128(digit, alpha)) << shift;
+}
+
+/**
+ *  @brief Classifies the whole window with vector compares, then walks the
+ *  groups with the colon bit mask instead of character by character
+ */
+__attribute__((target("sse2")))
+static u_int ip6_parse_sse2_kernel(const char *s, const char *end, struct in6_addr *out)
+{
+	u_char nib[IP6_SIMD_WINDOW];
+	u_int64_t colon = 0, hex = 0, rest;
+	u_int16_t g[8];
+	u_int t, pos, q, i;
+	int n = 0, gap = -1;
+
+	if(end - s < IP6_SIMD_WINDOW)
+		return ip6_parse_scalar(s, end, out);
+
+	ip6_classify(s, nib, &colon, &hex, 0);
+	ip6_classify(s + 16, nib + 16, &colon, &hex, 16);
+	ip6_classify(s + 32, nib + 32, &colon, &hex, 32);
+
+	// the address ends at the first character that is neither
+	rest = ~(colon | hex) & ((1ULL << IP6_SIMD_WINDOW) - 1);
+	if(0 == rest || (t = __builtin_ctzll(rest)) > IP6_TEXT_MAX || 0 == t || '.' == s[t])
+		return 0;
+	colon &= (1ULL << t) - 1;
+
+	pos = 0;
+	if(colon & 1) {
+		if(!(colon & 2))
+			return 0;
+		gap = 0;
+		pos = 2;
+	}
+	while(pos < t) {
+		rest = colon >> pos << pos;
+		q = rest ? (u_int)__builtin_ctzll(rest) : t;
+		if(q == pos || q - pos > 4 || 8 == n)
+			return 0;
+		g[n] = 0;
+		for(i = pos; i < q; i++)
+			g[n] = g[n] << 4 | nib[i];
+		n++;
+		if(q == t)
+			break;
+		if(colon >> (q + 1) & 1) {
+			if(gap >= 0)
+				return 0;
+			gap = n;
+			pos = q + 2;
+		}
+		else if((pos = q + 1) == t)
+			return 0;
+	}
+	if(0 != ip6_groups(g, n, gap, out))
+		return 0;
+	return t;
+}
+
+ip6_parse_fn ip6_parse_sse2 = ip6_parse_sse2_kernel;
+
+#else
+
+ip6_parse_fn ip6_parse_sse2 = NULL;
+
+#endif
+
+ip6_parse_fn ip6_parse_impl(const char *name)
+{
+	if(NULL != name && 0 == strcmp(name, "scalar"))
+		return ip6_parse_scalar;
+#ifdef SIXONE_LOAD_X86
+	__builtin_cpu_init();
+	if((NULL == name || 0 == strcmp(name, "sse2")) && __builtin_cpu_supports("sse2"))
+		return ip6_parse_sse2;
+#endif
+	return NULL == name ? ip6_parse_scalar : NULL;
+}
+
+/**
+ * @brief What one thread parses
+ */
+struct load_chunk {
+	const char *start, *end;    /// whole lines
+	const char *file_end;
+	ip6_parse_fn fn;
+	struct sixone_mapping *m;
+	u_int n, size;
+	int err;
+};
+
+static const char *skip_blank(const char *p, const char *end)
+{
+	while(p < end && (' ' == *p || '\t' == *p))
+		p++;
+	return p;
+}
+
+static const char *parse_uint(const char *p, const char *end, u_int *v)
+{
+	const char *s = p;
+
+	for(*v = 0; p < end && *p >= '0' && *p <= '9' && p - s < 10; p++)
+		*v = *v * 10 + (*p - '0');
+	return p;
+}
+
+/**
+ *  @brief Parses one line the quick way
+ *  @return 0 if the line is a mapping in the usual format
+ */
+static int load_line(struct load_chunk *c, const char *p, const char *eol, struct sixone_mapping *m)
+{
+	const char *q;
+	u_int k;
+
+	// no leading blanks, the old reader doesn't take them either
+	if(0 == (k = c->fn(p, c->file_end, &m->edge)) || p + k >= eol || '/' != p[k])
+		return -1;
+	q = parse_uint(p + k + 1, eol, &m->len);
+	if(q == p + k + 1 || m->len > 128 || (p = skip_blank(q, eol)) == q)
+		return -1;
+	if(0 == (k = c->fn(p, c->file_end, &m->transit)))
+		return -1;
+	p = skip_blank(q = p + k, eol);
+	m->weight = SIXONE_WEIGHT_DEFAULT;
+	if(p > q && p < eol && *p >= '0' && *p <= '9')
+		p = skip_blank(parse_uint(p, eol, &m->weight), eol);
+	if(p < eol && '\r' == *p)
+		p++;
+	return p == eol ? 0 : -1;
+}
+
+static void *load_chunk(void *arg)
+{
+	struct load_chunk *c = arg;
+	struct sixone_mapping *grown;
+	const char *p, *eol;
+	char line[1024];
+
+	for(p = c->start; p < c->end; p = eol + 1) {
+		if(NULL == (eol = memchr(p, '\n', c->end - p)))
+			eol = c->end;
+		if(c->n == c->size) {
+			c->size = c->size ? c->size * 2 : (c->end - c->start) / 32 + 16;
+			if(NULL == (grown = realloc(c->m, c->size * sizeof(*c->m)))) {
+				c->err = 1;
+				return NULL;
+			}
+			c->m = grown;
+		}
+		if(0 == load_line(c, p, eol, &c->m[c->n])) {
+			c->n++;
+			continue;
+		}
+		// whatever the old reader made of it
+		if(eol - p < (int)sizeof(line)) {
+			memcpy(line, p, eol - p);
+			line[eol - p] = 0;
+			if(0 == maptab_parse(line, &c->m[c->n]))
+				c->n++;
+		}
+	}
+	return NULL;
+}
+
+int load_mappings(const char *file, u_int threads, ip6_parse_fn fn, struct sixone_mapping **out)
+{
+	struct load_chunk *chunk;
+	pthread_t *tid;
+	struct stat st;
+	const char *base, *p;
+	u_int i, started, total;
+	int fd, ret = -1;
+	long cpus;
+
+	*out = NULL;
+	if(-1 == (fd = open(file, O_RDONLY)))
+		return -1;
+	if(0 != fstat(fd, &st)) {
+		close(fd);
+		return -1;
+	}
+	if(0 == st.st_size) {
+		close(fd);
+		return 0;
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == base)
+		return -1;
+	madvise((void *)base, st.st_size, MADV_SEQUENTIAL);
+
+	if(0 == threads)
+		threads = (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0 ? cpus : 1;
+	if(threads > st.st_size / LOAD_CHUNK_MIN + 1)
+		threads = st.st_size / LOAD_CHUNK_MIN + 1;
+	chunk = calloc(threads, sizeof(*chunk));
+	tid = calloc(threads, sizeof(*tid));
+	if(NULL == chunk || NULL == tid)
+		goto out;
+
+	// cut at the first line break after every 1/threads of the file
+	for(i = 0, p = base; i < threads; i++) {
+		chunk[i].start = p;
+		if(i + 1 == threads)
+			p = base + st.st_size;
+		else if(p < base + st.st_size * (i + 1) / threads)
+			p = base + st.st_size * (i + 1) / threads;
+		if(p < base + st.st_size && NULL != (p = memchr(p, '\n', base + st.st_size - p)))
+			p++;
+		else
+			p = base + st.st_size;
+		chunk[i].end = p;
+		chunk[i].file_end = base + st.st_size;
+		chunk[i].fn = NULL != fn ? fn : ip6_parse_impl(NULL);
+	}
+
+	for(started = 1; started < threads; started++)
+		if(0 != pthread_create(&tid[started], NULL, load_chunk, &chunk[started]))
+			break;
+	load_chunk(&chunk[0]);
+	// chunks that didn't get a thread are parsed here
+	for(i = started; i < threads; i++)
+		load_chunk(&chunk[i]);
+	for(i = 1; i < started; i++)
+		pthread_join(tid[i], NULL);
+
+	for(i = total = 0; i < threads; i++) {
+		if(chunk[i].err)
+			goto out;
+		total += chunk[i].n;
+	}
+	if(NULL == (*out = malloc((total + 1) * sizeof(**out))))
+		goto out;
+	for(i = total = 0; i < threads; i++) {
+		memcpy(*out + total, chunk[i].m, chunk[i].n * sizeof(**out));
+		total += chunk[i].n;
+	}
+	ret = total;
+
+out:
+	for(i = 0; NULL != chunk && i < threads; i++)
+		free(chunk[i].m);
+	free(chunk);
+	free(tid);
+	munmap((void *)base, st.st_size);
+	return ret;
+}
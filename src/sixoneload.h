@@ -0,0 +1,82 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixoneload.h
+ *  @brief Six-One Router parallel mapping file loader
+ *  @date 2026-10-19
+ *
+ *  Reads mappings.txt style files of any size: the file is mmap()ed, cut
+ *  into one chunk per cpu at line boundaries and the chunks are parsed
+ *  concurrently. Addresses go through a hand-written IPv6 text parser with
+ *  an SSE2 kernel; anything it doesn't take (IPv4-embedded addresses, odd
+ *  spacing) falls back to maptab_parse(), so the result is what the old
+ *  fgets()/sscanf() reader gave. maptab_build() then turns the mappings
+ *  into a table in one go.
+ */
+
+#ifndef SIXONELOAD_H
+#define SIXONELOAD_H
+
+#include "sixonemaptab.h"
+
+/**
+ *  @brief An IPv6 text parser kernel
+ *
+ *  Parses the address at s, which ends at the first character that is
+ *  neither a hex digit nor ':'.
+ *  @param s The text
+ *  @param end End of the buffer, s is not read past it
+ *  @param out Set to the address
+ *  @return Characters taken, 0 if s doesn't start with an address the kernel handles
+ */
+typedef u_int (*ip6_parse_fn)(const char *s, const char *end, struct in6_addr *out);
+
+/// @brief Portable kernel
+u_int ip6_parse_scalar(const char *s, const char *end, struct in6_addr *out);
+/// @brief SSE2 kernel (NULL on non-x86 builds, see ip6_parse_impl())
+extern ip6_parse_fn ip6_parse_sse2;
+
+/**
+ *  @brief Look up a kernel by name
+ *  @param name "scalar" or "sse2", NULL for the fastest the cpu supports
+ *  @return The kernel, NULL if it is not compiled in or not supported by this cpu
+ */
+ip6_parse_fn ip6_parse_impl(const char *name);
+
+/**
+ *  @brief Reads a mapping file
+ *  @param file The file, one "<edge>/<len> <transit> [weight]" per line
+ *  @param threads Parsers to run, 0 for one per cpu
+ *  @param fn Address parser, NULL for ip6_parse_impl(NULL)
+ *  @param out Set to the malloc()ed mappings, in file order
+ *  @return The number of mappings, -1 if the file can't be read
+ */
+int load_mappings(const char *file, u_int threads, ip6_parse_fn fn, struct sixone_mapping **out);
+
+#endif // SIXONELOAD_H
@@ -0,0 +1,298 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonelpm.c
+ *  @brief Six-One Router longest prefix match table
+ *  @date 2026-10-19
+ */
+
+#include "sixonelpm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief Buckets a level starts with, doubled whenever the level holds more entries than buckets
+#define LPM_MIN_BUCKETS 16
+
+struct lpm_entry {
+	struct in6_addr pfx;
+	void *val;
+	struct lpm_entry *next;
+};
+
+/**
+ * @brief All prefixes of one length
+ */
+struct lpm_level {
+	struct lpm_entry **bucket;
+	u_int mask;   /// buckets - 1
+	u_int count;
+};
+
+struct sixone_lpm_ {
+	struct lpm_level level[129];
+	u_int8_t lens[129];  /// lengths in use, longest first
+	u_int lens_c;
+	u_int count;
+};
+
+void lpm_mask(struct in6_addr *addr, u_int len)
+{
+	u_int i;
+
+	if(len >= 128)
+		return;
+	i = len / 8;
+	if(len % 8)
+		addr->s6_addr[i++] &= 0xff << (8 - len % 8);
+	memset(&addr->s6_addr[i], 0, 16 - i);
+}
+
+static u_int lpm_hash(const struct in6_addr *pfx, u_int len)
+{
+	u_int32_t w[4], h = len;
+	int i;
+
+	memcpy(w, pfx, sizeof(w));
+	for(i = 0; i < 4; i++) {
+		h ^= w[i];
+		h *= 0x9E3779B1;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+sixone_lpm alloc_sixone_lpm()
+{
+	return (sixone_lpm) calloc(1, sizeof(struct sixone_lpm_));
+}
+
+void lpm_flush(sixone_lpm lpm, void (*free_val)(void *))
+{
+	struct lpm_entry *e, *next;
+	u_int l, b;
+
+	for(l = 0; l <= 128; l++) {
+		if(NULL == lpm->level[l].bucket)
+			continue;
+		for(b = 0; b <= lpm->level[l].mask; b++) {
+			for(e = lpm->level[l].bucket[b]; e != NULL; e = next) {
+				next = e->next;
+				if(NULL != free_val)
+					free_val(e->val);
+				free(e);
+			}
+		}
+		free(lpm->level[l].bucket);
+	}
+	memset(lpm, 0, sizeof(*lpm));
+}
+
+void free_sixone_lpm(sixone_lpm lpm, void (*free_val)(void *))
+{
+	if(NULL == lpm)
+		return;
+	lpm_flush(lpm, free_val);
+	free(lpm);
+}
+
+static struct lpm_entry *level_find(struct lpm_level *lv, const struct in6_addr *pfx, u_int len)
+{
+	struct lpm_entry *e;
+
+	if(0 == lv->count)
+		return NULL;
+	for(e = lv->bucket[lpm_hash(pfx, len) & lv->mask]; e != NULL; e = e->next)
+		if(0 == memcmp(&e->pfx, pfx, sizeof(*pfx)))
+			return e;
+	return NULL;
+}
+
+static int level_grow(struct lpm_level *lv, u_int len)
+{
+	struct lpm_entry **bucket, *e, *next;
+	u_int n = lv->bucket ? (lv->mask + 1) * 2 : LPM_MIN_BUCKETS, b, h;
+
+	bucket = calloc(n, sizeof(*bucket));
+	if(NULL == bucket)
+		return -1;
+	for(b = 0; lv->bucket && b <= lv->mask; b++) {
+		for(e = lv->bucket[b]; e != NULL; e = next) {
+			next = e->next;
+			h = lpm_hash(&e->pfx, len) & (n - 1);
+			e->next = bucket[h];
+			bucket[h] = e;
+		}
+	}
+	free(lv->bucket);
+	lv->bucket = bucket;
+	lv->mask = n - 1;
+	return 0;
+}
+
+void **lpm_slot(sixone_lpm lpm, const struct in6_addr *pfx, u_int len)
+{
+	struct lpm_level *lv;
+	struct lpm_entry *e;
+	struct in6_addr key;
+	u_int i;
+
+	if(len > 128)
+		len = 128;
+	key = *pfx;
+	lpm_mask(&key, len);
+	lv = &lpm->level[len];
+
+	if(NULL != (e = level_find(lv, &key, len)))
+		return &e->val;
+
+	if((NULL == lv->bucket || lv->count > lv->mask) && 0 != level_grow(lv, len))
+		return NULL;
+	if(NULL == (e = malloc(sizeof(*e))))
+		return NULL;
+	e->pfx = key;
+	e->val = NULL;
+	i = lpm_hash(&key, len) & lv->mask;
+	e->next = lv->bucket[i];
+	lv->bucket[i] = e;
+
+	if(0 == lv->count++) {
+		// keep lens sorted longest first
+		for(i = lpm->lens_c; i > 0 && lpm->lens[i - 1] < len; i--)
+			lpm->lens[i] = lpm->lens[i - 1];
+		lpm->lens[i] = len;
+		lpm->lens_c++;
+	}
+	lpm->count++;
+	return &e->val;
+}
+
+void *lpm_insert(sixone_lpm lpm, const struct in6_addr *pfx, u_int len, void *val)
+{
+	void **slot, *old;
+
+	if(NULL == (slot = lpm_slot(lpm, pfx, len)))
+		return NULL;
+	old = *slot;
+	*slot = val;
+	return old;
+}
+
+void lpm_reserve(sixone_lpm lpm, u_int len, u_int n)
+{
+	struct lpm_level *lv = &lpm->level[len > 128 ? 128 : len];
+
+	while((NULL == lv->bucket || lv->mask + 1 < n) && 0 == level_grow(lv, len > 128 ? 128 : len))
+		;
+}
+
+void lpm_walk(sixone_lpm lpm, void (*fn)(const struct in6_addr *pfx, u_int len, void **val, void *arg), void *arg)
+{
+	struct lpm_entry *e;
+	u_int l, b;
+
+	for(l = 0; l <= 128; l++) {
+		if(0 == lpm->level[l].count)
+			continue;
+		for(b = 0; b <= lpm->level[l].mask; b++)
+			for(e = lpm->level[l].bucket[b]; e != NULL; e = e->next)
+				fn(&e->pfx, l, &e->val, arg);
+	}
+}
+
+void *lpm_remove(sixone_lpm lpm, const struct in6_addr *pfx, u_int len)
+{
+	struct lpm_level *lv;
+	struct lpm_entry **pe, *e;
+	struct in6_addr key;
+	void *val;
+	u_int i;
+
+	if(len > 128)
+		return NULL;
+	key = *pfx;
+	lpm_mask(&key, len);
+	lv = &lpm->level[len];
+	if(0 == lv->count)
+		return NULL;
+
+	for(pe = &lv->bucket[lpm_hash(&key, len) & lv->mask]; NULL != (e = *pe); pe = &e->next)
+		if(0 == memcmp(&e->pfx, &key, sizeof(key)))
+			break;
+	if(NULL == e)
+		return NULL;
+	*pe = e->next;
+	val = e->val;
+	free(e);
+
+	if(0 == --lv->count) {
+		// the level stays allocated, lookups just stop probing it
+		for(i = 0; lpm->lens[i] != len; i++)
+			;
+		memmove(&lpm->lens[i], &lpm->lens[i + 1], lpm->lens_c - i - 1);
+		lpm->lens_c--;
+	}
+	lpm->count--;
+	return val;
+}
+
+void *lpm_lookup(sixone_lpm lpm, const struct in6_addr *addr, u_int *len)
+{
+	struct lpm_entry *e;
+	struct in6_addr key;
+	u_int i;
+
+	for(i = 0; i < lpm->lens_c; i++) {
+		key = *addr;
+		lpm_mask(&key, lpm->lens[i]);
+		if(NULL != (e = level_find(&lpm->level[lpm->lens[i]], &key, lpm->lens[i]))) {
+			if(NULL != len)
+				*len = lpm->lens[i];
+			return e->val;
+		}
+	}
+	return NULL;
+}
+
+void *lpm_exact(sixone_lpm lpm, const struct in6_addr *pfx, u_int len)
+{
+	struct lpm_entry *e;
+	struct in6_addr key;
+
+	if(len > 128)
+		return NULL;
+	key = *pfx;
+	lpm_mask(&key, len);
+	e = level_find(&lpm->level[len], &key, len);
+	return NULL != e ? e->val : NULL;
+}
+
+u_int lpm_count(sixone_lpm lpm)
+{
+	return lpm->count;
+}
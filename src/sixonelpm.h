@@ -0,0 +1,124 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonelpm.h
+ *  @brief Six-One Router longest prefix match table
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONELPM_H
+#define SIXONELPM_H
+
+#include <sys/types.h>
+#include <sys/socket.h> // required by in.h
+#include <netinet/in.h>
+
+/**
+ * @brief IPv6 prefix -> value table, one hash table per prefix length in use
+ *
+ * Lookups probe the lengths in use from the longest down, mapping tables
+ * only use a handful of lengths so that is a few hash probes per packet.
+ */
+typedef struct sixone_lpm_ *sixone_lpm;
+
+/**
+ *  @brief Allocates an empty table
+ */
+sixone_lpm alloc_sixone_lpm();
+
+/**
+ *  @brief Frees the table
+ *  @param free_val Called on every value, may be NULL
+ */
+void free_sixone_lpm(sixone_lpm lpm, void (*free_val)(void *));
+
+/**
+ *  @brief Removes every entry
+ *  @param free_val Called on every value, may be NULL
+ */
+void lpm_flush(sixone_lpm lpm, void (*free_val)(void *));
+
+/**
+ *  @brief Adds or replaces pfx/len
+ *  @param pfx The prefix, bits past len are ignored
+ *  @param len Prefix length, 0-128
+ *  @param val The value, not NULL
+ *  @return The value it replaced, NULL if the prefix is new (or out of memory)
+ */
+void *lpm_insert(sixone_lpm lpm, const struct in6_addr *pfx, u_int len, void *val);
+
+/**
+ *  @brief The value slot of pfx/len, added (holding NULL) if there is none
+ *
+ *  One probe for a lookup followed by an insert, for building tables in
+ *  bulk. A slot left holding NULL reads as a missing prefix, but still counts.
+ *  @return The slot, NULL out of memory
+ */
+void **lpm_slot(sixone_lpm lpm, const struct in6_addr *pfx, u_int len);
+
+/**
+ *  @brief Makes room for n prefixes of length len, so that inserting them doesn't rehash
+ */
+void lpm_reserve(sixone_lpm lpm, u_int len, u_int n);
+
+/**
+ *  @brief Calls fn on every entry, fn may change the value (not to NULL)
+ */
+void lpm_walk(sixone_lpm lpm, void (*fn)(const struct in6_addr *pfx, u_int len, void **val, void *arg), void *arg);
+
+/**
+ *  @brief Removes pfx/len
+ *  @return The value that was stored for pfx/len, NULL if there was none
+ */
+void *lpm_remove(sixone_lpm lpm, const struct in6_addr *pfx, u_int len);
+
+/**
+ *  @brief Longest prefix match
+ *  @param addr Address to look up
+ *  @param len If not NULL, set to the length of the matching prefix
+ *  @return The value of the longest prefix covering addr, NULL if none does
+ */
+void *lpm_lookup(sixone_lpm lpm, const struct in6_addr *addr, u_int *len);
+
+/**
+ *  @brief Exact match on pfx/len
+ *  @return The value stored for exactly pfx/len, NULL if there is none
+ */
+void *lpm_exact(sixone_lpm lpm, const struct in6_addr *pfx, u_int len);
+
+/**
+ *  @brief Number of prefixes in the table
+ */
+u_int lpm_count(sixone_lpm lpm);
+
+/**
+ *  @brief Zeroes the bits of addr past len
+ */
+void lpm_mask(struct in6_addr *addr, u_int len);
+
+#endif // SIXONELPM_H
@@ -0,0 +1,137 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonemap.c
+ *  @brief Six-One Router reference resolver plugin, mappings.txt in memory
+ *  @date 2026-10-19
+ *
+ *  Resolves like retrieve_mappings_default(), from the same file format,
+ *  but out of a sixone_maptab instead of reading the file
+ *  for every lookup. The file is read with load_mappings() and reloaded
+ *  when its mtime changes, checked once per burst.
+ *  @code
+ *  Plugin= /path/to/sixonemap.so [mappings file, default mappings.txt]
+ *  @endcode
+ */
+
+#include "sixoneplugin.h"
+#include "sixonemaptab.h"
+#include "sixoneload.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+/// @brief The plugin's view of the mapping file
+static struct {
+	char *file;
+	time_t mtime;        /// mtime and size of the file when it was read
+	off_t size;
+	sixone_maptab tab;
+	pthread_mutex_t lock;
+} map = { NULL, 0, 0, NULL, PTHREAD_MUTEX_INITIALIZER };
+
+/**
+ *  @brief (Re)reads the mapping file if it changed, call with the lock held
+ *  @return 0 if the table is usable
+ */
+static int map_load()
+{
+	struct stat st;
+	struct sixone_mapping *m;
+	int n;
+
+	if(0 != stat(map.file, &st)) {
+		fprintf(stderr, "sixonemap: cannot stat %s\n", map.file);
+		return NULL != map.tab ? 0 : -1;
+	}
+	if(NULL != map.tab && st.st_mtime == map.mtime && st.st_size == map.size)
+		return 0;
+	if((n = load_mappings(map.file, 0, NULL, &m)) < 0) {
+		fprintf(stderr, "sixonemap: cannot read %s\n", map.file);
+		return NULL != map.tab ? 0 : -1;
+	}
+
+	if(NULL == map.tab && NULL == (map.tab = alloc_sixone_maptab())) {
+		free(m);
+		return -1;
+	}
+	maptab_flush(map.tab);
+	if(0 != maptab_build(map.tab, m, n))
+		fprintf(stderr, "sixonemap: out of memory reading %s\n", map.file);
+	free(m);
+
+	map.mtime = st.st_mtime;
+	map.size = st.st_size;
+	return 0;
+}
+
+static int map_init(const char *arg)
+{
+	int ret;
+
+	map.file = strdup(*arg ? arg : "mappings.txt");
+	pthread_mutex_lock(&map.lock);
+	ret = map_load();
+	pthread_mutex_unlock(&map.lock);
+	return ret;
+}
+
+static void map_fini()
+{
+	free_sixone_maptab(map.tab);
+	map.tab = NULL;
+	free(map.file);
+}
+
+static int map_resolve(u_int n, sixone_ip addrs[], u_int only_sixone, ip_list out[])
+{
+	u_int i;
+
+	pthread_mutex_lock(&map.lock);
+	if(0 != map_load()) {
+		pthread_mutex_unlock(&map.lock);
+		return -1;
+	}
+	for(i = 0; i < n; i++)
+		out[i] = maptab_resolve(map.tab, &addrs[i]->ip);
+	pthread_mutex_unlock(&map.lock);
+	return 0;
+}
+
+const struct sixone_plugin_ sixone_plugin = {
+	SIXONE_PLUGIN_ABI,
+	"sixonemap",
+	map_init,
+	map_fini,
+	map_resolve,
+	NULL,
+	NULL
+};
@@ -0,0 +1,349 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixonemaptab.c
+ *  @brief Six-One Router in-memory mapping table
+ *  @date 2026-10-19
+ *
+ *  Also linked into sixonemap.so, so everything here is plain calloc()/free().
+ */
+
+#include "sixonemaptab.h"
+#include "sixonepolicy.h" // SIXONE_WEIGHT_DEFAULT
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+static void free_list(void *p)
+{
+	ip_list l = p, next;
+
+	for(; l != NULL; l = next) {
+		next = l->next;
+		free(l->ip);
+		free(l);
+	}
+}
+
+sixone_maptab alloc_sixone_maptab()
+{
+	sixone_maptab tab;
+
+	if(NULL == (tab = calloc(1, sizeof(struct sixone_maptab_))))
+		return NULL;
+	tab->edge = alloc_sixone_lpm();
+	tab->transit = alloc_sixone_lpm();
+	if(NULL == tab->edge || NULL == tab->transit) {
+		free_sixone_maptab(tab);
+		return NULL;
+	}
+	return tab;
+}
+
+void free_sixone_maptab(sixone_maptab tab)
+{
+	if(NULL == tab)
+		return;
+	free_sixone_lpm(tab->edge, free_list);
+	free_sixone_lpm(tab->transit, free_list);
+	free(tab);
+}
+
+void maptab_flush(sixone_maptab tab)
+{
+	lpm_flush(tab->edge, free_list);
+	lpm_flush(tab->transit, free_list);
+	tab->count = 0;
+}
+
+/**
+ *  @brief The element for ip/len in the list stored for key/len, NULL if there is none
+ */
+static ip_list find(sixone_lpm lpm, const struct in6_addr *key, const struct in6_addr *ip, u_int len)
+{
+	ip_list l;
+
+	for(l = lpm_exact(lpm, key, len); l != NULL; l = l->next)
+		if(l->ip->pfx == (int)len && 0 == memcmp(&l->ip->ip, ip, sizeof(*ip)))
+			return l;
+	return NULL;
+}
+
+/**
+ *  @brief Appends ip/len with weight to the list stored for key/len
+ */
+static int append(sixone_lpm lpm, const struct in6_addr *key, const struct in6_addr *ip, u_int len, u_int weight)
+{
+	ip_list l, *tail;
+	void **slot;
+
+	if(NULL == (l = calloc(1, sizeof(struct ip_list_))) || NULL == (l->ip = calloc(1, sizeof(struct sixone_ip_)))) {
+		free(l);
+		return -1;
+	}
+	l->ip->ip = *ip;
+	l->ip->pfx = len;
+	l->weight = weight;
+
+	if(NULL == (slot = lpm_slot(lpm, key, len))) {
+		free_list(l);
+		return -1;
+	}
+	// keep the file order, the policies don't care but it reads better in debug output
+	for(tail = (ip_list *)slot; NULL != *tail; tail = &(*tail)->next)
+		;
+	*tail = l;
+	return 0;
+}
+
+/**
+ *  @brief Unlinks ip/len from the list stored for key/len, and the list from lpm once it is empty
+ */
+static void unlink_ip(sixone_lpm lpm, const struct in6_addr *key, const struct in6_addr *ip, u_int len)
+{
+	ip_list head, *pl, l;
+
+	if(NULL == (head = lpm_exact(lpm, key, len)))
+		return;
+	for(pl = &head; NULL != (l = *pl); pl = &l->next) {
+		if(l->ip->pfx == (int)len && 0 == memcmp(&l->ip->ip, ip, sizeof(*ip))) {
+			*pl = l->next;
+			l->next = NULL;
+			free_list(l);
+			break;
+		}
+	}
+	if(NULL == head)
+		lpm_remove(lpm, key, len);
+	else
+		lpm_insert(lpm, key, len, head);
+}
+
+int maptab_add(sixone_maptab tab, const struct sixone_mapping *m)
+{
+	ip_list l;
+
+	if(NULL != (l = find(tab->edge, &m->edge, &m->transit, m->len))) {
+		l->weight = m->weight;
+		if(NULL != (l = find(tab->transit, &m->transit, &m->edge, m->len)))
+			l->weight = m->weight;
+		return 1;
+	}
+	if(0 != append(tab->edge, &m->edge, &m->transit, m->len, m->weight))
+		return -1;
+	if(0 != append(tab->transit, &m->transit, &m->edge, m->len, m->weight)) {
+		unlink_ip(tab->edge, &m->edge, &m->transit, m->len);
+		return -1;
+	}
+	tab->count++;
+	return 0;
+}
+
+/**
+ * @brief One side of maptab_build()
+ */
+struct build_side {
+	sixone_lpm lpm;
+	const struct sixone_mapping *m;
+	u_int n;
+	int transit;     /// keyed by the transit prefix
+	u_int added;
+	int err;
+};
+
+static void reverse_list(const struct in6_addr *pfx, u_int len, void **val, void *arg)
+{
+	ip_list l = *val, prev = NULL, next;
+
+	for(; l != NULL; l = next) {
+		next = l->next;
+		l->next = prev;
+		prev = l;
+	}
+	*val = prev;
+}
+
+static void *build_side(void *arg)
+{
+	struct build_side *b = arg;
+	const struct in6_addr *key, *ip;
+	ip_list l;
+	void **slot;
+	u_int i;
+
+	for(i = 0; i < b->n; i++) {
+		key = b->transit ? &b->m[i].transit : &b->m[i].edge;
+		ip = b->transit ? &b->m[i].edge : &b->m[i].transit;
+		if(NULL == (slot = lpm_slot(b->lpm, key, b->m[i].len))) {
+			b->err = 1;
+			break;
+		}
+		for(l = *slot; l != NULL; l = l->next)
+			if(l->ip->pfx == (int)b->m[i].len && 0 == memcmp(&l->ip->ip, ip, sizeof(*ip)))
+				break;
+		if(NULL != l) {
+			l->weight = b->m[i].weight;
+			continue;
+		}
+		if(NULL == (l = calloc(1, sizeof(struct ip_list_))) || NULL == (l->ip = calloc(1, sizeof(struct sixone_ip_)))) {
+			free(l);
+			b->err = 1;
+			break;
+		}
+		l->ip->ip = *ip;
+		l->ip->pfx = b->m[i].len;
+		l->weight = b->m[i].weight;
+		// prepended here, every list is turned around once at the end
+		l->next = *slot;
+		*slot = l;
+		b->added++;
+	}
+	lpm_walk(b->lpm, reverse_list, NULL);
+	return NULL;
+}
+
+int maptab_build(sixone_maptab tab, const struct sixone_mapping *m, u_int n)
+{
+	struct build_side side[2];
+	u_int count[129] = { 0 }, i;
+	pthread_t tid;
+	int threaded;
+
+	if(0 != tab->count) {
+		for(i = 0; i < n; i++)
+			if(maptab_add(tab, &m[i]) < 0)
+				return -1;
+		return 0;
+	}
+
+	for(i = 0; i < n; i++)
+		count[m[i].len]++;
+	for(i = 0; i <= 128; i++) {
+		if(count[i]) {
+			lpm_reserve(tab->edge, i, count[i]);
+			lpm_reserve(tab->transit, i, count[i]);
+		}
+	}
+
+	memset(side, 0, sizeof(side));
+	for(i = 0; i < 2; i++) {
+		side[i].lpm = i ? tab->transit : tab->edge;
+		side[i].m = m;
+		side[i].n = n;
+		side[i].transit = i;
+	}
+	threaded = 0 == pthread_create(&tid, NULL, build_side, &side[1]);
+	build_side(&side[0]);
+	if(threaded)
+		pthread_join(tid, NULL);
+	else
+		build_side(&side[1]);
+
+	if(side[0].err || side[1].err) {
+		maptab_flush(tab);
+		return -1;
+	}
+	tab->count = side[0].added;
+	return 0;
+}
+
+int maptab_del(sixone_maptab tab, const struct sixone_mapping *m)
+{
+	if(NULL == find(tab->edge, &m->edge, &m->transit, m->len))
+		return -1;
+	unlink_ip(tab->edge, &m->edge, &m->transit, m->len);
+	unlink_ip(tab->transit, &m->transit, &m->edge, m->len);
+	tab->count--;
+	return 0;
+}
+
+ip_list maptab_resolve(sixone_maptab tab, const struct in6_addr *addr)
+{
+	ip_list l, ret = NULL, *curr = &ret;
+
+	// an address is either one of the remote edges or one of the transits, like the default
+	if(NULL == (l = lpm_lookup(tab->edge, addr, NULL)))
+		l = lpm_lookup(tab->transit, addr, NULL);
+	for(; l != NULL; l = l->next) {
+		if(NULL == ((*curr) = calloc(1, sizeof(struct ip_list_))))
+			break;
+		if(NULL == ((*curr)->ip = calloc(1, sizeof(struct sixone_ip_)))) {
+			free(*curr);
+			*curr = NULL;
+			break;
+		}
+		*(*curr)->ip = *l->ip;
+		(*curr)->weight = l->weight;
+		curr = &(*curr)->next;
+	}
+	return ret;
+}
+
+int maptab_parse(const char *line, struct sixone_mapping *m)
+{
+	char str_edge[INET6_ADDRSTRLEN], str_tran[INET6_ADDRSTRLEN];
+
+	// <edge>/<len> <transit> [weight]
+	switch(sscanf(line, "%45[^/ ]/%u%45s%u", str_edge, &m->len, str_tran, &m->weight)) {
+	case 3:
+		m->weight = SIXONE_WEIGHT_DEFAULT;
+		// fall through
+	case 4:
+		break;
+	default:
+		return -1;
+	}
+	if(m->len > 128 || 1 != inet_pton(AF_INET6, str_edge, &m->edge) || 1 != inet_pton(AF_INET6, str_tran, &m->transit))
+		return -1;
+	return 0;
+}
+
+void maptab_format(const struct sixone_mapping *m, char *buf, size_t size)
+{
+	char str_edge[INET6_ADDRSTRLEN], str_tran[INET6_ADDRSTRLEN];
+
+	inet_ntop(AF_INET6, &m->edge, str_edge, sizeof(str_edge));
+	inet_ntop(AF_INET6, &m->transit, str_tran, sizeof(str_tran));
+	snprintf(buf, size, "%s/%u %s %u", str_edge, m->len, str_tran, m->weight);
+}
+
+int maptab_cmp(const void *a, const void *b)
+{
+	const struct sixone_mapping *x = a, *y = b;
+	int d;
+
+	if(0 != (d = memcmp(&x->edge, &y->edge, sizeof(x->edge))))
+		return d;
+	if(x->len != y->len)
+		return x->len < y->len ? -1 : 1;
+	return memcmp(&x->transit, &y->transit, sizeof(x->transit));
+}
@@ -0,0 +1,118 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixonemaptab.h
+ *  @brief Six-One Router in-memory mapping table
+ *  @date 2026-10-19
+ *
+ *  The mappings of mappings.txt, one "<edge>/<len> <transit> [weight]" per
+ *  line, kept in two longest prefix match tables so that both the remote
+ *  edge and the remote transit prefix of a mapping resolve to the other.
+ *  Mappings are added and removed one at a time, the tables are never
+ *  rebuilt. The table has no lock of its own.
+ */
+
+#ifndef SIXONEMAPTAB_H
+#define SIXONEMAPTAB_H
+
+#include "sixonetypes.h"
+#include "sixonelpm.h"
+
+/**
+ * @brief One line of mappings.txt
+ */
+struct sixone_mapping {
+	struct in6_addr edge;
+	u_int len;
+	struct in6_addr transit;
+	u_int weight;   /// SIXONE_WEIGHT_DEFAULT if the line has none
+};
+
+typedef struct sixone_maptab_ *sixone_maptab;
+struct sixone_maptab_ {
+	sixone_lpm edge;     /// remote edge prefix -> ip_list of its transit prefixes
+	sixone_lpm transit;  /// remote transit prefix -> ip_list of its edge prefixes
+	u_int count;         /// mappings
+};
+
+/**
+ *  @brief Allocates an empty table
+ */
+sixone_maptab alloc_sixone_maptab();
+void free_sixone_maptab(sixone_maptab tab);
+
+/**
+ *  @brief Removes every mapping
+ */
+void maptab_flush(sixone_maptab tab);
+
+/**
+ *  @brief Adds a mapping, or updates the weight of one that is there
+ *  @return 0 if added, 1 if it was there, -1 out of memory
+ */
+int maptab_add(sixone_maptab tab, const struct sixone_mapping *m);
+
+/**
+ *  @brief Adds n mappings to an empty table in one go, as n maptab_add() would
+ *
+ *  Sizes the tables for the mappings up front and fills the edge and the
+ *  transit table concurrently.
+ *  @return 0, -1 out of memory (the table is then flushed)
+ */
+int maptab_build(sixone_maptab tab, const struct sixone_mapping *m, u_int n);
+
+/**
+ *  @brief Removes a mapping, the weight is ignored
+ *  @return 0 if removed, -1 if it wasn't there
+ */
+int maptab_del(sixone_maptab tab, const struct sixone_mapping *m);
+
+/**
+ *  @brief Resolves like retrieve_mappings_default()
+ *  @return A copy of the mappings of addr for the caller to free, NULL if there are none
+ */
+ip_list maptab_resolve(sixone_maptab tab, const struct in6_addr *addr);
+
+/**
+ *  @brief Parses one mappings.txt line
+ *  @return 0 if line is a mapping
+ */
+int maptab_parse(const char *line, struct sixone_mapping *m);
+
+/**
+ *  @brief Formats m as a mappings.txt line, without the newline
+ */
+void maptab_format(const struct sixone_mapping *m, char *buf, size_t size);
+
+/**
+ *  @brief Total order on mappings, the weight is not part of it
+ */
+int maptab_cmp(const void *a, const void *b);
+
+#endif // SIXONEMAPTAB_H
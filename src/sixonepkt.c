@@ -0,0 +1,209 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonepkt.c
+ *  @brief Six-One Router packet descriptor
+ *  @date 2026-10-19
+ */
+
+#include "sixonepkt.h"
+
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/socket.h> // required by ip6.h
+#include <netinet/in.h> // required by ip6.h
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+#include <netinet/udp.h>
+#include <netinet/tcp.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+// Ethernet headers are allways 14 bytes long
+#define SIZE_ETHERNET_HDR 14
+#define ICMPV6_HDR_LEN 4
+/// @brief Longest extension header chain we walk before giving up
+#define PKT_MAX_EXT_HDRS 8
+
+u_int32_t pkt_hash_mix(u_int32_t h, u_int32_t v)
+{
+	h ^= v;
+	h *= 0x9E3779B1;
+	return h ^ (h >> 15);
+}
+
+static u_int32_t flow_hash(sixone_pkt pkt)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	const u_char *l4 = PKT_L4(pkt);
+	u_int32_t w[8], ports = 0, h = pkt->proto;
+	int i;
+
+	memcpy(w, &ip->ip6_src, sizeof(w));
+	for(i = 0; i < 8; i++)
+		h = pkt_hash_mix(h, w[i]);
+
+	if(0 != pkt->l4_off) {
+		switch(pkt->proto) {
+		case IPPROTO_TCP:
+		case IPPROTO_UDP:
+			memcpy(&ports, l4, 4);
+			break;
+		case IPPROTO_ICMPV6:
+			// echo identifier, only echoes carry one and the header may be just 4 bytes
+			if((ICMP6_ECHO_REQUEST == pkt->icmp_type || ICMP6_ECHO_REPLY == pkt->icmp_type)
+			   && PKT_L4_LEN(pkt) >= sizeof(struct icmp6_hdr))
+				memcpy(&ports, l4 + 4, 2);
+			break;
+		}
+	}
+	return pkt_hash_mix(h, ports);
+}
+
+/**
+ *  @brief Walks the IPv6 header at pkt->l3_off and its extension header chain, up to end
+ *  @param quote Non-zero for a quoted packet: an upper layer header cut short leaves l4_off 0
+ */
+static int parse_ip6(sixone_pkt pkt, const u_char *data, u_int end, int quote)
+{
+	const struct ip6_frag *frag;
+	u_int off, hlen, min;
+	u_int8_t nxt;
+	int i;
+
+	off = pkt->l3_off + sizeof(struct ip6_hdr);
+	nxt = ((const struct ip6_hdr *) (data + pkt->l3_off))->ip6_nxt;
+
+	for(i = 0; i < PKT_MAX_EXT_HDRS; i++) {
+		switch(nxt) {
+		case IPPROTO_HOPOPTS:
+		case IPPROTO_ROUTING:
+		case IPPROTO_DSTOPTS:
+			if(off + 8 > end)
+				return -1;
+			hlen = (data[off + 1] + 1) * 8;
+			break;
+		case IPPROTO_AH:
+			if(off + 8 > end)
+				return -1;
+			hlen = (data[off + 1] + 2) * 4;
+			break;
+		case IPPROTO_FRAGMENT:
+			if(off + sizeof(*frag) > end)
+				return -1;
+			frag = (const struct ip6_frag *) (data + off);
+			pkt->flags |= SIXONE_PKT_FRAG;
+			pkt->frag_id = frag->ip6f_ident;
+			if(0 != (frag->ip6f_offlg & IP6F_OFF_MASK))
+				pkt->flags &= ~SIXONE_PKT_FIRST;
+			hlen = sizeof(*frag);
+			break;
+		default:
+			goto upper;
+		}
+		if(off + hlen > end)
+			return -1;
+		nxt = data[off];
+		off += hlen;
+	}
+	// chain too long, leave it alone
+	return -1;
+
+ upper:
+	pkt->proto = nxt;
+
+	if(pkt->flags & SIXONE_PKT_FIRST) {
+		switch(nxt) {
+		case IPPROTO_TCP: min = sizeof(struct tcphdr); break;
+		case IPPROTO_UDP: min = sizeof(struct udphdr); break;
+		case IPPROTO_ICMPV6: min = ICMPV6_HDR_LEN; break;
+		default: min = 0;
+		}
+		if(off + min > end) {
+			if(!quote)
+				return -1;
+		}
+		else {
+			if(IPPROTO_NONE != nxt && off < end)
+				pkt->l4_off = off;
+			if(IPPROTO_ICMPV6 == nxt)
+				pkt->icmp_type = data[off];
+		}
+	}
+
+	pkt->hash = flow_hash(pkt);
+	return 0;
+}
+
+int parse_packet(sixone_pkt pkt, const u_char *data, u_int caplen)
+{
+	const struct ether_header *eth = (const struct ether_header *) data;
+	const struct ip6_hdr *ip;
+	u_int end;
+
+	memset(pkt, 0, sizeof(*pkt));
+	pkt->data = (u_char *) data;
+	pkt->caplen = caplen;
+	pkt->l3_off = SIZE_ETHERNET_HDR;
+	pkt->flags = SIXONE_PKT_FIRST;
+
+	if(caplen < SIZE_ETHERNET_HDR + sizeof(*ip) || ETHERTYPE_IPV6 != ntohs(eth->ether_type))
+		return -1;
+
+	ip = (const struct ip6_hdr *) (data + SIZE_ETHERNET_HDR);
+	if(6 != (ip->ip6_vfc >> 4))
+		return -1;
+
+	// 40 + plen does not fit 16 bits, len is wide enough for the largest one
+	pkt->len = sizeof(*ip) + ntohs(ip->ip6_plen);
+	end = SIZE_ETHERNET_HDR + pkt->len;
+	if(end > caplen)
+		return -1;
+
+	return parse_ip6(pkt, data, end, 0);
+}
+
+int parse_quote(sixone_pkt pkt, const u_char *data, u_int len)
+{
+	const struct ip6_hdr *ip = (const struct ip6_hdr *) data;
+
+	memset(pkt, 0, sizeof(*pkt));
+	pkt->data = (u_char *) data;
+	pkt->caplen = len;
+	pkt->flags = SIXONE_PKT_FIRST;
+
+	if(len < sizeof(*ip) || 6 != (ip->ip6_vfc >> 4))
+		return -1;
+
+	// the error quotes as much as fits, the packet may go on past the quote
+	pkt->len = sizeof(*ip) + ntohs(ip->ip6_plen);
+	if(pkt->len > len)
+		pkt->len = len;
+
+	return parse_ip6(pkt, data, pkt->len, 1);
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonepkt.h
+ *  @brief Six-One Router packet descriptor
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONEPKT_H
+#define SIXONEPKT_H
+
+#include <sys/types.h>
+#include <sys/socket.h> // required by ip6.h
+#include <netinet/in.h> // required by ip6.h
+#include <netinet/ip6.h>
+
+/// @brief A fragment header was found
+#define SIXONE_PKT_FRAG 0x01
+/// @brief The packet is the first fragment (or not a fragment), the upper layer header is present
+#define SIXONE_PKT_FIRST 0x02
+
+/**
+ * @brief What the packet path needs to know about a frame, filled in once by parse_packet()
+ */
+typedef struct sixone_pkt_ {
+	u_char *data;        /// start of the ethernet frame
+	u_int caplen;        /// bytes captured
+	u_int16_t l3_off;    /// offset of the IPv6 header
+	u_int16_t l4_off;    /// offset of the upper layer header, 0 if there is none (e.g. non-first fragment)
+	u_int32_t len;       /// IPv6 header + payload length, up to 40 + 65535
+	u_int8_t proto;      /// upper layer protocol, the last next header value of the chain
+	u_int8_t flags;      /// SIXONE_PKT_*
+	u_int8_t icmp_type;  /// ICMPv6 type, valid if proto is ICMPv6 and l4_off != 0
+	u_int32_t frag_id;   /// identification of the fragment header (network order), valid if SIXONE_PKT_FRAG
+	u_int32_t hash;      /// flow hash over addresses, protocol and ports / echo id
+	u_int64_t ts_us;     /// capture time (us), set by the caller, parse_packet() leaves it 0
+} *sixone_pkt;
+
+/// @brief The IPv6 header of a parsed packet
+#define PKT_IP6(pkt) ((struct ip6_hdr *)((pkt)->data + (pkt)->l3_off))
+/// @brief The upper layer header of a parsed packet (check l4_off first)
+#define PKT_L4(pkt) ((pkt)->data + (pkt)->l4_off)
+/// @brief Bytes from the upper layer header to the end of the IPv6 payload
+#define PKT_L4_LEN(pkt) ((pkt)->l3_off + (pkt)->len - (pkt)->l4_off)
+
+/**
+ *  @brief Parses an ethernet/IPv6 frame in one pass.
+ *
+ *  Walks the extension header chain (hop-by-hop, routing, fragment,
+ *  destination options, AH) with every access checked against caplen, and
+ *  fills in the descriptor the rest of the packet path works on.
+ *  @param pkt The descriptor to fill in
+ *  @param data The frame
+ *  @param caplen Number of captured bytes
+ *  @return 0 if pkt describes a complete IPv6 packet, -1 if the frame is not IPv6, truncated or malformed
+ */
+int parse_packet(sixone_pkt pkt, const u_char *data, u_int caplen);
+
+/**
+ *  @brief Parses the packet an ICMPv6 error quotes, as parse_packet() does a frame.
+ *
+ *  The quote starts at the IPv6 header (l3_off is 0) and may stop anywhere
+ *  past it: len is then the length of the quote, and an upper layer header
+ *  that is cut short leaves l4_off 0 rather than failing the parse.
+ *  @param pkt The descriptor to fill in
+ *  @param data The quoted IPv6 header
+ *  @param len Number of bytes quoted
+ *  @return 0 if pkt describes the quote, -1 if it does not hold an IPv6 header or its chain is cut short
+ */
+int parse_quote(sixone_pkt pkt, const u_char *data, u_int len);
+
+/**
+ *  @brief Mixes 32 bits into a flow hash (multiply-xorshift)
+ */
+u_int32_t pkt_hash_mix(u_int32_t h, u_int32_t v);
+
+#endif
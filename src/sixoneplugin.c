@@ -0,0 +1,110 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneplugin.c
+ *  @brief Six-One Router resolver/policy plugin loader
+ *  @date 2026-10-19
+ */
+
+#include "sixoneplugin.h"
+#include "sixonelib.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// @brief The loaded plugin, NULL if none
+static const struct sixone_plugin_ *sixone_plugin_ops;
+
+/**
+ *  @brief sixone_resolv hook for plugins, a burst of one
+ */
+static ip_list plugin_resolv(sixone_ip ip, u_int only_sixone)
+{
+	ip_list ret = NULL;
+
+	if(0 != sixone_plugin_ops->resolve(1, &ip, only_sixone, &ret))
+		return NULL;
+	return ret;
+}
+
+static void plugin_fini()
+{
+	if(NULL != sixone_plugin_ops && NULL != sixone_plugin_ops->fini)
+		sixone_plugin_ops->fini();
+}
+
+int load_plugin(sixone_settings settings, const char *path, const char *arg)
+{
+	const struct sixone_plugin_ *ops;
+	void *handle;
+
+	if(NULL != sixone_plugin_ops) {
+		fprintf(stderr, "Plugin %s: a plugin (%s) is loaded already\n", path, sixone_plugin_ops->name);
+		return -1;
+	}
+
+	if(NULL == (handle = dlopen(path, RTLD_NOW | RTLD_LOCAL))) {
+		fprintf(stderr, "Plugin %s: %s\n", path, dlerror());
+		return -1;
+	}
+	if(NULL == (ops = dlsym(handle, SIXONE_PLUGIN_SYMBOL))) {
+		fprintf(stderr, "Plugin %s: no %s symbol\n", path, SIXONE_PLUGIN_SYMBOL);
+		dlclose(handle);
+		return -1;
+	}
+	if(SIXONE_PLUGIN_ABI != ops->abi) {
+		fprintf(stderr, "Plugin %s: built for ABI %u, the router speaks %u\n", path, ops->abi, SIXONE_PLUGIN_ABI);
+		dlclose(handle);
+		return -1;
+	}
+	if(NULL == ops->resolve) {
+		fprintf(stderr, "Plugin %s: no resolve function\n", path);
+		dlclose(handle);
+		return -1;
+	}
+	if(NULL != ops->init && 0 != ops->init(NULL != arg ? arg : "")) {
+		fprintf(stderr, "Plugin %s: init failed\n", path);
+		dlclose(handle);
+		return -1;
+	}
+
+	// the handle stays open for the life of the router
+	sixone_plugin_ops = ops;
+	atexit(plugin_fini);
+
+	settings->resolv->sixone_resolv = plugin_resolv;
+	settings->resolv->sixone_resolv_batch = ops->resolve;
+	if(NULL != ops->policy_dst)
+		settings->policy->sixone_policy_dst = ops->policy_dst;
+	if(NULL != ops->policy_src)
+		settings->policy->sixone_policy_src = ops->policy_src;
+
+	printf("Loaded plugin %s (%s)\n", ops->name, path);
+	return 0;
+}
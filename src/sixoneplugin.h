@@ -0,0 +1,98 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneplugin.h
+ *  @brief Six-One Router resolver/policy plugin ABI
+ *  @date 2026-10-19
+ *
+ *  A plugin is a shared object exporting a struct sixone_plugin_ named
+ *  sixone_plugin (SIXONE_PLUGIN_SYMBOL). The router configuration names it:
+ *  @code
+ *  Plugin= /usr/local/lib/sixone/sixonemap.so mappings.txt
+ *  @endcode
+ *  and everything after the path is handed to init(). Plugins only need
+ *  this header and sixonetypes.h, they don't link against the router.
+ */
+
+#ifndef SIXONEPLUGIN_H
+#define SIXONEPLUGIN_H
+
+#include "sixonetypes.h"
+
+/// @brief Version of struct sixone_plugin_, bumped on every incompatible change
+#define SIXONE_PLUGIN_ABI 1
+/// @brief The symbol the router looks up
+#define SIXONE_PLUGIN_SYMBOL "sixone_plugin"
+
+/**
+ * @brief What a plugin provides, every function pointer but resolve may be NULL
+ */
+struct sixone_plugin_ {
+	u_int abi;          /// SIXONE_PLUGIN_ABI the plugin was built against
+	const char *name;
+
+	/**
+	 *  @brief Called once after loading
+	 *  @param arg The rest of the Plugin= line, "" if there is none
+	 *  @return 0 on success, anything else makes the router refuse to start
+	 */
+	int (*init)(const char *arg);
+
+	/// @brief Called once when the router exits
+	void (*fini)(void);
+
+	/**
+	 *  @brief Resolves a burst of addresses at once
+	 *
+	 *  Same semantics as the sixone_resolv hook: for an edge address the
+	 *  transit prefixes, for a transit address the edge prefixes. Lists
+	 *  are built from calloc()ed struct ip_list_/struct sixone_ip_ and
+	 *  belong to the router.
+	 *  @param n Number of addresses
+	 *  @param addrs The addresses (prefix length 128)
+	 *  @param only_sixone As for sixone_resolv
+	 *  @param out Set to the mappings of addrs[i], NULL if there are none
+	 *  @return 0 on success, -1 if nothing could be resolved (out is ignored)
+	 */
+	int (*resolve)(u_int n, sixone_ip addrs[], u_int only_sixone, ip_list out[]);
+
+	/// @brief sixone_policy hooks, NULL keeps the router's own policy
+	sixone_ip (*policy_dst)(ip_list list, u_int32_t flow);
+	sixone_ip (*policy_src)(ip_list list, u_int32_t flow);
+};
+
+/**
+ *  @brief Loads the plugin at path and installs its hooks in settings
+ *
+ *  Checks the ABI version, calls init(arg) and arranges for fini() to run
+ *  at exit. Only one plugin can be loaded.
+ *  @return 0 on success, -1 (with a message on stderr) otherwise
+ */
+int load_plugin(sixone_settings settings, const char *path, const char *arg);
+
+#endif // SIXONEPLUGIN_H
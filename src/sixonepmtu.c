@@ -0,0 +1,216 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonepmtu.c
+ *  @brief Six-One Router MTU of the path a packet takes
+ *  @date 2026-10-19
+ */
+
+#include "sixonepmtu.h"
+#include "sixonecksum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+sixone_pmtu global_pmtu;
+
+sixone_pmtu alloc_sixone_pmtu()
+{
+	sixone_pmtu pmtu;
+
+	if(NULL == (pmtu = calloc(1, sizeof(*pmtu))))
+		return NULL;
+	pthread_mutex_init(&pmtu->lock, NULL);
+	return pmtu;
+}
+
+void free_sixone_pmtu(sixone_pmtu pmtu)
+{
+	if(NULL == pmtu)
+		return;
+	pthread_mutex_destroy(&pmtu->lock);
+	free(pmtu);
+}
+
+static struct pmtu_entry *pmtu_slot(sixone_pmtu pmtu, const struct in6_addr *dst)
+{
+	u_int32_t w[4], h = 0;
+	int i;
+
+	memcpy(w, dst, sizeof(w));
+	for(i = 0; i < 4; i++)
+		h = pkt_hash_mix(h, w[i]);
+	return &pmtu->slot[h & (PMTU_SLOTS - 1)];
+}
+
+u_int pmtu_lookup(sixone_pmtu pmtu, const struct in6_addr *dst, u_int64_t now_us)
+{
+	struct pmtu_entry *e;
+	u_int32_t seq, mtu;
+	int match;
+
+	if(0 == __atomic_load_n(&pmtu->learned, __ATOMIC_RELAXED))
+		return 0;
+	e = pmtu_slot(pmtu, dst);
+	for(;;) {
+		seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+		if(seq & 1)
+			continue;
+		mtu = e->mtu;
+		match = 0 != mtu && now_us < e->expires_us && 0 == memcmp(&e->dst, dst, sizeof(*dst));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(seq == __atomic_load_n(&e->seq, __ATOMIC_RELAXED))
+			break;
+	}
+	return match ? mtu : 0;
+}
+
+int pmtu_learn(sixone_pmtu pmtu, sixone_image image, sixone_pkt pkt, u_int64_t now_us)
+{
+	struct icmp6_hdr *icmp = (struct icmp6_hdr *)PKT_L4(pkt);
+	struct ip6_hdr *inner = (struct ip6_hdr *)(icmp + 1);
+	struct pmtu_entry *e;
+	u_int mtu, known;
+
+	// inbound_error() mapped the quote back to a packet from one of our edge hosts
+	if(0 == pkt->l4_off || PKT_L4_LEN(pkt) < sizeof(*icmp) + sizeof(*inner) ||
+	   0 > image_find_edge(image, &inner->ip6_src)) {
+		__atomic_fetch_add(&pmtu->ignored, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+	mtu = ntohl(icmp->icmp6_mtu);
+	if(mtu < PMTU_MIN)
+		mtu = PMTU_MIN;
+	known = pmtu_lookup(pmtu, &inner->ip6_dst, now_us);
+	if(mtu >= image->transit_mtu_min || (0 != known && mtu >= known)) {
+		__atomic_fetch_add(&pmtu->ignored, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	pthread_mutex_lock(&pmtu->lock);
+	e = pmtu_slot(pmtu, &inner->ip6_dst);
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	e->dst = inner->ip6_dst;
+	e->mtu = mtu;
+	e->expires_us = now_us + PMTU_EXPIRE_US;
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&pmtu->learned, pmtu->learned + 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&pmtu->lock);
+	return 0;
+}
+
+u_int pmtu_of(sixone_pmtu pmtu, sixone_image image, const struct ip6_hdr *ip, u_int64_t now_us)
+{
+	u_int mtu, path;
+	int e;
+
+	if(0 <= (e = image_find_edge(image, &ip->ip6_dst)))
+		return image->edge_mtu[e];
+	if(0 <= image_find_transit(image, &ip->ip6_dst))
+		return image->edge_mtu_min;
+	mtu = image->transit_mtu_min;
+	if(NULL != pmtu && 0 != (path = pmtu_lookup(pmtu, &ip->ip6_dst, now_us)) && path < mtu)
+		mtu = path;
+	return mtu;
+}
+
+int pmtu_clamp_mss(sixone_pmtu pmtu, sixone_image image, sixone_pkt pkt, u_int mtu)
+{
+	struct tcphdr *th = (struct tcphdr *)PKT_L4(pkt);
+	const struct ip6_hdr *ip = PKT_IP6(pkt);
+	u_char *opt, *end, *w;
+	u_int16_t prev[2], word;
+	u_int clamp, mss, i, n;
+	int e;
+
+	if(IPPROTO_TCP != pkt->proto || 0 == pkt->l4_off || PKT_L4_LEN(pkt) < sizeof(*th) ||
+	   0 == (th->th_flags & TH_SYN))
+		return 0;
+
+	// the interface the SYN leaves on, as pmtu_of() picks its MTU
+	if(0 <= (e = image_find_edge(image, &ip->ip6_dst)))
+		clamp = image->edge_mss[e];
+	else if(0 <= image_find_transit(image, &ip->ip6_dst))
+		clamp = image->edge_mss_min;
+	else
+		clamp = image->transit_mss;
+	if(0 == clamp)
+		return 0;
+	if(clamp > mtu - SIXONE_MSS_HDRS)
+		clamp = mtu - SIXONE_MSS_HDRS;
+
+	opt = (u_char *)(th + 1);
+	end = PKT_L4(pkt) + th->th_off * 4;
+	if(end > PKT_L4(pkt) + PKT_L4_LEN(pkt))
+		return 0;
+	while(opt < end && TCPOPT_MAXSEG != *opt) {
+		if(TCPOPT_EOL == *opt)
+			return 0;
+		if(TCPOPT_NOP == *opt) {
+			opt++;
+			continue;
+		}
+		if(opt + 2 > end || opt[1] < 2)
+			return 0;
+		opt += opt[1];
+	}
+	if(opt + TCPOLEN_MAXSEG > end || TCPOLEN_MAXSEG != opt[1])
+		return 0;
+	mss = opt[2] << 8 | opt[3];
+	if(mss <= clamp)
+		return 0;
+
+	// the checksum adds up 16 bit words from the start of the header, an odd option straddles two
+	w = PKT_L4(pkt) + ((opt + 2 - PKT_L4(pkt)) & ~1);
+	n = (opt + 2 == w) ? 1 : 2;
+	memcpy(prev, w, n * sizeof(prev[0]));
+	opt[2] = clamp >> 8;
+	opt[3] = clamp & 0xFF;
+	for(i = 0; i < n; i++) {
+		memcpy(&word, w + i * sizeof(word), sizeof(word));
+		th->th_sum = cksum_update_word(th->th_sum, prev[i], word);
+	}
+	if(NULL != pmtu)
+		__atomic_add_fetch(&pmtu->clamped, 1, __ATOMIC_RELAXED);
+	return 1;
+}
+
+void pmtu_report(sixone_pmtu pmtu, sixone_image image)
+{
+	printf("  mtu: edge %u, transit %u, %u packets too big, %u path MTUs learned, %u Packet Too Big ignored\n",
+	       image->edge_mtu_min, image->transit_mtu_min, pmtu->too_big, pmtu->learned, pmtu->ignored);
+	if(0 != image->mss_c)
+		printf("  mss: %u SYNs clamped\n", pmtu->clamped);
+}
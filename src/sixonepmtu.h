@@ -0,0 +1,134 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonepmtu.h
+ *  @brief Six-One Router MTU of the path a packet takes
+ *  @date 2026-10-19
+ *
+ *  The MTU a packet has to fit is known before any lookup: the MTU of
+ *  the interface of its edge net when it is addressed to one, the
+ *  smallest edge MTU when it is addressed to a transit address (the
+ *  edge net it ends up in is only known after the lookup), otherwise
+ *  the smallest transit MTU, lowered by what the path to its
+ *  destination is known to take. process_packet() answers a packet
+ *  that does not fit with a Packet Too Big before doing anything else.
+ *
+ *  The path MTUs come from the Packet Too Big messages transit routers
+ *  send about our outbound packets (RFC 8201). inbound_error() maps the
+ *  quote back first, so the MTU is kept under the destination the edge
+ *  host used, which is what the next packet is checked by (never below
+ *  1280), and forgotten after PMTU_EXPIRE_US, so a path that grows
+ *  again is found. The cache is a direct mapped table, a new
+ *  destination replaces the one it collides with; lookups do not lock.
+ *
+ *  Hosts behind a tunnel or a smaller transit MTU only learn it from a
+ *  Packet Too Big that a filter may eat. An interface section with an
+ *  MSS= line has the MSS option of SYNs and SYN-ACKs leaving on it
+ *  lowered to the same MTU, so TCP never sends segments that big.
+ */
+
+#ifndef SIXONEPMTU_H
+#define SIXONEPMTU_H
+
+#include <pthread.h>
+
+#include "sixonepkt.h"
+#include "sixonetypes.h"
+
+/// @brief Destinations remembered (a power of two)
+#define PMTU_SLOTS 4096
+/// @brief A learned path MTU is forgotten after this long (us, RFC 8201 recommends 10 min)
+#define PMTU_EXPIRE_US (600 * 1000000ULL)
+/// @brief The smallest MTU an IPv6 path may have
+#define PMTU_MIN 1280
+
+/**
+ * @brief The path MTU to a destination
+ */
+struct pmtu_entry {
+	u_int32_t seq;          /// odd while the entry is written
+	u_int32_t mtu;          /// 0 for an unused slot
+	struct in6_addr dst;
+	u_int64_t expires_us;
+};
+
+/**
+ * @brief The path MTU cache
+ */
+typedef struct sixone_pmtu_ {
+	pthread_mutex_t lock;   /// writers
+	u_int learned;          /// path MTUs learned, lookups skip the table until there is one
+	u_int ignored;          /// Packet Too Big messages not about a packet of ours, or not lowering anything
+	u_int too_big;          /// packets answered with a Packet Too Big
+	u_int clamped;          /// SYNs whose MSS was lowered
+	struct pmtu_entry slot[PMTU_SLOTS];
+} *sixone_pmtu;
+
+/// @brief The path MTU cache
+extern sixone_pmtu global_pmtu;
+
+sixone_pmtu alloc_sixone_pmtu();
+
+void free_sixone_pmtu(sixone_pmtu pmtu);
+
+/**
+ *  @brief Learns from a Packet Too Big that arrived on transit
+ *  @param pkt An ICMPv6 Packet Too Big (check icmp_type first), its quote mapped back to the edge host
+ *  @return 0 if a path MTU was learned, -1 if the message was ignored
+ */
+int pmtu_learn(sixone_pmtu pmtu, sixone_image image, sixone_pkt pkt, u_int64_t now_us);
+
+/**
+ *  @brief The path MTU to dst
+ *  @return The MTU, 0 if none is known
+ */
+u_int pmtu_lookup(sixone_pmtu pmtu, const struct in6_addr *dst, u_int64_t now_us);
+
+/**
+ *  @brief The MTU a packet has to fit, see above
+ *  @param pmtu The cache, may be NULL
+ */
+u_int pmtu_of(sixone_pmtu pmtu, sixone_image image, const struct ip6_hdr *ip, u_int64_t now_us);
+
+/**
+ *  @brief Lowers the MSS option of a SYN or SYN-ACK to what the interface it leaves on fits
+ *
+ *  Only does something if that interface has an MSS= line, the MSS is then lowered to that
+ *  value and to mtu less the IPv6 and TCP headers, the TCP checksum is updated incrementally.
+ *  @param pmtu For the counter, may be NULL
+ *  @param mtu What pmtu_of() said the packet has to fit
+ *  @return 1 if the MSS was lowered, 0 if the packet was left alone
+ */
+int pmtu_clamp_mss(sixone_pmtu pmtu, sixone_image image, sixone_pkt pkt, u_int mtu);
+
+/**
+ *  @brief Prints the cache counters (replay report)
+ */
+void pmtu_report(sixone_pmtu pmtu, sixone_image image);
+
+#endif // SIXONEPMTU_H
@@ -0,0 +1,122 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonepolicy.c
+ *  @brief Six-One Router built-in multipath policy
+ *  @date 2026-10-19
+ */
+
+#include "sixonepolicy.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+/// @brief Mantissa bits the log2 table is indexed by, the rest interpolates
+#define POLICY_LOG_BITS 10
+/// @brief Scores are -log2(u) in units of 2^-POLICY_LOG_SHIFT
+#define POLICY_LOG_SHIFT 24
+
+/// @brief log2(1 + i / 2^POLICY_LOG_BITS) in score units
+static u_int32_t policy_log_tab[(1 << POLICY_LOG_BITS) + 1];
+static pthread_once_t policy_log_once = PTHREAD_ONCE_INIT;
+
+static void policy_log_init()
+{
+	u_int i;
+
+	for(i = 0; i <= 1 << POLICY_LOG_BITS; i++)
+		policy_log_tab[i] = log2(1 + (double)i / (1 << POLICY_LOG_BITS)) * (1 << POLICY_LOG_SHIFT) + 0.5;
+}
+
+/**
+ *  @brief splitmix64 finalizer
+ */
+static u_int64_t policy_mix(u_int64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ *  @brief Hash of flow and prefix, depends on the prefix alone so the other candidates don't matter
+ */
+static u_int64_t policy_hash(u_int32_t flow, sixone_ip ip)
+{
+	u_int64_t w[2], h;
+
+	memcpy(w, &ip->ip, sizeof(w));
+	h = policy_mix(flow ^ ((u_int64_t)ip->pfx << 32));
+	h = policy_mix(h ^ w[0]);
+	return policy_mix(h ^ w[1]);
+}
+
+/**
+ *  @brief -log2(h / 2^64) in score units, h taken as a fraction of 2^64
+ */
+static u_int64_t policy_neglog(u_int64_t h)
+{
+	u_int64_t m, frac;
+	u_int32_t lo, hi;
+	int lz;
+
+	h |= 1;
+	lz = __builtin_clzll(h);
+	// h / 2^64 = m / 2^63 * 2^-(lz + 1), m with its leading one at bit 63
+	m = h << lz;
+	lo = policy_log_tab[(m >> (63 - POLICY_LOG_BITS)) & ((1 << POLICY_LOG_BITS) - 1)];
+	hi = policy_log_tab[((m >> (63 - POLICY_LOG_BITS)) & ((1 << POLICY_LOG_BITS) - 1)) + 1];
+	frac = (m >> (31 - POLICY_LOG_BITS)) & 0xffffffffULL;
+	return ((u_int64_t)(lz + 1) << POLICY_LOG_SHIFT) - lo - (((u_int64_t)(hi - lo) * frac) >> 32);
+}
+
+sixone_ip policy_pick_weighted(ip_list list, u_int32_t flow)
+{
+	sixone_ip best = NULL;
+	u_int64_t score, best_score = 0, weight, best_weight = 1;
+
+	if(NULL == list)
+		return NULL;
+	// the common single homed case
+	if(NULL == list->next)
+		return list->ip;
+
+	pthread_once(&policy_log_once, policy_log_init);
+	for(; list != NULL; list = list->next) {
+		// weight / -ln(u) is highest where -log2(u) / weight is lowest, compared crosswise
+		score = policy_neglog(policy_hash(flow, list->ip));
+		weight = list->weight ? list->weight : SIXONE_WEIGHT_DEFAULT;
+		if(NULL == best || score * best_weight < best_score * weight) {
+			best = list->ip;
+			best_score = score;
+			best_weight = weight;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,58 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonepolicy.h
+ *  @brief Six-One Router built-in multipath policy
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONEPOLICY_H
+#define SIXONEPOLICY_H
+
+#include "sixonetypes.h"
+
+/// @brief Weight of a mapping that does not state one (ip_list weight 0)
+#define SIXONE_WEIGHT_DEFAULT 1
+
+/**
+ *  @brief Weighted rendezvous (highest random weight) pick of one prefix per flow.
+ *
+ *  Every prefix scores weight / -ln(u), u being a hash of the flow and the
+ *  prefix mapped to (0,1), and the highest score wins. A flow therefore
+ *  always gets the same prefix, flows spread in proportion to the weights,
+ *  and adding or removing a prefix only moves the flows that gain or lose it.
+ *  The score is kept in fixed point, -log2(u) from a table interpolated
+ *  linearly and divided by the weight through a cross multiplication, so a
+ *  pick is hashing, a table read and integer compares per prefix.
+ *  @param list The candidates, weight 0 counts as SIXONE_WEIGHT_DEFAULT
+ *  @param flow Flow hash of the packet (sixone_pkt hash)
+ *  @return The picked prefix, NULL if list is empty
+ */
+sixone_ip policy_pick_weighted(ip_list list, u_int32_t flow);
+
+#endif // SIXONEPOLICY_H
@@ -0,0 +1,721 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixonerepl.c
+ *  @brief Six-One Router mapping table replication
+ *  @date 2026-10-19
+ *
+ *  Each end runs one thread; the primary's polls the file, its listening
+ *  socket and the followers, a follower's its connection to the primary.
+ */
+
+#include "sixonerepl.h"
+#include "sixoneload.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+sixone_repl global_repl;
+
+/// @brief Longest line taken from the other end
+#define REPL_LINE_MAX 256
+
+static u_int64_t repl_now_us()
+{
+	struct timespec ts;
+
+	// wall clock, the lag is measured across processes
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ *  @brief Listens on or connects to addr
+ *  @return The socket, -1 on errors
+ */
+static int repl_open(const char *addr, int listening)
+{
+	struct sockaddr_un sun;
+	struct addrinfo hints, *res, *ai;
+	char host[256], *port;
+	int fd = -1, on = 1;
+
+	if(NULL != strchr(addr, '/')) {
+		memset(&sun, 0, sizeof(sun));
+		sun.sun_family = AF_UNIX;
+		if(strlen(addr) >= sizeof(sun.sun_path) || -1 == (fd = socket(AF_UNIX, SOCK_STREAM, 0)))
+			return -1;
+		strcpy(sun.sun_path, addr);
+		if(listening)
+			unlink(addr);
+		if(listening ? 0 != bind(fd, (struct sockaddr *)&sun, sizeof(sun)) || 0 != listen(fd, 16)
+		   : 0 != connect(fd, (struct sockaddr *)&sun, sizeof(sun))) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	// <host>:<port>, [<host>]:<port>, an empty host listens on all addresses
+	if(strlen(addr) >= sizeof(host) || NULL == (port = strrchr(strcpy(host, addr), ':')))
+		return -1;
+	*port++ = 0;
+	if('[' == host[0] && ']' == host[strlen(host) - 1]) {
+		host[strlen(host) - 1] = 0;
+		memmove(host, host + 1, strlen(host));
+	}
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = listening ? AI_PASSIVE : 0;
+	if(0 != getaddrinfo(*host ? host : NULL, port, &hints, &res))
+		return -1;
+	for(ai = res; ai != NULL; ai = ai->ai_next) {
+		if(-1 == (fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)))
+			continue;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		if(listening ? 0 == bind(fd, ai->ai_addr, ai->ai_addrlen) && 0 == listen(fd, 16)
+		   : 0 == connect(fd, ai->ai_addr, ai->ai_addrlen))
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
+/**
+ *  @brief Splits the lines in buf, calls fn on each and keeps the partial one
+ *  @return What fn returned, the first non-zero stops
+ */
+static int repl_lines(char *buf, u_int *len, int (*fn)(sixone_repl, void *, char *), sixone_repl repl, void *arg)
+{
+	char *line, *nl;
+	int ret = 0;
+
+	buf[*len] = 0;
+	for(line = buf; 0 == ret && NULL != (nl = strchr(line, '\n')); line = nl + 1) {
+		*nl = 0;
+		ret = fn(repl, arg, line);
+	}
+	*len -= line - buf;
+	memmove(buf, line, *len);
+	// a line that doesn't fit is garbage
+	if(REPL_LINE_MAX - 1 == *len)
+		*len = 0;
+	return ret;
+}
+
+/*
+ * The primary
+ */
+
+static void peer_close(struct repl_peer *p)
+{
+	close(p->fd);
+	free(p->out);
+	memset(p, 0, sizeof(*p));
+	p->fd = -1;
+}
+
+/**
+ *  @brief Queues a line for a follower, disconnects it when it falls too far behind
+ */
+static void peer_send(struct repl_peer *p, const char *fmt, ...)
+{
+	char line[REPL_LINE_MAX], *grown;
+	va_list ap;
+	int len;
+
+	if(-1 == p->fd)
+		return;
+	va_start(ap, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	if(len < 0 || len >= (int)sizeof(line))
+		return;
+
+	if(p->out_len + len > p->out_size) {
+		if(p->out_len + len > REPL_OUT_MAX
+		   || NULL == (grown = realloc(p->out, p->out_size ? p->out_size * 2 : 65536))) {
+			fprintf(stderr, "Replication: follower too far behind, disconnected\n");
+			peer_close(p);
+			return;
+		}
+		p->out = grown;
+		p->out_size = p->out_size ? p->out_size * 2 : 65536;
+	}
+	memcpy(p->out + p->out_len, line, len);
+	p->out_len += len;
+}
+
+static void peer_record(struct repl_peer *p, const struct repl_rec *r)
+{
+	char m[REPL_LINE_MAX];
+
+	maptab_format(&r->m, m, sizeof(m));
+	peer_send(p, "L %llu %llu %c %s\n", (unsigned long long)r->seq, (unsigned long long)r->ts_us, r->op, m);
+}
+
+static void peer_heartbeat(sixone_repl repl, struct repl_peer *p)
+{
+	peer_send(p, "H %llu %llu\n", (unsigned long long)repl->seq, (unsigned long long)repl_now_us());
+}
+
+/**
+ *  @brief Catches a follower up from where it says it is
+ */
+static void peer_hello(sixone_repl repl, struct repl_peer *p, u_int64_t epoch, u_int64_t seq)
+{
+	char m[REPL_LINE_MAX];
+	u_int i;
+
+	if(epoch == repl->epoch && seq <= repl->seq && seq + REPL_LOG_MAX >= repl->seq) {
+		peer_send(p, "R %llu %llu\n", (unsigned long long)epoch, (unsigned long long)seq);
+		for(; seq < repl->seq; seq++)
+			peer_record(p, &repl->log[(seq + 1) % REPL_LOG_MAX]);
+	}
+	else {
+		peer_send(p, "S %llu %llu\n", (unsigned long long)repl->epoch, (unsigned long long)repl->seq);
+		for(i = 0; i < repl->cur_c; i++) {
+			maptab_format(&repl->cur[i], m, sizeof(m));
+			peer_send(p, "+ %s\n", m);
+		}
+		peer_send(p, "E\n");
+	}
+	peer_heartbeat(repl, p);
+	p->hello = 1;
+}
+
+static int peer_line(sixone_repl repl, void *arg, char *line)
+{
+	struct repl_peer *p = arg;
+	unsigned long long epoch, seq;
+
+	if(!p->hello && 2 == sscanf(line, "F %llu %llu", &epoch, &seq))
+		peer_hello(repl, p, epoch, seq);
+	else if(p->hello && 1 == sscanf(line, "A %llu", &seq))
+		p->acked = seq;
+	return -1 == p->fd;
+}
+
+/**
+ *  @brief Logs one change, applies it to the table and streams it
+ */
+static void primary_log(sixone_repl repl, char op, const struct sixone_mapping *m)
+{
+	struct repl_rec *r;
+	u_int i;
+
+	r = &repl->log[++repl->seq % REPL_LOG_MAX];
+	r->seq = repl->seq;
+	r->ts_us = repl_now_us();
+	r->op = op;
+	r->m = *m;
+	if('+' == op)
+		maptab_add(repl->tab, m);
+	else
+		maptab_del(repl->tab, m);
+	for(i = 0; i < REPL_FOLLOWERS; i++)
+		if(repl->peer[i].hello)
+			peer_record(&repl->peer[i], r);
+}
+
+/**
+ *  @brief Sorted copy of n mappings without duplicates
+ *  @return The number left
+ */
+static u_int sorted(const struct sixone_mapping *m, u_int n, struct sixone_mapping *out)
+{
+	u_int i, j;
+
+	memcpy(out, m, n * sizeof(*m));
+	qsort(out, n, sizeof(*out), maptab_cmp);
+	for(i = j = 0; i < n; i++)
+		if(0 == j || 0 != maptab_cmp(&out[j - 1], &out[i]))
+			out[j++] = out[i];
+	return j;
+}
+
+/**
+ *  @brief Rereads the file if it changed and logs the difference, call with the lock held
+ *  @return 1 if the table changed
+ */
+static int primary_load(sixone_repl repl)
+{
+	struct stat st;
+	struct sixone_mapping *m, *a, *b;
+	u_int64_t seq = repl->seq;
+	u_int i, j, a_c, b_c;
+	int n, d;
+
+	if(0 != stat(repl->file, &st) || (st.st_mtime == repl->mtime && st.st_size == repl->size))
+		return 0;
+	if((n = load_mappings(repl->file, 0, NULL, &m)) < 0) {
+		fprintf(stderr, "Replication: cannot read %s\n", repl->file);
+		return 0;
+	}
+	a = malloc((repl->cur_c + 1) * sizeof(*a));
+	b = malloc((n + 1) * sizeof(*b));
+	if(NULL == a || NULL == b) {
+		free(a);
+		free(b);
+		free(m);
+		return 0;
+	}
+	a_c = sorted(repl->cur, repl->cur_c, a);
+	b_c = sorted(m, n, b);
+
+	// a merge of the two, anything only in the old file goes, anything only in the new comes
+	for(i = j = 0; i < a_c || j < b_c; ) {
+		d = i == a_c ? 1 : j == b_c ? -1 : maptab_cmp(&a[i], &b[j]);
+		if(d < 0)
+			primary_log(repl, '-', &a[i++]);
+		else if(d > 0)
+			primary_log(repl, '+', &b[j++]);
+		else {
+			if(a[i].weight != b[j].weight)
+				primary_log(repl, '+', &b[j]);
+			i++;
+			j++;
+		}
+	}
+	free(a);
+	free(b);
+	free(repl->cur);
+	repl->cur = m;
+	repl->cur_c = n;
+	repl->mtime = st.st_mtime;
+	repl->size = st.st_size;
+	return seq != repl->seq;
+}
+
+static void *primary_thread(void *arg)
+{
+	sixone_repl repl = arg;
+	struct pollfd pfd[REPL_FOLLOWERS + 1];
+	struct repl_peer *p;
+	u_int64_t now, tick = 0;
+	ssize_t r;
+	int i, fd, changed;
+
+	while(!repl->stop) {
+		pfd[0].fd = repl->lfd;
+		pfd[0].events = POLLIN;
+		for(i = 0; i < REPL_FOLLOWERS; i++) {
+			pfd[i + 1].fd = repl->peer[i].fd;
+			pfd[i + 1].events = POLLIN | (repl->peer[i].out_len ? POLLOUT : 0);
+			pfd[i + 1].revents = 0;
+		}
+		now = repl_now_us();
+		poll(pfd, REPL_FOLLOWERS + 1, tick > now ? (tick - now) / 1000 + 1 : 0);
+
+		pthread_mutex_lock(&repl->lock);
+		if(pfd[0].revents & POLLIN && -1 != (fd = accept(repl->lfd, NULL, NULL))) {
+			for(i = 0; i < REPL_FOLLOWERS && -1 != repl->peer[i].fd; i++)
+				;
+			if(REPL_FOLLOWERS == i)
+				close(fd);
+			else {
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+				repl->peer[i].fd = fd;
+			}
+		}
+		for(i = 0; i < REPL_FOLLOWERS; i++) {
+			p = &repl->peer[i];
+			if(-1 == p->fd || p->fd != pfd[i + 1].fd)
+				continue;
+			if(pfd[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+				r = read(p->fd, p->in + p->in_len, REPL_LINE_MAX - 1 - p->in_len);
+				if(0 == r || (r < 0 && EAGAIN != errno && EINTR != errno)) {
+					peer_close(p);
+					continue;
+				}
+				if(r > 0) {
+					p->in_len += r;
+					if(0 != repl_lines(p->in, &p->in_len, peer_line, repl, p))
+						continue;
+				}
+			}
+			if(p->out_len > 0 && (r = write(p->fd, p->out, p->out_len)) > 0) {
+				p->out_len -= r;
+				memmove(p->out, p->out + r, p->out_len);
+			}
+		}
+
+		changed = 0;
+		if((now = repl_now_us()) >= tick) {
+			tick = now + REPL_TICK_MS * 1000;
+			changed = primary_load(repl);
+			for(i = 0; i < REPL_FOLLOWERS; i++)
+				if(repl->peer[i].hello)
+					peer_heartbeat(repl, &repl->peer[i]);
+		}
+		pthread_mutex_unlock(&repl->lock);
+
+		if(changed && NULL != repl->on_change)
+			repl->on_change();
+	}
+	return NULL;
+}
+
+/*
+ * A follower
+ */
+
+static int follower_line(sixone_repl repl, void *arg, char *line)
+{
+	int *changed = arg;
+	struct sixone_mapping m;
+	unsigned long long epoch, seq, ts;
+	char op;
+	int n = 0;
+
+	switch(line[0]) {
+	case 'S':
+		if(2 != sscanf(line, "S %llu %llu", &epoch, &seq))
+			return -1;
+		free_sixone_maptab(repl->snap);
+		if(NULL == (repl->snap = alloc_sixone_maptab()))
+			return -1;
+		repl->snap_epoch = epoch;
+		repl->snap_seq = seq;
+		break;
+	case '+':
+		if(NULL == repl->snap || 0 != maptab_parse(line + 2, &m) || maptab_add(repl->snap, &m) < 0)
+			return -1;
+		break;
+	case 'E':
+		if(NULL == repl->snap)
+			return -1;
+		// the only time the table is replaced, until now it served the old one
+		pthread_mutex_lock(&repl->lock);
+		free_sixone_maptab(repl->tab);
+		repl->tab = repl->snap;
+		repl->snap = NULL;
+		repl->epoch = repl->snap_epoch;
+		repl->seq = repl->snap_seq;
+		repl->snapshots++;
+		pthread_mutex_unlock(&repl->lock);
+		*changed = 1;
+		break;
+	case 'R':
+		if(2 != sscanf(line, "R %llu %llu", &epoch, &seq) || epoch != repl->epoch || seq != repl->seq)
+			return -1;
+		break;
+	case 'L':
+		if(3 != sscanf(line, "L %llu %llu %c %n", &seq, &ts, &op, &n) || 0 == n
+		   || 0 != maptab_parse(line + n, &m))
+			return -1;
+		pthread_mutex_lock(&repl->lock);
+		if(seq != repl->seq + 1 || NULL != repl->snap) {
+			// missed something, start over from where we are
+			pthread_mutex_unlock(&repl->lock);
+			return -1;
+		}
+		if('+' == op)
+			maptab_add(repl->tab, &m);
+		else
+			maptab_del(repl->tab, &m);
+		repl->seq = seq;
+		repl->records++;
+		repl->lag_us = repl_now_us() > ts ? repl_now_us() - ts : 0;
+		if(repl->lag_us > repl->lag_max_us)
+			repl->lag_max_us = repl->lag_us;
+		if(repl->primary_seq < seq)
+			repl->primary_seq = seq;
+		pthread_mutex_unlock(&repl->lock);
+		*changed = 1;
+		break;
+	case 'H':
+		if(2 != sscanf(line, "H %llu %llu", &seq, &ts))
+			return -1;
+		pthread_mutex_lock(&repl->lock);
+		repl->primary_seq = seq;
+		if(NULL == repl->snap && repl->seq >= seq && !repl->synced) {
+			repl->synced = 1;
+			pthread_cond_broadcast(&repl->synced_cond);
+		}
+		pthread_mutex_unlock(&repl->lock);
+		break;
+	default:
+		return -1;
+	}
+	return 0;
+}
+
+static void *follower_thread(void *arg)
+{
+	sixone_repl repl = arg;
+	struct pollfd pfd;
+	char *buf, ack[64];
+	u_int len = 0;
+	u_int64_t acked = 0;
+	ssize_t r;
+	int changed, lost;
+
+	if(NULL == (buf = malloc(REPL_LINE_MAX)))
+		return NULL;
+
+	while(!repl->stop) {
+		if(-1 == repl->fd) {
+			if(-1 == (repl->fd = repl_open(repl->addr, 0))) {
+				usleep(REPL_TICK_MS * 1000);
+				continue;
+			}
+			snprintf(ack, sizeof(ack), "F %llu %llu\n", (unsigned long long)repl->epoch, (unsigned long long)repl->seq);
+			if((ssize_t)strlen(ack) != write(repl->fd, ack, strlen(ack))) {
+				close(repl->fd);
+				repl->fd = -1;
+				continue;
+			}
+			acked = repl->seq;
+			len = 0;
+		}
+
+		pfd.fd = repl->fd;
+		pfd.events = POLLIN;
+		if(poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		changed = 0;
+		lost = 0;
+		r = read(repl->fd, buf + len, REPL_LINE_MAX - 1 - len);
+		if(0 == r || (r < 0 && EINTR != errno))
+			lost = 1;
+		else if(r > 0) {
+			len += r;
+			lost = repl_lines(buf, &len, follower_line, repl, &changed);
+		}
+		if(changed && NULL != repl->on_change)
+			repl->on_change();
+
+		if(!lost && acked != repl->seq) {
+			snprintf(ack, sizeof(ack), "A %llu\n", (unsigned long long)repl->seq);
+			lost = (ssize_t)strlen(ack) != write(repl->fd, ack, strlen(ack));
+			acked = repl->seq;
+		}
+		if(lost) {
+			fprintf(stderr, "Replication: lost %s, reconnecting\n", repl->addr);
+			close(repl->fd);
+			repl->fd = -1;
+			free_sixone_maptab(repl->snap);
+			repl->snap = NULL;
+			repl->reconnects++;
+		}
+	}
+	free(buf);
+	return NULL;
+}
+
+sixone_repl alloc_sixone_repl(const char *role, const char *arg)
+{
+	sixone_repl repl;
+	char addr[256], file[256];
+	struct sixone_mapping *m;
+	struct stat st;
+	int n, i;
+
+	if(NULL == arg || 1 > (n = sscanf(arg, "%255s %255s", addr, file))) {
+		fprintf(stderr, "Replicate= needs an address\n");
+		return NULL;
+	}
+	if(NULL == (repl = calloc(1, sizeof(struct sixone_repl_))))
+		return NULL;
+	repl->addr = strdup(addr);
+	repl->tab = alloc_sixone_maptab();
+	repl->lfd = repl->fd = -1;
+	for(i = 0; i < REPL_FOLLOWERS; i++)
+		repl->peer[i].fd = -1;
+	pthread_mutex_init(&repl->lock, NULL);
+	pthread_cond_init(&repl->synced_cond, NULL);
+	if(NULL == repl->addr || NULL == repl->tab)
+		goto fail;
+
+	if(0 == strcmp(role, "primary")) {
+		repl->role = REPL_PRIMARY;
+		repl->file = strdup(n > 1 ? file : "mappings.txt");
+		repl->log = calloc(REPL_LOG_MAX, sizeof(struct repl_rec));
+		if(NULL == repl->file || NULL == repl->log)
+			goto fail;
+		if(0 != stat(repl->file, &st) || (n = load_mappings(repl->file, 0, NULL, &m)) < 0) {
+			fprintf(stderr, "Replication: cannot read %s\n", repl->file);
+			goto fail;
+		}
+		repl->cur = m;
+		repl->cur_c = n;
+		repl->mtime = st.st_mtime;
+		repl->size = st.st_size;
+		if(0 != maptab_build(repl->tab, m, n)) {
+			fprintf(stderr, "Replication: out of memory\n");
+			goto fail;
+		}
+		repl->epoch = repl_now_us();
+		repl->synced = 1;
+		if(-1 == (repl->lfd = repl_open(addr, 1))) {
+			fprintf(stderr, "Replication: cannot listen on %s: %s\n", addr, strerror(errno));
+			goto fail;
+		}
+		fcntl(repl->lfd, F_SETFL, fcntl(repl->lfd, F_GETFL) | O_NONBLOCK);
+		if(0 != pthread_create(&repl->thread, NULL, primary_thread, repl))
+			goto fail;
+	}
+	else if(0 == strcmp(role, "follower")) {
+		repl->role = REPL_FOLLOWER;
+		if(0 != pthread_create(&repl->thread, NULL, follower_thread, repl))
+			goto fail;
+	}
+	else {
+		fprintf(stderr, "Replicate= %s: expected primary or follower\n", role);
+		goto fail;
+	}
+	return repl;
+
+fail:
+	if(-1 != repl->lfd)
+		close(repl->lfd);
+	free(repl->cur);
+	free(repl->log);
+	free(repl->file);
+	free_sixone_maptab(repl->tab);
+	free(repl->addr);
+	pthread_cond_destroy(&repl->synced_cond);
+	pthread_mutex_destroy(&repl->lock);
+	free(repl);
+	return NULL;
+}
+
+void free_sixone_repl(sixone_repl repl)
+{
+	int i;
+
+	if(NULL == repl)
+		return;
+	repl->stop = 1;
+	pthread_join(repl->thread, NULL);
+	for(i = 0; i < REPL_FOLLOWERS; i++)
+		if(-1 != repl->peer[i].fd)
+			peer_close(&repl->peer[i]);
+	if(-1 != repl->lfd)
+		close(repl->lfd);
+	if(-1 != repl->fd)
+		close(repl->fd);
+	free(repl->cur);
+	free(repl->log);
+	free(repl->file);
+	free_sixone_maptab(repl->snap);
+	free_sixone_maptab(repl->tab);
+	free(repl->addr);
+	pthread_cond_destroy(&repl->synced_cond);
+	pthread_mutex_destroy(&repl->lock);
+	free(repl);
+}
+
+int repl_wait(sixone_repl repl, u_int timeout_ms)
+{
+	struct timespec until;
+	int ret;
+
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += timeout_ms / 1000;
+	until.tv_nsec += timeout_ms % 1000 * 1000000;
+	if(until.tv_nsec >= 1000000000) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&repl->lock);
+	while(!repl->synced && ETIMEDOUT != pthread_cond_timedwait(&repl->synced_cond, &repl->lock, &until))
+		;
+	ret = repl->synced ? 0 : -1;
+	pthread_mutex_unlock(&repl->lock);
+	return ret;
+}
+
+ip_list repl_resolv(sixone_ip ip, u_int only_sixone)
+{
+	ip_list ret;
+
+	pthread_mutex_lock(&global_repl->lock);
+	ret = maptab_resolve(global_repl->tab, &ip->ip);
+	pthread_mutex_unlock(&global_repl->lock);
+	return ret;
+}
+
+int repl_resolv_batch(u_int n, sixone_ip ip[], u_int only_sixone, ip_list out[])
+{
+	u_int i;
+
+	pthread_mutex_lock(&global_repl->lock);
+	for(i = 0; i < n; i++)
+		out[i] = maptab_resolve(global_repl->tab, &ip[i]->ip);
+	pthread_mutex_unlock(&global_repl->lock);
+	return 0;
+}
+
+void repl_report(sixone_repl repl)
+{
+	struct repl_peer *p;
+	u_int i, n = 0;
+
+	pthread_mutex_lock(&repl->lock);
+	if(REPL_PRIMARY == repl->role) {
+		for(i = 0; i < REPL_FOLLOWERS; i++)
+			n += repl->peer[i].hello;
+		printf("  replication: primary of %s on %s, epoch %llu, seq %llu, %u mappings, %u followers\n",
+		       repl->file, repl->addr, (unsigned long long)repl->epoch, (unsigned long long)repl->seq,
+		       repl->tab->count, n);
+		for(i = 0; i < REPL_FOLLOWERS; i++) {
+			p = &repl->peer[i];
+			if(p->hello)
+				printf("    follower %u: applied %llu, lag %llu records, %lu bytes queued\n", i,
+				       (unsigned long long)p->acked, (unsigned long long)(repl->seq - p->acked),
+				       (unsigned long)p->out_len);
+		}
+	}
+	else {
+		printf("  replication: follower of %s, epoch %llu, seq %llu of %llu, lag %llu records, %.1f ms (max %.1f ms)%s\n",
+		       repl->addr, (unsigned long long)repl->epoch, (unsigned long long)repl->seq,
+		       (unsigned long long)repl->primary_seq, (unsigned long long)(repl->primary_seq - repl->seq),
+		       repl->lag_us / 1000.0, repl->lag_max_us / 1000.0, repl->synced ? "" : ", never synced");
+		printf("    %u mappings, %u snapshots, %u records applied, %u reconnects\n",
+		       repl->tab->count, repl->snapshots, repl->records, repl->reconnects);
+	}
+	pthread_mutex_unlock(&repl->lock);
+}
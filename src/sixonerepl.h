@@ -0,0 +1,183 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+/** @file sixonerepl.h
+ *  @brief Six-One Router mapping table replication
+ *  @date 2026-10-19
+ *
+ *  One router (or sixonesync) is the primary for a mapping file, the
+ *  others follow it over TCP or a Unix socket:
+ *  @code
+ *  Replicate= primary <listen address> [mappings file, default mappings.txt]
+ *  Replicate= follower <primary address>
+ *  @endcode
+ *  An address containing a '/' is a Unix socket, anything else is
+ *  <host>:<port> ([<host>]:<port> for IPv6 literals).
+ *
+ *  The primary checks the file once a second and turns every change into
+ *  numbered add/remove records, the most recent REPL_LOG_MAX of which it
+ *  keeps. A follower says where it is (the primary's epoch and the last
+ *  record it applied) and gets the records it missed, or a snapshot
+ *  followed by the records after it when they are gone or the primary
+ *  restarted (new epoch). After that records are streamed as they happen
+ *  and applied one by one to the follower's sixone_maptab. Both ends
+ *  resolve out of their table.
+ *
+ *  The protocol is one line per message, <mapping> being a mappings.txt
+ *  line with the weight always given and times microseconds since the epoch:
+ *  @code
+ *  F <epoch> <seq>                  follower -> primary, hello
+ *  A <seq>                          follower -> primary, applied up to <seq>
+ *  S <epoch> <seq>                  primary -> follower, snapshot as of <seq> follows
+ *  + <mapping>                      primary -> follower, snapshot entry
+ *  E                                primary -> follower, end of snapshot
+ *  R <epoch> <seq>                  primary -> follower, resuming after <seq>
+ *  L <seq> <time> +|- <mapping>     primary -> follower, record
+ *  H <seq> <time>                   primary -> follower, heartbeat, once a second
+ *  @endcode
+ *  Lag is reported in records (the primary's last record less the last one
+ *  applied) and in time (from the primary logging a record to a follower
+ *  applying it, which assumes synchronized clocks across hosts).
+ */
+
+#ifndef SIXONEREPL_H
+#define SIXONEREPL_H
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "sixonemaptab.h"
+
+/// @brief Records the primary keeps for followers catching up
+#define REPL_LOG_MAX 4096
+/// @brief Followers a primary serves
+#define REPL_FOLLOWERS 32
+/// @brief Output a follower may have queued before it is disconnected
+#define REPL_OUT_MAX (16 << 20)
+/// @brief How often the primary checks the file and sends heartbeats (ms)
+#define REPL_TICK_MS 1000
+/// @brief How long a follower router waits for its first sync at startup (ms)
+#define REPL_SYNC_MS 5000
+
+#define REPL_PRIMARY 0
+#define REPL_FOLLOWER 1
+
+/**
+ * @brief A record of the delta log
+ */
+struct repl_rec {
+	u_int64_t seq;
+	u_int64_t ts_us;
+	char op;                    /// '+' or '-'
+	struct sixone_mapping m;
+};
+
+/**
+ * @brief The primary's view of a follower
+ */
+struct repl_peer {
+	int fd;                     /// -1 = free
+	char *out;                  /// queued output
+	size_t out_len, out_size;
+	char in[256];
+	u_int in_len;
+	int hello;                  /// got its F line
+	u_int64_t acked;            /// last record it applied
+};
+
+typedef struct sixone_repl_ *sixone_repl;
+struct sixone_repl_ {
+	int role;                   /// REPL_PRIMARY or REPL_FOLLOWER
+	char *addr;
+	sixone_maptab tab;          /// what is resolved from
+	pthread_mutex_t lock;       /// tab and everything below
+	pthread_cond_t synced_cond;
+	pthread_t thread;
+	volatile int stop;
+	void (*on_change)();        /// called (without the lock) after the table changed
+	u_int64_t epoch;
+	u_int64_t seq;              /// last record, logged (primary) or applied (follower)
+
+	// primary
+	char *file;
+	time_t mtime;               /// mtime and size of the file when it was read
+	off_t size;
+	struct sixone_mapping *cur; /// the file as of seq, in file order
+	u_int cur_c;
+	struct repl_rec *log;       /// ring of REPL_LOG_MAX records
+	int lfd;
+	struct repl_peer peer[REPL_FOLLOWERS];
+
+	// follower
+	int fd;
+	int synced;                 /// has caught up at least once
+	sixone_maptab snap;         /// snapshot being received, NULL if none
+	u_int64_t snap_epoch, snap_seq;
+	u_int64_t primary_seq;      /// last record the primary has logged, as far as we know
+	u_int64_t lag_us;           /// time lag of the last record applied
+	u_int64_t lag_max_us;
+	u_int snapshots, records, reconnects;
+};
+
+/**
+ *  @brief The replicated table the router resolves from, NULL if none
+ */
+extern sixone_repl global_repl;
+
+/**
+ *  @brief Starts replication
+ *  @param role "primary" or "follower"
+ *  @param arg The rest of the Replicate= line
+ *  @return NULL (after saying why) on errors
+ */
+sixone_repl alloc_sixone_repl(const char *role, const char *arg);
+void free_sixone_repl(sixone_repl repl);
+
+/**
+ *  @brief Waits until a follower has caught up with its primary
+ *  @return 0 if it has, -1 after timeout_ms
+ */
+int repl_wait(sixone_repl repl, u_int timeout_ms);
+
+/**
+ *  @brief sixone_resolv out of global_repl
+ */
+ip_list repl_resolv(sixone_ip ip, u_int only_sixone);
+
+/**
+ *  @brief sixone_resolv_batch out of global_repl
+ */
+int repl_resolv_batch(u_int n, sixone_ip ip[], u_int only_sixone, ip_list out[]);
+
+/**
+ *  @brief Prints where replication is and the lag
+ */
+void repl_report(sixone_repl repl);
+
+#endif // SIXONEREPL_H
@@ -0,0 +1,311 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixoneresolvd.c
+ *  @brief Six-One Router resolver daemon, serves a resolver plugin on a Unix socket
+ *  @date 2026-10-19
+ *
+ *  Usage: sixoneresolvd [-s socket] [-p plugin.so] [-a plugin argument] [-d delay ms]
+ *
+ *  Answers the queries of routers configured with Resolver= (see
+ *  sixoneasync.h for the protocol) from a resolver plugin, sixonemap.so
+ *  and mappings.txt by default. The queries that arrive together are
+ *  resolved in one batch. -d holds every answer back, to stand in for a
+ *  remote mapping service.
+ */
+
+#include <errno.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include "sixoneplugin.h"
+
+/// @brief Routers served at once
+#define RESOLVD_CLIENTS 64
+/// @brief Longest query line
+#define RESOLVD_LINE_MAX 256
+/// @brief Most queries resolved in one batch
+#define RESOLVD_BATCH 256
+
+/**
+ * @brief A connected router
+ */
+struct resolvd_client {
+	int fd;                      /// -1 = free
+	u_int gen;                   /// bumped on every reuse, delayed answers for an older one are dropped
+	char buf[RESOLVD_LINE_MAX];
+	u_int len;
+};
+
+/**
+ * @brief An answer held back by -d
+ */
+struct resolvd_reply {
+	struct resolvd_reply *next;
+	u_int64_t due_ms;
+	u_int client;
+	u_int gen;
+	char line[];
+};
+
+static struct resolvd_client clients[RESOLVD_CLIENTS];
+static struct resolvd_reply *delayed, **delayed_tail = &delayed;
+static const struct sixone_plugin_ *plugin;
+static u_int delay_ms;
+
+static u_int64_t now_ms()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static void usage(char *name)
+{
+	printf("Usage: %s [options]\n", name);
+	printf("  -s socket        socket to listen on (/var/run/sixoneresolvd.sock)\n");
+	printf("  -p plugin        resolver plugin (./sixonemap.so)\n");
+	printf("  -a argument      plugin argument (mappings.txt)\n");
+	printf("  -d ms            delay every answer (0)\n");
+	exit(2);
+}
+
+static void load(const char *path, const char *arg)
+{
+	void *handle;
+
+	if(NULL == (handle = dlopen(path, RTLD_NOW | RTLD_LOCAL))) {
+		printf("%s\n", dlerror());
+		exit(1);
+	}
+	plugin = dlsym(handle, SIXONE_PLUGIN_SYMBOL);
+	if(NULL == plugin || SIXONE_PLUGIN_ABI != plugin->abi || NULL == plugin->resolve) {
+		printf("%s is not a resolver plugin (ABI %u)\n", path, SIXONE_PLUGIN_ABI);
+		exit(1);
+	}
+	if(NULL != plugin->init && 0 != plugin->init(arg)) {
+		printf("%s: init failed\n", path);
+		exit(1);
+	}
+}
+
+static void drop_client(u_int c)
+{
+	close(clients[c].fd);
+	clients[c].fd = -1;
+	clients[c].len = 0;
+}
+
+/**
+ *  @brief Sends (or holds back) one answer line
+ */
+static void answer(u_int c, char *line)
+{
+	struct resolvd_reply *r;
+	size_t len = strlen(line);
+
+	if(0 == delay_ms) {
+		if((ssize_t)len != write(clients[c].fd, line, len))
+			drop_client(c);
+		return;
+	}
+	if(NULL == (r = malloc(sizeof(*r) + len + 1)))
+		return;
+	r->next = NULL;
+	r->due_ms = now_ms() + delay_ms;
+	r->client = c;
+	r->gen = clients[c].gen;
+	strcpy(r->line, line);
+	*delayed_tail = r;
+	delayed_tail = &r->next;
+}
+
+/**
+ *  @brief Sends the held back answers that are due, the delay is fixed so they are in order
+ */
+static void send_delayed()
+{
+	struct resolvd_reply *r;
+	u_int64_t now = now_ms();
+
+	while(NULL != (r = delayed) && r->due_ms <= now) {
+		if(NULL == (delayed = r->next))
+			delayed_tail = &delayed;
+		if(-1 != clients[r->client].fd && clients[r->client].gen == r->gen
+		   && (ssize_t)strlen(r->line) != write(clients[r->client].fd, r->line, strlen(r->line)))
+			drop_client(r->client);
+		free(r);
+	}
+}
+
+/**
+ *  @brief Resolves a batch of queries and answers them
+ */
+static void resolve(u_int n, struct sixone_ip_ addr[], u_int client[])
+{
+	sixone_ip ptr[RESOLVD_BATCH];
+	ip_list out[RESOLVD_BATCH], l, next;
+	char line[8192], str[INET6_ADDRSTRLEN];
+	size_t len;
+	u_int i;
+
+	for(i = 0; i < n; i++)
+		ptr[i] = &addr[i];
+	if(0 != plugin->resolve(n, ptr, 0, out))
+		memset(out, 0, sizeof(out));
+
+	for(i = 0; i < n; i++) {
+		inet_ntop(AF_INET6, &addr[i].ip, str, sizeof(str));
+		len = snprintf(line, sizeof(line), "A %s %d", str, NULL != out[i] ? out[i]->ip->pfx : 128);
+		for(l = out[i]; l != NULL; l = next) {
+			next = l->next;
+			inet_ntop(AF_INET6, &l->ip->ip, str, sizeof(str));
+			if(len < sizeof(line))
+				len += snprintf(line + len, sizeof(line) - len, " %s/%d:%u", str, l->ip->pfx,
+						l->weight ? l->weight : 1);
+			free(l->ip);
+			free(l);
+		}
+		if(len + 1 < sizeof(line)) {
+			strcat(line, "\n");
+			answer(client[i], line);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char *sock_path = "/var/run/sixoneresolvd.sock", *plugin_path = "./sixonemap.so", *plugin_arg = "mappings.txt";
+	struct sockaddr_un sun;
+	struct pollfd pfd[RESOLVD_CLIENTS + 1];
+	struct sixone_ip_ addr[RESOLVD_BATCH];
+	u_int client[RESOLVD_BATCH];
+	char *line, *nl;
+	u_int c, n, timeout;
+	ssize_t r;
+	int lfd, fd, ch;
+
+	while(-1 != (ch = getopt(argc, argv, "s:p:a:d:h"))) {
+		switch(ch) {
+		case 's': sock_path = optarg; break;
+		case 'p': plugin_path = optarg; break;
+		case 'a': plugin_arg = optarg; break;
+		case 'd': delay_ms = atoi(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if(optind != argc)
+		usage(argv[0]);
+
+	load(plugin_path, plugin_arg);
+	signal(SIGPIPE, SIG_IGN);
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	if(strlen(sock_path) >= sizeof(sun.sun_path))
+		usage(argv[0]);
+	strcpy(sun.sun_path, sock_path);
+	unlink(sock_path);
+	if(-1 == (lfd = socket(AF_UNIX, SOCK_STREAM, 0))
+	   || 0 != bind(lfd, (struct sockaddr *)&sun, sizeof(sun)) || 0 != listen(lfd, 16)) {
+		printf("Cannot listen on %s: %s\n", sock_path, strerror(errno));
+		return 1;
+	}
+	printf("Serving %s (%s %s) on %s\n", plugin->name, plugin_path, plugin_arg, sock_path);
+	fflush(stdout);
+
+	for(c = 0; c < RESOLVD_CLIENTS; c++)
+		clients[c].fd = -1;
+
+	for(;;) {
+		pfd[0].fd = lfd;
+		pfd[0].events = POLLIN;
+		for(c = 0; c < RESOLVD_CLIENTS; c++) {
+			pfd[c + 1].fd = clients[c].fd;
+			pfd[c + 1].events = POLLIN;
+			pfd[c + 1].revents = 0;
+		}
+		timeout = NULL == delayed ? 1000 : (delayed->due_ms > now_ms() ? delayed->due_ms - now_ms() : 0);
+		if(poll(pfd, RESOLVD_CLIENTS + 1, timeout) < 0 && EINTR != errno)
+			return 1;
+
+		if(pfd[0].revents & POLLIN && -1 != (fd = accept(lfd, NULL, NULL))) {
+			for(c = 0; c < RESOLVD_CLIENTS && -1 != clients[c].fd; c++)
+				;
+			if(c == RESOLVD_CLIENTS)
+				close(fd);
+			else {
+				clients[c].fd = fd;
+				clients[c].gen++;
+			}
+		}
+
+		// everything that came in this round is one batch
+		n = 0;
+		for(c = 0; c < RESOLVD_CLIENTS; c++) {
+			if(-1 == pfd[c + 1].fd || !(pfd[c + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+			r = read(clients[c].fd, clients[c].buf + clients[c].len, RESOLVD_LINE_MAX - 1 - clients[c].len);
+			if(r <= 0) {
+				drop_client(c);
+				continue;
+			}
+			clients[c].len += r;
+			clients[c].buf[clients[c].len] = 0;
+			for(line = clients[c].buf; NULL != (nl = strchr(line, '\n')); line = nl + 1) {
+				*nl = 0;
+				if('Q' != line[0] || 1 != inet_pton(AF_INET6, line + 1 + strspn(line + 1, " "), &addr[n].ip))
+					continue;
+				addr[n].pfx = 128;
+				client[n++] = c;
+				if(RESOLVD_BATCH == n) {
+					resolve(n, addr, client);
+					n = 0;
+				}
+			}
+			clients[c].len -= line - clients[c].buf;
+			memmove(clients[c].buf, line, clients[c].len);
+			if(RESOLVD_LINE_MAX - 1 == clients[c].len)
+				clients[c].len = 0;
+		}
+		if(n > 0)
+			resolve(n, addr, client);
+		send_delayed();
+	}
+	return 0;
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonerewrite.c
+ *  @brief Six-One Router prefix rewrite kernels, one per prefix length
+ *  @date 2026-10-19
+ *
+ *  REWRITE_LENGTHS() expands a macro for every prefix length as a two digit
+ *  hex number, so that the kernels can be named and tabled by the preprocessor.
+ */
+
+#include "sixonerewrite.h"
+
+#include <sys/types.h>
+#include <string.h>
+
+/// @brief Expands X(h, l) for the prefix lengths 0x<h>0 - 0x<h>f
+#define REWRITE_ROW(X, h) \
+	X(h, 0) X(h, 1) X(h, 2) X(h, 3) X(h, 4) X(h, 5) X(h, 6) X(h, 7) \
+	X(h, 8) X(h, 9) X(h, a) X(h, b) X(h, c) X(h, d) X(h, e) X(h, f)
+
+/// @brief Expands X(h, l) for every prefix length, 0x00 - 0x80
+#define REWRITE_LENGTHS(X) \
+	REWRITE_ROW(X, 0) REWRITE_ROW(X, 1) REWRITE_ROW(X, 2) REWRITE_ROW(X, 3) \
+	REWRITE_ROW(X, 4) REWRITE_ROW(X, 5) REWRITE_ROW(X, 6) REWRITE_ROW(X, 7) X(8, 0)
+
+/**
+ *  @brief Defines rewrite_<h><l>(), the kernel for a prefix of 0x<h><l> bits.
+ *  Whole bytes are copied, a partial byte is merged under a constant mask.
+ */
+#define REWRITE_KERNEL(h, l) \
+static void rewrite_##h##l(struct in6_addr *addr, const struct in6_addr *prefix) \
+{ \
+	const u_int len = 0x##h##l; \
+	const u_char mask = (0xff << (8 - len % 8)) & 0xff; \
+	memcpy(addr->s6_addr, prefix->s6_addr, len / 8); \
+	if(0 != len % 8) \
+		addr->s6_addr[len / 8 % 16] = (addr->s6_addr[len / 8 % 16] & ~mask) | (prefix->s6_addr[len / 8 % 16] & mask); \
+}
+
+/// @brief Table entry of REWRITE_KERNEL(h, l)
+#define REWRITE_ENTRY(h, l) rewrite_##h##l,
+
+REWRITE_LENGTHS(REWRITE_KERNEL)
+
+/// @brief The kernels indexed by prefix length
+static const rewrite_fn rewrite_kernels[] = { REWRITE_LENGTHS(REWRITE_ENTRY) };
+
+rewrite_fn rewrite_kernel(u_int len)
+{
+	return rewrite_kernels[len > 128 ? 128 : len];
+}
+
+void rewrite_bind(sixone_rewrite rw, const struct in6_addr *prefix, u_int len)
+{
+	rw->prefix = *prefix;
+	rw->len = len > 128 ? 128 : len;
+	rw->splice = rewrite_kernels[rw->len];
+}
+
+void rewrite_generic(struct in6_addr *addr, const struct in6_addr *prefix, u_int len)
+{
+	struct in6_addr head = *prefix;
+	u_int bytes = len / 8, bits = len % 8;
+
+	if(len > 128)
+		bytes = 16, bits = 0;
+
+	// clear the host part of the prefix and the network part of the address
+	if(0 == bits) {
+		memset(&head.s6_addr[bytes], 0, 16 - bytes);
+		memset(addr->s6_addr, 0, bytes);
+	}
+	else {
+		memset(&head.s6_addr[bytes + 1], 0, 16 - bytes - 1);
+		head.s6_addr[bytes] &= 0xff << (8 - bits);
+		memset(addr->s6_addr, 0, bytes);
+		addr->s6_addr[bytes] &= 0xff >> bits;
+	}
+	for(bytes = 0; bytes < 16; bytes++)
+		addr->s6_addr[bytes] |= head.s6_addr[bytes];
+}
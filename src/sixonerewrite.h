@@ -0,0 +1,80 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonerewrite.h
+ *  @brief Six-One Router prefix rewrite kernels, one per prefix length
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONEREWRITE_H
+#define SIXONEREWRITE_H
+
+#include <sys/types.h>
+#include <netinet/in.h>
+
+/**
+ *  @brief Splices the first bits of prefix into addr, the rest of addr is kept.
+ *
+ *  There is one kernel per prefix length (0 - 128), each is straight line code
+ *  with the length folded in at compile time.
+ *  @param addr The address to rewrite (no alignment requirements)
+ *  @param prefix The prefix, bits past the prefix length are ignored
+ */
+typedef void (*rewrite_fn)(struct in6_addr *addr, const struct in6_addr *prefix);
+
+/**
+ * @brief A prefix bound to the kernel of its length, see rewrite_bind()
+ */
+typedef struct sixone_rewrite_ {
+	struct in6_addr prefix;
+	u_int len;
+	rewrite_fn splice;
+} *sixone_rewrite;
+
+/**
+ *  @brief The kernel for a prefix length
+ *  @param len Prefix length, lengths over 128 get the /128 kernel
+ */
+rewrite_fn rewrite_kernel(u_int len);
+
+/**
+ *  @brief Binds prefix/len to its kernel, once per rewrite target
+ */
+void rewrite_bind(sixone_rewrite rw, const struct in6_addr *prefix, u_int len);
+
+/**
+ *  @brief Rewrites addr with a bound prefix
+ */
+#define rewrite_apply(rw, addr) ((rw)->splice((addr), &(rw)->prefix))
+
+/**
+ *  @brief Splices with the bit offset worked out at run time, as write_prefix() used to.
+ *  Kept for verification and benchmarks.
+ */
+void rewrite_generic(struct in6_addr *addr, const struct in6_addr *prefix, u_int len);
+
+#endif
@@ -0,0 +1,266 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonerss.c
+ *  @brief Six-One Router symmetric flow dispatch to worker threads
+ *  @date 2026-10-19
+ */
+
+#include "sixonerss.h"
+#include "sixonetimer.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/icmp6.h>
+
+sixone_rss global_rss;
+
+u_int32_t rss_hash(sixone_pkt pkt)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	const u_char *l4 = PKT_L4(pkt);
+	u_int64_t a, b, t;
+	u_int32_t w[2], h = pkt->proto;
+	u_int16_t p[2], pa = 0, pb = 0, pt;
+
+	// interface identifiers, the rewrite only touches the prefixes
+	memcpy(&a, &ip->ip6_src.s6_addr[8], sizeof(a));
+	memcpy(&b, &ip->ip6_dst.s6_addr[8], sizeof(b));
+
+	if(0 != pkt->l4_off && !(pkt->flags & SIXONE_PKT_FRAG)) {
+		switch(pkt->proto) {
+		case IPPROTO_TCP:
+		case IPPROTO_UDP:
+			memcpy(p, l4, sizeof(p));
+			pa = p[0];
+			pb = p[1];
+			break;
+		case IPPROTO_ICMPV6:
+			if((ICMP6_ECHO_REQUEST == pkt->icmp_type || ICMP6_ECHO_REPLY == pkt->icmp_type)
+			   && PKT_L4_LEN(pkt) >= sizeof(struct icmp6_hdr)) {
+				memcpy(&pa, l4 + 4, sizeof(pa));
+				pb = pa;
+			}
+			break;
+		}
+	}
+
+	// the lower endpoint first, whichever way the packet goes
+	if(a > b || (a == b && pa > pb)) {
+		t = a;
+		a = b;
+		b = t;
+		pt = pa;
+		pa = pb;
+		pb = pt;
+	}
+	memcpy(w, &a, sizeof(w));
+	h = pkt_hash_mix(pkt_hash_mix(h, w[0]), w[1]);
+	memcpy(w, &b, sizeof(w));
+	h = pkt_hash_mix(pkt_hash_mix(h, w[0]), w[1]);
+	return pkt_hash_mix(h, pa | (u_int32_t)pb << 16);
+}
+
+/**
+ *  @brief Worker thread, runs its queue through the router a batch at a time
+ */
+static void *rss_run(void *arg)
+{
+	rss_worker w = arg;
+	struct rss_slot *sl;
+	struct timespec until;
+	u_int first, n, i;
+
+	pthread_mutex_lock(&w->lock);
+	for(;;) {
+		while(0 == w->depth && !w->rss->stop) {
+			// idle, the timers still run once a second
+			clock_gettime(CLOCK_REALTIME, &until);
+			until.tv_sec += 1;
+			if(ETIMEDOUT == pthread_cond_timedwait(&w->ready, &w->lock, &until)) {
+				pthread_mutex_unlock(&w->lock);
+				timers_burst();
+				pthread_mutex_lock(&w->lock);
+			}
+		}
+		if(w->rss->stop)
+			break;
+		// the queued slots are the batch, the capture can fill the rest of the ring meanwhile
+		first = w->head;
+		n = w->depth;
+		w->head = (first + n) % (2 * RSS_DEPTH);
+		w->depth = 0;
+		w->busy = n;
+		pthread_cond_broadcast(&w->room);
+		pthread_mutex_unlock(&w->lock);
+
+		timers_burst();
+		for(i = 0; i < n; i++) {
+			sl = &w->ring[(first + i) % (2 * RSS_DEPTH)];
+			sl->fn(sl->args, &sl->hdr, sl->data);
+		}
+
+		pthread_mutex_lock(&w->lock);
+		w->busy = 0;
+		w->packets += n;
+		pthread_cond_broadcast(&w->room);
+	}
+	pthread_mutex_unlock(&w->lock);
+	return NULL;
+}
+
+sixone_rss alloc_sixone_rss(u_int workers, int wait)
+{
+	sixone_rss rss;
+	u_int i;
+
+	if(0 == workers || workers > RSS_MAX_WORKERS) {
+		fprintf(stderr, "--workers takes 1 - %u workers\n", RSS_MAX_WORKERS);
+		return NULL;
+	}
+	rss = (sixone_rss) calloc(1, sizeof(struct sixone_rss_));
+	if(NULL == rss || NULL == (rss->worker_v = calloc(workers, sizeof(struct rss_worker_)))) {
+		fprintf(stderr, "Could not malloc()\n");
+		free(rss);
+		return NULL;
+	}
+	rss->wait = wait;
+
+	for(i = 0; i < workers; i++) {
+		rss->worker_v[i].rss = rss;
+		pthread_mutex_init(&rss->worker_v[i].lock, NULL);
+		pthread_cond_init(&rss->worker_v[i].ready, NULL);
+		pthread_cond_init(&rss->worker_v[i].room, NULL);
+		if(0 != pthread_create(&rss->worker_v[i].thread, NULL, rss_run, &rss->worker_v[i])) {
+			fprintf(stderr, "Could not start worker %u\n", i);
+			free_sixone_rss(rss);
+			return NULL;
+		}
+		// only started workers are joined and freed
+		rss->worker_c++;
+	}
+	return rss;
+}
+
+void free_sixone_rss(sixone_rss rss)
+{
+	u_int i, j;
+
+	if(NULL == rss)
+		return;
+	for(i = 0; i < rss->worker_c; i++) {
+		pthread_mutex_lock(&rss->worker_v[i].lock);
+		rss->stop = 1;
+		pthread_cond_signal(&rss->worker_v[i].ready);
+		pthread_mutex_unlock(&rss->worker_v[i].lock);
+	}
+	for(i = 0; i < rss->worker_c; i++) {
+		pthread_join(rss->worker_v[i].thread, NULL);
+		for(j = 0; j < 2 * RSS_DEPTH; j++)
+			free(rss->worker_v[i].ring[j].data);
+		pthread_cond_destroy(&rss->worker_v[i].room);
+		pthread_cond_destroy(&rss->worker_v[i].ready);
+		pthread_mutex_destroy(&rss->worker_v[i].lock);
+	}
+	free(rss->worker_v);
+	free(rss);
+}
+
+int rss_dispatch(sixone_rss rss, rss_handler fn, u_char *args, const struct pcap_pkthdr *header, const u_char *packet)
+{
+	struct sixone_pkt_ pkt;
+	struct rss_slot *sl;
+	rss_worker w;
+	u_char *data;
+	u_int size;
+
+	// malformed packets are counted by whoever processes them, any worker will do
+	if(0 != parse_packet(&pkt, packet, header->caplen))
+		w = &rss->worker_v[0];
+	else
+		w = &rss->worker_v[(u_int64_t)rss_hash(&pkt) * rss->worker_c >> 32];
+
+	pthread_mutex_lock(&w->lock);
+	while(w->depth >= RSS_DEPTH) {
+		if(!rss->wait) {
+			w->dropped++;
+			pthread_mutex_unlock(&w->lock);
+			return -1;
+		}
+		pthread_cond_wait(&w->room, &w->lock);
+	}
+	sl = &w->ring[(w->head + w->depth) % (2 * RSS_DEPTH)];
+	// a slot keeps its buffer, it only grows for a larger packet
+	if(sl->size < header->caplen) {
+		size = header->caplen > RSS_SLOT_SIZE ? header->caplen : RSS_SLOT_SIZE;
+		if(NULL == (data = realloc(sl->data, size))) {
+			w->dropped++;
+			pthread_mutex_unlock(&w->lock);
+			return -1;
+		}
+		sl->data = data;
+		sl->size = size;
+	}
+	sl->fn = fn;
+	sl->args = args;
+	sl->hdr = *header;
+	memcpy(sl->data, packet, header->caplen);
+	w->depth++;
+	pthread_cond_signal(&w->ready);
+	pthread_mutex_unlock(&w->lock);
+	return 0;
+}
+
+void rss_drain(sixone_rss rss)
+{
+	u_int i;
+
+	for(i = 0; i < rss->worker_c; i++) {
+		pthread_mutex_lock(&rss->worker_v[i].lock);
+		while(0 != rss->worker_v[i].depth || 0 != rss->worker_v[i].busy)
+			pthread_cond_wait(&rss->worker_v[i].room, &rss->worker_v[i].lock);
+		pthread_mutex_unlock(&rss->worker_v[i].lock);
+	}
+}
+void rss_report(sixone_rss rss)
+{
+	u_int i, dropped = 0;
+
+	printf("  workers:");
+	for(i = 0; i < rss->worker_c; i++) {
+		pthread_mutex_lock(&rss->worker_v[i].lock);
+		printf(" %u", rss->worker_v[i].packets);
+		dropped += rss->worker_v[i].dropped;
+		pthread_mutex_unlock(&rss->worker_v[i].lock);
+	}
+	printf(" pkts, %u dropped (queue full)\n", dropped);
+}
@@ -0,0 +1,155 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonerss.h
+ *  @brief Six-One Router symmetric flow dispatch to worker threads
+ *  @date 2026-10-19
+ *
+ *  With --workers <n> the capture threads (or the replay loop) only hash
+ *  each packet and copy it into the queue of one of n workers, which run
+ *  it through the router. The hash is taken over what the rewrite leaves
+ *  alone, so both directions of a conversation, before and after the
+ *  rewrite, reach the same worker: the protocol and the two endpoints,
+ *  each the interface identifier (low 64 bits) of its address and its
+ *  port (the echo identifier for ICMPv6, no port for fragments, which do
+ *  not all carry one). The endpoints go in in a fixed order, lower one
+ *  first, so the hash does not depend on which way the packet goes or
+ *  on how it is classified. That covers inbound and outbound packets as
+ *  well as hairpinned ones, whose prefixes hairpin() swaps.
+ *
+ *  The flow label is not used, set_bilateral_bit() takes one of its bits.
+ *  Prefixes longer than /64 would rewrite part of the identifiers, six/one
+ *  prefixes are /64 or shorter.
+ *
+ *  Each queue is a ring of slots whose buffers are allocated once (grown
+ *  when a larger packet comes) and reused, queueing a packet is one copy
+ *  under the lock of its worker. A worker takes all queued slots as one
+ *  batch and runs them without the lock, the ring has room for another
+ *  RSS_DEPTH packets meanwhile.
+ */
+
+#ifndef SIXONERSS_H
+#define SIXONERSS_H
+
+#include <pthread.h>
+#include <pcap.h>
+
+#include "sixonetypes.h"
+#include "sixonepkt.h"
+
+/// @brief Most workers --workers takes
+#define RSS_MAX_WORKERS 64
+/// @brief Packets queued per worker, a live capture drops what does not fit
+#define RSS_DEPTH 1024
+/// @brief Buffer a queue slot starts with, a larger packet grows it
+#define RSS_SLOT_SIZE 2048
+
+/**
+ *  @brief What a worker runs a queued packet through (got_packet() or release_packet())
+ */
+typedef void (*rss_handler)(u_char *args, const struct pcap_pkthdr *header, const u_char *packet);
+
+/**
+ * @brief A slot of a queue, a copy of what the capture gave
+ */
+struct rss_slot {
+	rss_handler fn;
+	u_char *args;
+	struct pcap_pkthdr hdr;
+	u_int size;             /// of data, kept for the next packet in the slot
+	u_char *data;
+};
+
+/**
+ * @brief A worker thread and its queue
+ */
+typedef struct rss_worker_ {
+	struct rss_slot ring[2 * RSS_DEPTH]; /// the batch being run and up to RSS_DEPTH queued after it
+	u_int head;             /// first queued slot
+	u_int depth;            /// queued slots
+	u_int busy;             /// slots of the batch being run, before head
+	u_int packets;          /// packets processed
+	u_int dropped;          /// packets dropped for a full queue
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;   /// the queue got a packet (or stop was set)
+	pthread_cond_t room;    /// the queue shrank
+	struct sixone_rss_ *rss;
+} *rss_worker;
+
+/**
+ * @brief The dispatcher
+ */
+typedef struct sixone_rss_ {
+	u_int worker_c;
+	struct rss_worker_ *worker_v;
+	int wait;               /// 1: a full queue makes the dispatcher wait (replay), 0: drop (live)
+	int stop;
+} *sixone_rss;
+
+/// @brief The dispatcher, NULL without --workers
+extern sixone_rss global_rss;
+
+/**
+ *  @brief Symmetric flow hash, the same for both directions of a flow before and after the rewrite
+ *  @param pkt The parsed packet
+ *  @return The hash
+ */
+u_int32_t rss_hash(sixone_pkt pkt);
+
+/**
+ *  @brief Starts the workers
+ *  @param workers Number of worker threads, 1 - RSS_MAX_WORKERS
+ *  @param wait 1 to wait for room in full queues, 0 to drop
+ *  @return The dispatcher, NULL (with a message on stderr) on failure
+ */
+sixone_rss alloc_sixone_rss(u_int workers, int wait);
+
+/**
+ *  @brief Stops the workers (dropping what is queued) and frees everything
+ */
+void free_sixone_rss(sixone_rss rss);
+
+/**
+ *  @brief Copies the packet into the queue of the worker of its flow
+ *  @param fn What the worker runs it through
+ *  @param args, header, packet As given to got_packet()
+ *  @return 0 if queued, -1 if dropped
+ */
+int rss_dispatch(sixone_rss rss, rss_handler fn, u_char *args, const struct pcap_pkthdr *header, const u_char *packet);
+
+/**
+ *  @brief Waits until every queue is empty and every worker idle
+ */
+void rss_drain(sixone_rss rss);
+
+/**
+ *  @brief Prints the packets per worker
+ */
+void rss_report(sixone_rss rss);
+
+#endif // SIXONERSS_H
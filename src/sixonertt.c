@@ -0,0 +1,425 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonertt.c
+ *  @brief Six-One Router passive RTT measurement and latency aware transit selection
+ *  @date 2026-10-19
+ */
+
+#include "sixonertt.h"
+#include "sixonepolicy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/icmp6.h>
+#include <netinet/tcp.h>
+
+sixone_rtt global_rtt;
+
+/// @brief Probe slots checked for timeouts per outbound probe, on top of the one reused
+#define RTT_SWEEP 8
+
+/**
+ *  @brief splitmix64 finalizer
+ */
+static u_int64_t rtt_mix(u_int64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ *  @brief Interface identifier (low 64 bits) of addr
+ */
+static u_int64_t rtt_iid(struct in6_addr *addr)
+{
+	u_int64_t iid;
+
+	memcpy(&iid, &addr->s6_addr[8], sizeof(iid));
+	return iid;
+}
+
+/**
+ *  @brief The key a probe and its answer have in common.
+ *
+ *  The prefixes are rewritten on the way, so a probe is identified by the
+ *  interface identifiers, the ports (echo id) and the sequence number the
+ *  answer acknowledges (echo sequence number).
+ *  @param out Whether pkt is an outbound packet (after rewriting) or an inbound one (before)
+ *  @return The key, 0 if pkt is neither a probe nor an answer
+ */
+static u_int64_t probe_key(sixone_pkt pkt, int out)
+{
+	struct ip6_hdr *ip = PKT_IP6(pkt);
+	struct tcphdr *th;
+	struct icmp6_hdr *icmp;
+	u_int64_t h, local, remote;
+	u_int32_t seq;
+	u_int16_t lport, rport;
+	u_int8_t flags;
+
+	if(0 == pkt->l4_off)
+		return 0;
+
+	if(IPPROTO_TCP == pkt->proto && PKT_L4_LEN(pkt) >= sizeof(struct tcphdr)) {
+		th = (struct tcphdr *)PKT_L4(pkt);
+		flags = th->th_flags & (TH_SYN | TH_ACK);
+		if(out && TH_SYN == flags) {
+			lport = th->th_sport;
+			rport = th->th_dport;
+			seq = ntohl(th->th_seq) + 1;
+		}
+		else if(!out && (TH_SYN | TH_ACK) == flags) {
+			lport = th->th_dport;
+			rport = th->th_sport;
+			seq = ntohl(th->th_ack);
+		}
+		else
+			return 0;
+	}
+	else if(IPPROTO_ICMPV6 == pkt->proto && PKT_L4_LEN(pkt) >= sizeof(struct icmp6_hdr)) {
+		icmp = (struct icmp6_hdr *)PKT_L4(pkt);
+		if(icmp->icmp6_type != (out ? ICMP6_ECHO_REQUEST : ICMP6_ECHO_REPLY))
+			return 0;
+		lport = icmp->icmp6_id;
+		rport = 0;
+		seq = icmp->icmp6_seq;
+	}
+	else
+		return 0;
+
+	local = rtt_iid(out ? &ip->ip6_src : &ip->ip6_dst);
+	remote = rtt_iid(out ? &ip->ip6_dst : &ip->ip6_src);
+
+	h = rtt_mix(remote ^ pkt->proto);
+	h = rtt_mix(h ^ local);
+	h = rtt_mix(h ^ ((u_int64_t)lport << 48 | (u_int64_t)rport << 32 | seq));
+	return h ? h : 1;
+}
+
+/**
+ *  @brief Stats of the prefix pfx/len
+ *  @param create Add them if the prefix is new
+ *  @return The stats, NULL if there are none (or out of memory)
+ */
+static sixone_rtt_stat stat_get(sixone_rtt rtt, sixone_ip pfx, int create)
+{
+	sixone_rtt_stat stat;
+
+	stat = lpm_exact(rtt->stats, &pfx->ip, pfx->pfx);
+	if(NULL != stat || !create)
+		return stat;
+
+	if(NULL == (stat = (sixone_rtt_stat) calloc(1, sizeof(struct sixone_rtt_stat_))))
+		return NULL;
+	stat->pfx = *pfx;
+	lpm_mask(&stat->pfx.ip, pfx->pfx);
+	lpm_insert(rtt->stats, &stat->pfx.ip, stat->pfx.pfx, stat);
+	stat->next = rtt->stat_l;
+	rtt->stat_l = stat;
+	return stat;
+}
+
+/**
+ *  @brief Whether new flows may go to the prefix, lifts the hold-down once it has passed
+ */
+static int stat_healthy(sixone_rtt_stat stat, u_int64_t now)
+{
+	if(stat->timeouts < RTT_MAX_TIMEOUTS)
+		return 1;
+	if(now < stat->down_us + RTT_HOLDDOWN_US)
+		return 0;
+	// one more chance, the next lost probe takes it down again
+	stat->timeouts = RTT_MAX_TIMEOUTS - 1;
+	return 1;
+}
+
+/**
+ *  @brief Accounts a probe that got no answer
+ */
+static void stat_lost(sixone_rtt_stat stat, u_int64_t now)
+{
+	if(++stat->timeouts == RTT_MAX_TIMEOUTS)
+		stat->down_us = now;
+}
+
+/**
+ *  @brief Feeds a sample to the estimator, RFC 6298 gains
+ */
+static void stat_sample(sixone_rtt_stat stat, u_int32_t r)
+{
+	u_int32_t delta;
+
+	if(0 == stat->samples) {
+		stat->srtt_us = r;
+		stat->rttvar_us = r / 2;
+	}
+	else {
+		delta = stat->srtt_us > r ? stat->srtt_us - r : r - stat->srtt_us;
+		stat->rttvar_us = (3 * (u_int64_t)stat->rttvar_us + delta) / 4;
+		stat->srtt_us = (7 * (u_int64_t)stat->srtt_us + r) / 8;
+	}
+	stat->samples++;
+	stat->timeouts = 0;
+}
+
+/**
+ *  @brief Hash of pfx/len, the bits past len don't matter
+ */
+static u_int64_t prefix_hash(sixone_ip pfx)
+{
+	struct in6_addr addr = pfx->ip;
+	u_int64_t w[2];
+
+	lpm_mask(&addr, pfx->pfx);
+	memcpy(w, &addr, sizeof(w));
+	return rtt_mix(rtt_mix(w[0] ^ pfx->pfx) ^ w[1]);
+}
+
+static int same_prefix(sixone_ip a, sixone_ip b)
+{
+	struct in6_addr x = a->ip, y = b->ip;
+
+	if(a->pfx != b->pfx)
+		return 0;
+	lpm_mask(&x, a->pfx);
+	lpm_mask(&y, b->pfx);
+	return 0 == memcmp(&x, &y, sizeof(x));
+}
+
+sixone_rtt alloc_sixone_rtt()
+{
+	sixone_rtt rtt;
+
+	rtt = (sixone_rtt) calloc(1, sizeof(struct sixone_rtt_));
+	if(NULL == rtt)
+		return NULL;
+	if(NULL == (rtt->stats = alloc_sixone_lpm())) {
+		free(rtt);
+		return NULL;
+	}
+	pthread_mutex_init(&rtt->lock, NULL);
+	return rtt;
+}
+
+void free_sixone_rtt(sixone_rtt rtt)
+{
+	sixone_rtt_stat stat, next;
+
+	if(NULL == rtt)
+		return;
+	free_sixone_lpm(rtt->stats, NULL);
+	for(stat = rtt->stat_l; stat != NULL; stat = next) {
+		next = stat->next;
+		free(stat);
+	}
+	pthread_mutex_destroy(&rtt->lock);
+	free(rtt);
+}
+
+void rtt_outbound(sixone_rtt rtt, sixone_pkt pkt, sixone_ip pfx)
+{
+	struct rtt_probe *p;
+	u_int64_t key, now = pkt->ts_us;
+	u_int i;
+
+	if(0 == (key = probe_key(pkt, 1)))
+		return;
+
+	pthread_mutex_lock(&rtt->lock);
+	__atomic_store_n(&rtt->now_us, now, __ATOMIC_RELAXED);
+
+	// answers only come for probes in their slot, so expire a few others as we go
+	for(i = 0; i < RTT_SWEEP; i++) {
+		p = &rtt->probe[rtt->sweep++ % RTT_PROBES];
+		if(0 != p->key && now >= p->ts_us + RTT_TIMEOUT_US) {
+			stat_lost(p->stat, now);
+			p->key = 0;
+		}
+	}
+
+	p = &rtt->probe[key % RTT_PROBES];
+	if(0 != p->key && p->key != key && now >= p->ts_us + RTT_TIMEOUT_US)
+		stat_lost(p->stat, now);
+	if(NULL != (p->stat = stat_get(rtt, pfx, 1))) {
+		p->key = key;
+		p->ts_us = now;
+	}
+	else
+		p->key = 0;
+
+	pthread_mutex_unlock(&rtt->lock);
+}
+
+void rtt_inbound(sixone_rtt rtt, sixone_pkt pkt)
+{
+	struct rtt_probe *p;
+	sixone_rtt_stat stat;
+	u_int64_t key, now = pkt->ts_us;
+
+	if(0 == (key = probe_key(pkt, 0)))
+		return;
+
+	pthread_mutex_lock(&rtt->lock);
+	__atomic_store_n(&rtt->now_us, now, __ATOMIC_RELAXED);
+
+	p = &rtt->probe[key % RTT_PROBES];
+	if(p->key == key) {
+		// the round trip is the path of the answer as much as of the probe,
+		// credit the prefix it came from, the one the site answers on
+		if(NULL == (stat = lpm_lookup(rtt->stats, &PKT_IP6(pkt)->ip6_src, NULL)))
+			stat = p->stat;
+		if(now >= p->ts_us && now < p->ts_us + RTT_TIMEOUT_US)
+			stat_sample(stat, now - p->ts_us);
+		p->key = 0;
+	}
+
+	pthread_mutex_unlock(&rtt->lock);
+}
+
+sixone_ip policy_pick_rtt(ip_list list, u_int32_t flow)
+{
+	sixone_rtt rtt = global_rtt;
+	struct rtt_flow *f;
+	struct rtt_site *site;
+	sixone_rtt_stat stat, best = NULL, cur = NULL;
+	sixone_ip pick = NULL;
+	ip_list l;
+	u_int64_t key = 0, now;
+	u_int n = 0, i, unmeasured = 0;
+
+	if(NULL == list)
+		return NULL;
+	if(NULL == list->next || NULL == rtt)
+		return policy_pick_weighted(list, flow);
+
+	for(l = list; l != NULL; l = l->next)
+		n++;
+	{
+		struct ip_list_ healthy[n];
+		sixone_rtt_stat healthy_stat[n];
+
+		pthread_mutex_lock(&rtt->lock);
+		now = __atomic_load_n(&rtt->now_us, __ATOMIC_RELAXED);
+
+		// a flow keeps its prefix as long as that stays healthy
+		f = &rtt->flow[flow % RTT_FLOWS];
+		if(0 != f->pfx.pfx && f->flow == flow && now < f->ts_us + RTT_FLOW_IDLE_US) {
+			for(l = list; l != NULL; l = l->next) {
+				if(same_prefix(l->ip, &f->pfx)) {
+					if(NULL != (stat = stat_get(rtt, l->ip, 0)) && stat_healthy(stat, now)) {
+						f->ts_us = now;
+						pthread_mutex_unlock(&rtt->lock);
+						return l->ip;
+					}
+					break;
+				}
+			}
+		}
+
+		// a new flow, see what the candidates look like
+		n = 0;
+		for(l = list; l != NULL; l = l->next) {
+			// the site is known by its set of prefixes
+			key ^= prefix_hash(l->ip);
+			if(NULL == (stat = stat_get(rtt, l->ip, 1)) || !stat_healthy(stat, now))
+				continue;
+			healthy[n] = *l;
+			healthy[n].next = NULL;
+			if(n > 0)
+				healthy[n - 1].next = &healthy[n];
+			healthy_stat[n++] = stat;
+			if(0 == stat->samples)
+				unmeasured = 1;
+			else if(NULL == best || stat->srtt_us < best->srtt_us)
+				best = stat;
+		}
+
+		if(0 == key)
+			key = 1;
+
+		if(0 == n) {
+			// all down, nothing to go by
+			pick = policy_pick_weighted(list, flow);
+		}
+		else if(unmeasured || 0 == rtt_mix(flow) % RTT_EXPLORE) {
+			pick = policy_pick_weighted(healthy, flow);
+			if(!unmeasured)
+				rtt->explored++;
+		}
+		else {
+			site = &rtt->site[key % RTT_SITES];
+			if(site->key == key)
+				for(i = 0; i < n; i++)
+					if(same_prefix(healthy[i].ip, &site->pfx))
+						cur = healthy_stat[i];
+			// hysteresis, only move for a clear gain
+			if(NULL == cur || (u_int64_t)best->srtt_us * 100 < (u_int64_t)cur->srtt_us * (100 - RTT_HYSTERESIS_PCT))
+				cur = best;
+			site->key = key;
+			site->pfx = cur->pfx;
+			for(i = 0; i < n && NULL == pick; i++)
+				if(healthy_stat[i] == cur)
+					pick = healthy[i].ip;
+		}
+
+		if(NULL != pick) {
+			f->flow = flow;
+			f->ts_us = now;
+			f->pfx = *pick;
+			if(NULL != (stat = stat_get(rtt, pick, 0)))
+				stat->flows++;
+		}
+		pthread_mutex_unlock(&rtt->lock);
+	}
+	return pick;
+}
+
+void rtt_report(sixone_rtt rtt)
+{
+	sixone_rtt_stat stat;
+	char str[INET6_ADDRSTRLEN];
+
+	pthread_mutex_lock(&rtt->lock);
+	printf("  rtt policy: %u new flows explored\n", rtt->explored);
+	for(stat = rtt->stat_l; stat != NULL; stat = stat->next) {
+		inet_ntop(AF_INET6, &stat->pfx.ip, str, sizeof(str));
+		if(stat->samples)
+			printf("    %s/%d srtt %.1f ms rttvar %.1f ms, %u samples, %u flows%s\n", str, stat->pfx.pfx,
+			       stat->srtt_us / 1000.0, stat->rttvar_us / 1000.0, stat->samples, stat->flows,
+			       stat->timeouts >= RTT_MAX_TIMEOUTS ? " (down)" : "");
+		else
+			printf("    %s/%d unmeasured, %u flows%s\n", str, stat->pfx.pfx, stat->flows,
+			       stat->timeouts >= RTT_MAX_TIMEOUTS ? " (down)" : "");
+	}
+	pthread_mutex_unlock(&rtt->lock);
+}
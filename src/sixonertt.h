@@ -0,0 +1,163 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonertt.h
+ *  @brief Six-One Router passive RTT measurement and latency aware transit selection
+ *  @date 2026-10-19
+ */
+
+#ifndef SIXONERTT_H
+#define SIXONERTT_H
+
+#include <pthread.h>
+
+#include "sixonetypes.h"
+#include "sixonelpm.h"
+#include "sixonepkt.h"
+
+/// @brief Outstanding handshakes/echoes tracked at once
+#define RTT_PROBES 4096
+/// @brief Flows remembered for sticking to their prefix
+#define RTT_FLOWS 16384
+/// @brief Remote sites remembered for hysteresis
+#define RTT_SITES 1024
+/// @brief A probe without an answer after this long counts as lost (us)
+#define RTT_TIMEOUT_US 3000000ULL
+/// @brief A prefix is unhealthy after this many lost probes in a row
+#define RTT_MAX_TIMEOUTS 3
+/// @brief An unhealthy prefix gets new flows again after this long (us)
+#define RTT_HOLDDOWN_US 10000000ULL
+/// @brief A flow idle this long is new again (us)
+#define RTT_FLOW_IDLE_US 60000000ULL
+/// @brief A site only moves to a prefix at least this much faster (percent)
+#define RTT_HYSTERESIS_PCT 20
+/// @brief One in this many new flows is spread over all healthy prefixes to keep their estimates fresh
+#define RTT_EXPLORE 32
+
+/**
+ * @brief What is known about one remote transit prefix
+ */
+typedef struct sixone_rtt_stat_ {
+	struct sixone_ip_ pfx;
+	u_int32_t srtt_us;    /// smoothed RTT (RFC 6298), 0 until the first sample
+	u_int32_t rttvar_us;  /// RTT variation
+	u_int samples;        /// samples taken
+	u_int timeouts;       /// probes lost since the last sample
+	u_int64_t down_us;    /// when it went unhealthy
+	u_int flows;          /// new flows steered to it
+	struct sixone_rtt_stat_ *next;
+} *sixone_rtt_stat;
+
+/// @brief An outstanding TCP SYN or ICMPv6 echo request
+struct rtt_probe {
+	u_int64_t key;        /// what the answer hashes to, 0 = free
+	u_int64_t ts_us;
+	sixone_rtt_stat stat; /// prefix the request went to
+};
+
+/// @brief A flow and the prefix it was steered to
+struct rtt_flow {
+	u_int32_t flow;
+	u_int64_t ts_us;      /// last packet
+	struct sixone_ip_ pfx;  /// pfx.pfx 0 = free
+};
+
+/// @brief The prefix a remote site currently prefers
+struct rtt_site {
+	u_int64_t key;        /// hash of the candidate prefixes, 0 = free
+	struct sixone_ip_ pfx;
+};
+
+/**
+ * @brief Passive RTT estimates and the state of the rtt policy
+ *
+ * Outbound TCP SYNs and ICMPv6 echo requests are remembered, the SYN-ACK or
+ * echo reply coming back gives a sample for the transit prefix it came from.
+ * Time is packet time (sixone_pkt ts_us), so replays are deterministic.
+ */
+typedef struct sixone_rtt_ {
+	sixone_lpm stats;                   /// remote transit prefix -> sixone_rtt_stat
+	sixone_rtt_stat stat_l;             /// the same stats as a list
+	struct rtt_probe probe[RTT_PROBES];
+	struct rtt_flow flow[RTT_FLOWS];
+	struct rtt_site site[RTT_SITES];
+	u_int64_t now_us;                   /// time of the latest packet
+	u_int explored;                     /// new flows spread for exploration
+	u_int sweep;                        /// next probe slot to check for timeouts
+	pthread_mutex_t lock;
+} *sixone_rtt;
+
+/// @brief The RTT state, NULL when the rtt policy is not in use
+extern sixone_rtt global_rtt;
+
+/**
+ *  @brief Allocates empty RTT state
+ */
+sixone_rtt alloc_sixone_rtt();
+
+/**
+ *  @brief Frees the RTT state
+ */
+void free_sixone_rtt(sixone_rtt rtt);
+
+/**
+ *  @brief Takes note of a rewritten outbound bilateral packet
+ *
+ *  TCP SYNs and ICMPv6 echo requests are remembered until answered.
+ *  @param pkt The packet, after rewriting
+ *  @param pfx The transit prefix the packet was sent to
+ */
+void rtt_outbound(sixone_rtt rtt, sixone_pkt pkt, sixone_ip pfx);
+
+/**
+ *  @brief Takes a sample from an inbound bilateral packet answering a probe
+ *  @param pkt The packet, before rewriting
+ */
+void rtt_inbound(sixone_rtt rtt, sixone_pkt pkt);
+
+/**
+ *  @brief Latency aware pick of a transit prefix.
+ *
+ *  Flows stay on the prefix they were given. New flows go to the prefix
+ *  the remote site prefers, the one with the lowest smoothed RTT; the site
+ *  only moves on when another prefix is RTT_HYSTERESIS_PCT faster or its
+ *  prefix goes unhealthy. As long as a healthy prefix has not been
+ *  measured, and for one in RTT_EXPLORE new flows, the pick is
+ *  policy_pick_weighted() over the healthy prefixes instead.
+ *  @param list The candidates
+ *  @param flow Flow hash of the packet (sixone_pkt hash)
+ *  @return The picked prefix, NULL if list is empty
+ */
+sixone_ip policy_pick_rtt(ip_list list, u_int32_t flow);
+
+/**
+ *  @brief Prints the estimate of every prefix seen
+ */
+void rtt_report(sixone_rtt rtt);
+
+#endif // SIXONERTT_H
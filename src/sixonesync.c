@@ -0,0 +1,83 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/** @file sixonesync.c
+ *  @brief Six-One Router replication end point without a router
+ *  @date 2026-10-19
+ *
+ *  Usage: sixonesync [-i seconds] [-n reports] primary <listen address> [mappings file]
+ *         sixonesync [-i seconds] [-n reports] follower <primary address>
+ *
+ *  Runs one end of the replication of sixonerepl.h and prints its report
+ *  every -i seconds, -n of them before exiting (0, the default, runs until
+ *  killed). Enough to run a primary and several followers as local
+ *  processes next to, or instead of, routers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sixonerepl.h"
+
+static void usage(char *name)
+{
+	printf("Usage: %s [-i seconds] [-n reports] primary <listen address> [mappings file]\n", name);
+	printf("       %s [-i seconds] [-n reports] follower <primary address>\n", name);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	char arg[512];
+	u_int interval = 1, reports = 0, i;
+	int ch;
+
+	while(-1 != (ch = getopt(argc, argv, "i:n:h"))) {
+		switch(ch) {
+		case 'i': interval = atoi(optarg); break;
+		case 'n': reports = atoi(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if(argc - optind < 2 || argc - optind > 3 || 0 == interval)
+		usage(argv[0]);
+
+	snprintf(arg, sizeof(arg), "%s %s", argv[optind + 1], argc - optind > 2 ? argv[optind + 2] : "");
+	if(NULL == (global_repl = alloc_sixone_repl(argv[optind], arg)))
+		return 1;
+
+	for(i = 0; 0 == reports || i < reports; i++) {
+		sleep(interval);
+		repl_report(global_repl);
+		fflush(stdout);
+	}
+	free_sixone_repl(global_repl);
+	return 0;
+}
@@ -0,0 +1,133 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonetimer.c
+ *  @brief Six-One Router per thread timer service
+ *  @date 2026-10-19
+ */
+
+#include "sixonetimer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/// @brief The cheapest monotonic clock there is, tick resolution is plenty
+#if defined(CLOCK_MONOTONIC_FAST)
+#define TIMERS_CLOCK CLOCK_MONOTONIC_FAST
+#elif defined(CLOCK_MONOTONIC_COARSE)
+#define TIMERS_CLOCK CLOCK_MONOTONIC_COARSE
+#else
+#define TIMERS_CLOCK CLOCK_MONOTONIC
+#endif
+
+int timers_replay;
+
+static __thread sixone_timers timers_local;
+
+sixone_timers timers_self()
+{
+	sixone_timers t = timers_local;
+
+	if(NULL != t)
+		return t;
+	if(NULL == (t = calloc(1, sizeof(struct sixone_timers_)))
+	   || NULL == (t->wheel = alloc_sixone_wheel(TIMER_TICK_US, 0))) {
+		printf("Could not malloc()\n");
+		exit(1);
+	}
+	// start where the clock is, the wheel would turn through all of it otherwise
+	if(!timers_replay)
+		t->now_us = timers_clock();
+	t->wheel->now = t->now_us / TIMER_TICK_US;
+	return timers_local = t;
+}
+
+u_int64_t timers_clock()
+{
+	struct timespec ts;
+
+	clock_gettime(TIMERS_CLOCK, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ *  @brief wheel_advance() callback, hands the timer to its subsystem
+ */
+static void timers_fire(wheel_timer w, void *arg)
+{
+	sixone_timer t = (sixone_timer)w;
+
+	((sixone_timers)arg)->fired++;
+	t->owner = NULL;
+	t->fn(t);
+}
+
+void timers_run(u_int64_t now_us)
+{
+	sixone_timers t = timers_self();
+
+	if(now_us < t->now_us)
+		return;
+	t->now_us = now_us;
+	if(now_us / TIMER_TICK_US > t->wheel->now)
+		wheel_advance(t->wheel, now_us, timers_fire, t);
+}
+
+void timers_burst()
+{
+	if(!timers_replay)
+		timers_run(timers_clock());
+}
+
+void timers_packet(u_int64_t ts_us)
+{
+	if(timers_replay)
+		timers_run(ts_us);
+}
+
+void timer_init(sixone_timer t, timer_fn fn)
+{
+	t->w.next = NULL;
+	t->w.pprev = NULL;
+	t->fn = fn;
+	t->owner = NULL;
+}
+
+void timer_arm(sixone_timer t, u_int64_t expires_us)
+{
+	t->owner = timers_self();
+	wheel_add(t->owner->wheel, &t->w, expires_us);
+}
+
+void timer_cancel(sixone_timer t)
+{
+	if(NULL == t->owner)
+		return;
+	wheel_del(t->owner->wheel, &t->w);
+	t->owner = NULL;
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonetimer.h
+ *  @brief Six-One Router per thread timer service
+ *  @date 2026-10-19
+ *
+ *  Every thread that runs the packet path (a capture thread, a worker,
+ *  the resolver reader releasing parked packets) owns a timer wheel
+ *  (sixonewheel.h), created the first time it arms a timer. A subsystem
+ *  embeds a struct sixone_timer_ in the state that expires and arms it
+ *  with its callback; the timer fires on the thread that armed it, so no
+ *  lock is taken and, with --workers, flow state is expired by the worker
+ *  that owns the flow. Only that thread may cancel the timer.
+ *
+ *  The clock is sampled once per burst: a capture thread after each
+ *  pcap_dispatch() (which returns at least once a second), a worker per
+ *  batch it takes from its queue. A replay runs on the packet timestamps
+ *  instead, so expiry is the same on every run.
+ */
+
+#ifndef SIXONETIMER_H
+#define SIXONETIMER_H
+
+#include <sys/types.h>
+
+#include "sixonewheel.h"
+
+/// @brief Tick of the per thread wheels (us)
+#define TIMER_TICK_US 10000
+
+/**
+ * @brief A thread's timers
+ */
+typedef struct sixone_timers_ {
+	sixone_wheel wheel;
+	u_int64_t now_us;       /// the last clock sample
+	u_int fired;            /// timers expired
+} *sixone_timers;
+
+/**
+ * @brief A timer, embed it in the state it expires
+ */
+typedef struct sixone_timer_ *sixone_timer;
+
+/**
+ *  @brief Called on expiry, the timer is disarmed and may be armed again
+ */
+typedef void (*timer_fn)(sixone_timer t);
+
+struct sixone_timer_ {
+	struct wheel_timer_ w;
+	timer_fn fn;
+	sixone_timers owner;    /// the thread it is armed on
+};
+
+/// @brief Set by --replay, the clock is the packet timestamps
+extern int timers_replay;
+
+/**
+ *  @brief The calling thread's timers, created on first use
+ */
+sixone_timers timers_self();
+
+/**
+ *  @brief Samples the monotonic clock (us)
+ */
+u_int64_t timers_clock();
+
+/**
+ *  @brief Moves the calling thread's clock to now_us and runs its due timers
+ */
+void timers_run(u_int64_t now_us);
+
+/**
+ *  @brief Ends a burst: samples the clock and runs the due timers, nothing in a replay
+ */
+void timers_burst();
+
+/**
+ *  @brief Starts a packet in a replay: runs the timers due at its timestamp, nothing live
+ */
+void timers_packet(u_int64_t ts_us);
+
+/// @brief The calling thread's clock (us)
+#define timers_now() (timers_self()->now_us)
+
+/**
+ *  @brief Sets up a disarmed timer
+ */
+void timer_init(sixone_timer t, timer_fn fn);
+
+/**
+ *  @brief Arms t on the calling thread to fire at expires_us, t must not be armed
+ */
+void timer_arm(sixone_timer t, u_int64_t expires_us);
+
+/**
+ *  @brief Disarms t, from the thread it is armed on
+ */
+void timer_cancel(sixone_timer t);
+
+#endif // SIXONETIMER_H
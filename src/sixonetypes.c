@@ -37,17 +37,26 @@
 #include <netinet/in.h> // required by ip6.h
 #include <netinet/ip6.h>
 #include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
 
-/// @brief DBG enable/disable debug output (should be an #ifdef really)
+/// @brief DBG enable/disable debug output, build with -DDBG=0 to silence it
+#ifndef DBG
 #define DBG 1
+#endif
 /// @brief DBG_P macro for debug printouts
 #define DBG_P if(DBG) printf
 
+/// @brief Every array of a sixone_image starts on a cache line of this size
+#define SIXONE_IMAGE_ALIGN 64
+
 sixone_ip alloc_sixone_ip()
 {
 	return (sixone_ip) calloc( 1 , sizeof(struct sixone_ip_) );
@@ -108,6 +117,7 @@ void free_sixone_settings(sixone_settings var)
 		free_sixone_if( var->if_v[i] );
 	}
   
+	free_sixone_image(var->image);
 	free_sixone_policy(var->policy);
 	free_sixone_resolv(var->resolv);
 	free (var);
@@ -132,6 +142,250 @@ void free_sixone_net(sixone_net var)
 	return;
 }
 
+/**
+ *  @brief Reserves size bytes at *off and moves *off to the next cache line
+ *  @return The offset of the reserved bytes
+ */
+static size_t image_carve(size_t *off, size_t size)
+{
+	size_t at = *off;
+
+	*off = (at + size + SIXONE_IMAGE_ALIGN - 1) & ~(size_t)(SIXONE_IMAGE_ALIGN - 1);
+	return at;
+}
+
+/**
+ *  @brief Writes the netmask of a len bit prefix to mask
+ */
+static void image_mask(struct in6_addr *mask, u_int len)
+{
+	u_int i;
+
+	memset(mask, 0, sizeof(*mask));
+	for(i = 0; len >= 8; i++, len -= 8)
+		mask->s6_addr[i] = 0xff;
+	if(0 != len)
+		mask->s6_addr[i] = (0xff << (8 - len)) & 0xff;
+}
+
+/**
+ *  @brief Finds our address in a net: the first global address of the interface within it,
+ *  the prefix with the last bit set if the interface has none (not up yet, or a replay)
+ */
+static void image_self(struct in6_addr *self, const struct in6_addr *net, const struct in6_addr *mask,
+		       const u_char *if_name, struct ifaddrs *ifa)
+{
+	const struct in6_addr *a;
+	int i;
+
+	for(; NULL != ifa; ifa = ifa->ifa_next) {
+		if(NULL == ifa->ifa_addr || AF_INET6 != ifa->ifa_addr->sa_family)
+			continue;
+		if(NULL == if_name || 0 != strcmp(ifa->ifa_name, (const char *)if_name))
+			continue;
+		a = &((struct sockaddr_in6 *)ifa->ifa_addr)->sin6_addr;
+		for(i = 0; i < 16; i++)
+			if(0 != ((a->s6_addr[i] ^ net->s6_addr[i]) & mask->s6_addr[i]))
+				break;
+		if(16 == i) {
+			*self = *a;
+			return;
+		}
+	}
+	for(i = 0; i < 16; i++)
+		self->s6_addr[i] = net->s6_addr[i] & mask->s6_addr[i];
+	self->s6_addr[15] |= 1;
+}
+
+u_int if_mtu(const u_char *if_name)
+{
+	struct ifreq ifr;
+	int fd;
+	u_int mtu = SIXONE_MTU;
+
+	if(NULL == if_name || 0 > (fd = socket(AF_INET6, SOCK_DGRAM, 0)))
+		return mtu;
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, (const char *)if_name, sizeof(ifr.ifr_name) - 1);
+	if(0 == ioctl(fd, SIOCGIFMTU, &ifr) && 0 < ifr.ifr_mtu)
+		mtu = ifr.ifr_mtu;
+	close(fd);
+	return mtu;
+}
+
+sixone_image alloc_sixone_image(sixone_settings settings)
+{
+	struct ifaddrs *ifa = NULL;
+	struct sixone_image_ *img;
+	sixone_net net;
+	u_char *base;
+	size_t off = 0, o_ea, o_em, o_el, o_ec, o_ei, o_es, o_eu, o_ek, o_ta, o_tm, o_tl, o_tg, o_ti, o_ts, o_rv, o_te, o_et;
+	u_int i, j, e = 0, t = 0, r = 0, edge_c = 0, transit_c = 0, route_c = 0, routed, mtu, mss;
+
+	for(i = 0; i < settings->if_c; i++) {
+		routed = 0;
+		for(j = 0; j < settings->if_v[i]->net_c; j++) {
+			if(settings->if_v[i]->net_v[j]->edge)
+				edge_c++;
+			else if(0 == routed++)
+				route_c++;
+		}
+		transit_c += routed;
+	}
+
+	image_carve(&off, sizeof(struct sixone_image_));
+	o_ea = image_carve(&off, edge_c * sizeof(struct in6_addr));
+	o_em = image_carve(&off, edge_c * sizeof(struct in6_addr));
+	o_el = image_carve(&off, edge_c * sizeof(u_char));
+	o_ec = image_carve(&off, edge_c * sizeof(u_char));
+	o_ei = image_carve(&off, edge_c * sizeof(u_short));
+	o_es = image_carve(&off, edge_c * sizeof(struct in6_addr));
+	o_eu = image_carve(&off, edge_c * sizeof(u_int));
+	o_ek = image_carve(&off, edge_c * sizeof(u_short));
+	o_ta = image_carve(&off, transit_c * sizeof(struct in6_addr));
+	o_tm = image_carve(&off, transit_c * sizeof(struct in6_addr));
+	o_tl = image_carve(&off, transit_c * sizeof(u_char));
+	o_tg = image_carve(&off, transit_c * sizeof(struct in6_addr));
+	o_ti = image_carve(&off, transit_c * sizeof(u_short));
+	o_ts = image_carve(&off, transit_c * sizeof(struct in6_addr));
+	o_rv = image_carve(&off, route_c * sizeof(u_int));
+	o_te = image_carve(&off, transit_c * sizeof(struct sixone_rewrite_));
+	o_et = image_carve(&off, edge_c * sizeof(struct sixone_rewrite_));
+
+	if(0 != posix_memalign((void **)&base, SIXONE_IMAGE_ALIGN, off))
+		return NULL;
+	memset(base, 0, off);
+	img = (struct sixone_image_ *)base;
+	img->edge_c = edge_c;
+	img->transit_c = transit_c;
+	img->route_c = route_c;
+	img->edge_addr = (struct in6_addr *)(base + o_ea);
+	img->edge_mask = (struct in6_addr *)(base + o_em);
+	img->edge_len = base + o_el;
+	img->edge_cksum = base + o_ec;
+	img->edge_if = (u_short *)(base + o_ei);
+	img->edge_self = (struct in6_addr *)(base + o_es);
+	img->edge_mtu = (u_int *)(base + o_eu);
+	img->edge_mss = (u_short *)(base + o_ek);
+	img->transit_addr = (struct in6_addr *)(base + o_ta);
+	img->transit_mask = (struct in6_addr *)(base + o_tm);
+	img->transit_len = base + o_tl;
+	img->transit_gw = (struct in6_addr *)(base + o_tg);
+	img->transit_if = (u_short *)(base + o_ti);
+	img->transit_self = (struct in6_addr *)(base + o_ts);
+	img->route_v = (u_int *)(base + o_rv);
+	img->transit_edge = (struct sixone_rewrite_ *)(base + o_te);
+	img->edge_transit = (struct sixone_rewrite_ *)(base + o_et);
+
+	// no addresses is not an error, image_self() falls back on the prefixes
+	if(0 != getifaddrs(&ifa))
+		ifa = NULL;
+
+	for(i = 0; i < settings->if_c; i++) {
+		routed = 0;
+		mtu = 0 != settings->if_v[i]->mtu ? settings->if_v[i]->mtu : SIXONE_MTU;
+		// what MSS= asked for, but never more than the interface fits
+		mss = settings->if_v[i]->mss;
+		if(0 != mss && mss > mtu - SIXONE_MSS_HDRS)
+			mss = mtu - SIXONE_MSS_HDRS;
+		if(0 != mss)
+			img->mss_c++;
+		for(j = 0; j < settings->if_v[i]->net_c; j++) {
+			net = settings->if_v[i]->net_v[j];
+			if(net->edge) {
+				img->edge_addr[e] = net->addr->ip;
+				img->edge_len[e] = net->addr->pfx < 0 ? 0 : net->addr->pfx > 128 ? 128 : net->addr->pfx;
+				image_mask(&img->edge_mask[e], img->edge_len[e]);
+				img->edge_cksum[e] = net->cksum_mode;
+				img->edge_if[e] = i;
+				image_self(&img->edge_self[e], &img->edge_addr[e], &img->edge_mask[e], settings->if_v[i]->if_name, ifa);
+				img->edge_mtu[e] = mtu;
+				if(0 == img->edge_mtu_min || mtu < img->edge_mtu_min)
+					img->edge_mtu_min = mtu;
+				img->edge_mss[e] = mss;
+				if(0 != mss && (0 == img->edge_mss_min || mss < img->edge_mss_min))
+					img->edge_mss_min = mss;
+				e++;
+				continue;
+			}
+			img->transit_addr[t] = net->addr->ip;
+			img->transit_len[t] = net->addr->pfx < 0 ? 0 : net->addr->pfx > 128 ? 128 : net->addr->pfx;
+			image_mask(&img->transit_mask[t], img->transit_len[t]);
+			if(NULL != net->gw)
+				img->transit_gw[t] = *net->gw;
+			img->transit_if[t] = i;
+			image_self(&img->transit_self[t], &img->transit_addr[t], &img->transit_mask[t], settings->if_v[i]->if_name, ifa);
+			if(0 == img->transit_mtu_min || mtu < img->transit_mtu_min)
+				img->transit_mtu_min = mtu;
+			if(0 != mss && (0 == img->transit_mss || mss < img->transit_mss))
+				img->transit_mss = mss;
+			if(0 == routed++)
+				img->route_v[r++] = t;
+			t++;
+		}
+	}
+
+	if(NULL != ifa)
+		freeifaddrs(ifa);
+	if(0 == img->edge_mtu_min)
+		img->edge_mtu_min = SIXONE_MTU;
+	if(0 == img->transit_mtu_min)
+		img->transit_mtu_min = SIXONE_MTU;
+
+	if(0 != edge_c) {
+		rewrite_bind(&img->edge, &img->edge_addr[edge_c - 1], img->edge_len[edge_c - 1]);
+		rewrite_bind(&img->legacy_edge, &img->edge_addr[edge_c - 1], 64);
+	}
+	if(0 != transit_c)
+		rewrite_bind(&img->transit, &img->transit_addr[transit_c - 1], img->transit_len[transit_c - 1]);
+
+	// the nets pair up by index counted from the last ones, the last transit net goes
+	// back to the last edge net as it does for inbound(), surplus nets share the first
+	for(t = 0; 0 != edge_c && t < transit_c; t++) {
+		e = t + edge_c >= transit_c ? t + edge_c - transit_c : 0;
+		rewrite_bind(&img->transit_edge[t], &img->edge_addr[e], img->edge_len[e]);
+	}
+	for(e = 0; 0 != transit_c && e < edge_c; e++) {
+		t = e + transit_c >= edge_c ? e + transit_c - edge_c : 0;
+		rewrite_bind(&img->edge_transit[e], &img->transit_addr[t], img->transit_len[t]);
+	}
+	return img;
+}
+
+void free_sixone_image(sixone_image var)
+{
+	free(var);
+}
+
+/**
+ *  @brief Finds the first of the n prefixes addr is within, two 64 bit compares each
+ */
+static int image_find(u_int n, const struct in6_addr *net, const struct in6_addr *mask, const struct in6_addr *addr)
+{
+	u_int64_t a[2], p[2], m[2];
+	u_int i;
+
+	// packet addresses are only 16 bit aligned
+	memcpy(a, addr, sizeof(a));
+	for(i = 0; i < n; i++) {
+		memcpy(p, &net[i], sizeof(p));
+		memcpy(m, &mask[i], sizeof(m));
+		if(0 == (((a[0] ^ p[0]) & m[0]) | ((a[1] ^ p[1]) & m[1])))
+			return i;
+	}
+	return -1;
+}
+
+int image_find_edge(sixone_image image, const struct in6_addr *addr)
+{
+	return image_find(image->edge_c, image->edge_addr, image->edge_mask, addr);
+}
+
+int image_find_transit(sixone_image image, const struct in6_addr *addr)
+{
+	return image_find(image->transit_c, image->transit_addr, image->transit_mask, addr);
+}
+
 void print_settings(sixone_settings settings)
 {
 	int i;
@@ -183,7 +437,8 @@ void print_net(sixone_net net)
 	if(net->edge) {
 		inet_ntop(AF_INET6, &net->addr->ip, ip, sizeof(ip));
 		printf("\t\t[Edge]");
-		printf("net: %s/%u\n", ip, net->addr->pfx);
+		printf("net: %s/%u (%s checksums)\n", ip, net->addr->pfx,
+		       SIXONE_CKSUM_INCREMENTAL == net->cksum_mode ? "incremental" : "neutral");
 	}
 	else {
 		inet_ntop(AF_INET6, &net->addr->ip, ip, sizeof(ip));
@@ -196,6 +451,29 @@ void print_net(sixone_net net)
 	return;
 }
 
+/**
+ *  @brief Splits a "Key= <path> [argument]" line
+ *  @param path Set to a copy of the path
+ *  @param arg Set to a copy of the rest of the line, "" if there is nothing
+ */
+static void load_path_arg(u_char *line, u_char **path, u_char **arg)
+{
+	u_char _path[256];
+	u_char *_str;
+
+	_str = (u_char *)strchr((char *)line, '=');
+	if(NULL == _str || 1 != sscanf((const char *)_str + 1, "%255s", _path)) {
+		printf("%.*s needs a path\n", (int)strcspn((char *)line, "=\r\n"), line);
+		exit(1);
+	}
+	_str = (u_char *)strstr((char *)_str, (char *)_path) + strlen((char *)_path);
+	while( isspace(*_str) )
+		++_str;
+	_str[strcspn((char *)_str, "\r\n")] = 0;
+	*path = (u_char *)strdup((char *)_path);
+	*arg = (u_char *)strdup((char *)_str);
+}
+
 u_int load_settings(u_char* file, sixone_settings settings)
 {
 	FILE* _fh;
@@ -252,6 +530,31 @@ u_int load_settings(u_char* file, sixone_settings settings)
 			
 			//print_settings(settings);
 		}
+		else if(0 == strncasecmp((const char *)_str, "plugin", 6)) {
+			load_path_arg(_str, &settings->plugin, &settings->plugin_arg);
+		}
+		else if(0 == strncasecmp((const char *)_str, "resolver", 8)) {
+			load_path_arg(_str, &settings->resolver, &settings->resolver_arg);
+		}
+		else if(0 == strncasecmp((const char *)_str, "replicate", 9)) {
+			// the role takes the place of the path
+			load_path_arg(_str, &settings->replicate, &settings->replicate_arg);
+		}
+		else if(0 == strncasecmp((const char *)_str, "mss", 3)) {
+			// MSS= clamp (to the MTU) or MSS= <n>, for the interface above
+			if(0 == settings->if_c || NULL == (_str = (u_char *)strchr(_str, '='))) {
+				printf("MSS= outside of an [interface] section\n");
+				exit(1);
+			}
+			_if = settings->if_v[settings->if_c - 1];
+			++_str;
+			while( isspace(*_str) )
+				++_str;
+			if(0 == strncasecmp((const char *)_str, "clamp", 5))
+				_if->mss = 0xFFFF;
+			else
+				_if->mss = strtoul((const char *)_str, NULL, 10);
+		}
 		else if('E' == toupper(*_str) || 'T' == toupper(*_str) ) {
 			//DBG_P("%s:%d net\n", __FILE__, __LINE__);
 			_if_c = settings->if_c;
@@ -279,7 +582,11 @@ u_int load_settings(u_char* file, sixone_settings settings)
 			// is it an edge net?
 			if(_net->edge) { 
 
-				sscanf((const char *)_str, "%s %d\n", _ip, &_net->addr->pfx);
+				if(3 == sscanf((const char *)_str, "%s %d %s", _ip, &_net->addr->pfx, _gw)
+				   && 0 == strcasecmp((const char *)_gw, "incremental"))
+					_net->cksum_mode = SIXONE_CKSUM_INCREMENTAL;
+				else
+					_net->cksum_mode = SIXONE_CKSUM_NEUTRAL;
 				inet_pton(AF_INET6, (char const *)_ip, &_net->addr->ip);
 				_net->gw = NULL;
 				//DBG_P("%s:%d net : edge (%s)/(%d)\n", __FILE__, __LINE__, _ip, _net->addr->pfx);
@@ -302,6 +609,14 @@ u_int load_settings(u_char* file, sixone_settings settings)
   	fclose(_fh);
 	//DBG_P("%s:%d : load_config() fclose & return (void) \n", __FILE__, __LINE__);
 
+	for(_if_c = 0; _if_c < settings->if_c; _if_c++)
+		settings->if_v[_if_c]->mtu = if_mtu(settings->if_v[_if_c]->if_name);
+
+	if( NULL == (settings->image = alloc_sixone_image(settings)) ) {
+		printf("Could not malloc()\n");
+		exit(1);
+	}
+
 	//persistent storage
  
 	return 0;
@@ -38,6 +38,8 @@
 #include <netinet/in.h> // required by ip6.h
 #include <netinet/ip6.h>
 
+#include "sixonerewrite.h"
+
 typedef struct sixone_settings_ *sixone_settings;
 
 /// @brief Sixone ip's usually need to know the prefixlength
@@ -59,6 +61,7 @@ typedef struct sixone_ip_pair_ {
 typedef struct ip_list_ *ip_list; // mention the type for the next pointer
 struct ip_list_ {
 	sixone_ip ip;
+	u_int weight; /// Relative share of the flows for multipath policies, 0 = SIXONE_WEIGHT_DEFAULT
 	ip_list next; /// The next ip in the list, NULL = end of list;
 };
 
@@ -67,8 +70,9 @@ struct ip_list_ {
  * policy functions.
  */
 typedef struct sixone_policy_ {
-	sixone_ip (*sixone_policy_dst)(ip_list list);
-	sixone_ip (*sixone_policy_src)(ip_list list);
+	/// pick one of list for the packet of the flow with hash flow (sixone_pkt hash)
+	sixone_ip (*sixone_policy_dst)(ip_list list, u_int32_t flow);
+	sixone_ip (*sixone_policy_src)(ip_list list, u_int32_t flow);
 } *sixone_policy;
 
 /**
@@ -84,6 +88,12 @@ typedef struct sixone_resolv_ {
 	 */
 	ip_list (*sixone_resolv)(sixone_ip ip, u_int only_sixone);
 
+	/**
+	 * @brief get the mappings for n addresses at once, see retrieve_mappings_batch()
+	 *  @return 0 on success, -1 if nothing could be resolved
+	 */
+	int (*sixone_resolv_batch)(u_int n, sixone_ip ip[], u_int only_sixone, ip_list out[]);
+
 	/** 
 	 * @brief resolve destination
 	 *  @arg ip An edge ip
@@ -98,12 +108,23 @@ typedef struct sixone_resolv_ {
 	//ip_list (*sixone_resolv_src)(struct in6_addr ip);
 } *sixone_resolv;
 
+/// @brief Legacy rewrites keep checksums valid by compensating in the 7th/8th byte of the address (cksumNeutralIp())
+#define SIXONE_CKSUM_NEUTRAL 0
+/// @brief Legacy rewrites leave the address alone and update the transport checksum (RFC 1624)
+#define SIXONE_CKSUM_INCREMENTAL 1
+
+/// @brief MTU of an interface the system does not know (a replay)
+#define SIXONE_MTU 1500
+/// @brief What the IPv6 and TCP headers take of the MTU, the rest is the MSS a SYN may announce
+#define SIXONE_MSS_HDRS (40 + 20)
+
 /**
  * @brief struct storing network and prefix length
  */
 typedef struct sixone_net_ {
 	sixone_ip addr;
 	short int edge;
+	short int cksum_mode; /// SIXONE_CKSUM_*, only used for edge nets
 	struct in6_addr *gw;
 } *sixone_net;
 
@@ -114,18 +135,69 @@ typedef struct sixone_if_ {
 	u_int net_c;
 	u_char* if_name;
 	sixone_net *net_v;
+	u_int mtu;      /// read from the system by load_settings()
+	u_int mss;      /// MSS= of the section, 0 leaves SYNs alone, else the largest MSS they leave with
   
 } *sixone_if;
 
+/**
+ * @brief The nets of the settings as the packet path reads them
+ *
+ * load_settings() builds the image once the file is read, the sixone_if and
+ * sixone_net structs above stay as the view the image is built from. Every
+ * kind of net is a set of parallel arrays in configuration order (edge_addr[i],
+ * edge_mask[i], edge_len[i], ... describe the i:th edge net), each array starts
+ * on its own cache line and the whole image is one allocation that is not
+ * written after alloc_sixone_image().
+ */
+typedef struct sixone_image_ *sixone_image;
+struct sixone_image_ {
+	u_int edge_c;
+	u_int transit_c;
+	struct in6_addr *edge_addr;     /// edge prefixes as configured
+	struct in6_addr *edge_mask;     /// netmask of each edge prefix
+	u_char *edge_len;               /// prefix lengths
+	u_char *edge_cksum;             /// SIXONE_CKSUM_* of each edge net
+	u_short *edge_if;               /// index in if_v of the interface of each edge net
+	struct in6_addr *edge_self;     /// our address in each edge net (ICMPv6 errors are sent from it)
+	u_int *edge_mtu;                /// MTU of the interface of each edge net
+	u_short *edge_mss;              /// the largest MSS a SYN leaves each edge net with, 0 to leave it alone
+	struct in6_addr *transit_addr;  /// transit prefixes as configured
+	struct in6_addr *transit_mask;
+	u_char *transit_len;
+	struct in6_addr *transit_gw;    /// next hop of each transit net
+	u_short *transit_if;
+	struct in6_addr *transit_self;  /// our address in each transit net
+	u_int edge_mtu_min;             /// the smallest edge MTU, where a packet to a transit address may end up
+	u_int transit_mtu_min;          /// the smallest transit MTU, where an outbound packet may leave
+	u_short edge_mss_min;           /// the smallest edge_mss that is not 0, for a SYN to a transit address
+	u_short transit_mss;            /// the smallest MSS of the clamping transit interfaces, 0 if none clamps
+	u_int mss_c;                    /// interfaces that clamp the MSS, 0 lets every packet skip the check
+	u_int route_c;
+	u_int *route_v;                 /// transit nets outbound() routes through, the first one of each interface
+	struct sixone_rewrite_ edge;         /// bilateral inbound packets are rewritten to the last edge net
+	struct sixone_rewrite_ legacy_edge;  /// the same prefix as /64, for legacy inbound packets
+	struct sixone_rewrite_ transit;      /// outbound packets are rewritten to the last transit net
+	struct sixone_rewrite_ *transit_edge; /// per transit net, the edge net hairpin() takes its addresses back to
+	struct sixone_rewrite_ *edge_transit; /// per edge net, the transit net hairpin() gives its sources
+};
+
 /**
  * @brief Struct keeping routers interfaces settings
  */
 struct sixone_settings_ {
 	u_int if_c;
 	sixone_if *if_v;
+	sixone_image image;  /// built from if_v by load_settings()
 	sixone_policy policy;
 	sixone_resolv resolv;
 	int out_fd;
+	u_char *plugin;      /// Plugin= shared object, NULL if none
+	u_char *plugin_arg;  /// the rest of the Plugin= line
+	u_char *resolver;    /// Resolver= daemon socket, NULL if none
+	u_char *resolver_arg;
+	u_char *replicate;   /// Replicate= role, NULL if none
+	u_char *replicate_arg;
 };
 
 
@@ -137,10 +209,10 @@ struct sixone_settings_ {
 sixone_ip alloc_sixone_ip();
 
 /**
- *  @brief Allocate a sixone_ip_list type
- *  @return The sixone_ip_list type allocated (zeroed)
+ *  @brief Allocate a ip_list type
+ *  @return The ip_list type allocated (zeroed)
  */
-ip_list alloc_sixone_ip_list();
+ip_list alloc_ip_list();
 
 /**
  *  @brief Allocate a sixone_policy type
@@ -172,6 +244,36 @@ sixone_net alloc_sixone_net();
  */
 sixone_if alloc_sixone_if();
 
+/**
+ *  @brief Builds the runtime image of the nets in settings
+ *  @return The image, NULL if it could not be allocated
+ */
+sixone_image alloc_sixone_image(sixone_settings settings);
+
+/**
+ *  @brief Free a sixone_image type
+ *  @param var The sixone_image type to free
+ */
+void free_sixone_image(sixone_image var);
+
+/**
+ *  @brief Reads the MTU of an interface from the system
+ *  @return The MTU, SIXONE_MTU if the system does not know the interface
+ */
+u_int if_mtu(const u_char *if_name);
+
+/**
+ *  @brief Finds the first edge net of the image addr is within
+ *  @return The index of the edge net, -1 if addr is in none of them
+ */
+int image_find_edge(sixone_image image, const struct in6_addr *addr);
+
+/**
+ *  @brief Finds the first transit net of the image addr is within
+ *  @return The index of the transit net, -1 if addr is in none of them
+ */
+int image_find_transit(sixone_image image, const struct in6_addr *addr);
+
 /**
  *  @brief Free a sixone_policy type
  *  @param var The sixone_policy type to free
@@ -237,10 +339,21 @@ void print_sixone_ip(sixone_ip addr);
  *  comes in form of "var=val"
  *  @param settings Struct to write settings to
  *  @code 
- *  edge_net=ABC::1
- *  edge_prefix=/64
- *  transit_net=2000::1/64
+ *  Plugin= /usr/local/lib/sixone/sixonemap.so mappings.txt
+ *  Resolver= /var/run/sixoneresolvd.sock timeout=1000 depth=16 drop=head
+ *  Replicate= follower primary.example.net:6160
+ *  [em0]
+ *  Edge= abc:: 64 [neutral|incremental]
+ *  [em1]
+ *  Transit= 1000:: 64 1000::fffe
  *  @endcode
+ *  The optional edge net checksum mode selects how legacy rewrites keep
+ *  transport checksums valid (SIXONE_CKSUM_*), neutral is the default.
+ *  The optional Plugin= line names a resolver/policy plugin (sixoneplugin.h)
+ *  and its argument, it is loaded by load_plugin(). Resolver= names the
+ *  socket of a resolver daemon and its options (alloc_sixone_async()),
+ *  Replicate= the replication role and its arguments (alloc_sixone_repl()).
+ *  Once the file is read the nets are compiled into settings->image.
  */
 u_int load_settings(u_char* file, sixone_settings settings);
 
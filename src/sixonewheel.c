@@ -0,0 +1,169 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonewheel.c
+ *  @brief Six-One Router hierarchical timer wheel
+ *  @date 2026-10-19
+ */
+
+#include "sixonewheel.h"
+
+#include <stdlib.h>
+
+sixone_wheel alloc_sixone_wheel(u_int64_t tick_us, u_int64_t now_us)
+{
+	sixone_wheel w = (sixone_wheel) calloc(1, sizeof(struct sixone_wheel_));
+
+	if(NULL == w)
+		return NULL;
+	w->tick_us = tick_us ? tick_us : 1;
+	w->now = now_us / w->tick_us;
+	return w;
+}
+
+void free_sixone_wheel(sixone_wheel w)
+{
+	free(w);
+}
+
+/**
+ *  @brief Links t into the slot of the lowest level its expiry fits in, seen from w->now
+ */
+static void wheel_place(sixone_wheel w, wheel_timer t)
+{
+	u_int64_t delta, at = t->expires;
+	wheel_timer *slot;
+	int l;
+
+	if(at < w->now)
+		at = w->now;
+	delta = at - w->now;
+	for(l = 0; l < WHEEL_LEVELS - 1; l++)
+		if(delta < (u_int64_t)1 << (WHEEL_BITS * (l + 1)))
+			break;
+	// too far ahead for the top level, park it at its far end until it turns
+	if(delta >= (u_int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+		at = w->now + ((u_int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+	slot = &w->slot[l][(at >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1)];
+	if(NULL != (t->next = *slot))
+		t->next->pprev = &t->next;
+	t->pprev = slot;
+	*slot = t;
+}
+
+void wheel_add(sixone_wheel w, wheel_timer t, u_int64_t expires_us)
+{
+	t->expires = expires_us / w->tick_us;
+	// the slot of the current tick has been expired already
+	if(t->expires <= w->now)
+		t->expires = w->now + 1;
+	wheel_place(w, t);
+	w->count++;
+}
+
+void wheel_del(sixone_wheel w, wheel_timer t)
+{
+	if(!wheel_armed(t))
+		return;
+	if(NULL != (*t->pprev = t->next))
+		t->next->pprev = t->pprev;
+	t->next = NULL;
+	t->pprev = NULL;
+	w->count--;
+}
+
+u_int wheel_advance(sixone_wheel w, u_int64_t now_us, wheel_fn fn, void *arg)
+{
+	u_int64_t target = now_us / w->tick_us;
+	wheel_timer t, next;
+	u_int expired = 0;
+	int l, i;
+
+	// further than the wheels reach, take everything out and put back what is not due
+	if(0 != w->count && target - w->now >= (u_int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) {
+		wheel_timer all = NULL;
+
+		for(l = 0; l < WHEEL_LEVELS; l++) {
+			for(i = 0; i < WHEEL_SLOTS; i++) {
+				for(t = w->slot[l][i]; NULL != t; t = next) {
+					next = t->next;
+					t->next = all;
+					all = t;
+				}
+				w->slot[l][i] = NULL;
+			}
+		}
+		w->now = target;
+		for(t = all; NULL != t; t = next) {
+			next = t->next;
+			if(t->expires > target) {
+				wheel_place(w, t);
+				continue;
+			}
+			t->next = NULL;
+			t->pprev = NULL;
+			w->count--;
+			expired++;
+			fn(t, arg);
+		}
+		return expired;
+	}
+
+	while(w->now < target) {
+		// nothing armed, nothing to turn
+		if(0 == w->count) {
+			w->now = target;
+			break;
+		}
+		w->now++;
+
+		// the wheels that turn on this tick hand their slot down, the top one first
+		for(l = WHEEL_LEVELS - 1; l > 0; l--) {
+			if(0 != (w->now & (((u_int64_t)1 << (WHEEL_BITS * l)) - 1)))
+				continue;
+			t = w->slot[l][(w->now >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1)];
+			w->slot[l][(w->now >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1)] = NULL;
+			for(; NULL != t; t = next) {
+				next = t->next;
+				wheel_place(w, t);
+			}
+		}
+
+		t = w->slot[0][w->now & (WHEEL_SLOTS - 1)];
+		w->slot[0][w->now & (WHEEL_SLOTS - 1)] = NULL;
+		for(; NULL != t; t = next) {
+			next = t->next;
+			t->next = NULL;
+			t->pprev = NULL;
+			w->count--;
+			expired++;
+			fn(t, arg);
+		}
+	}
+	return expired;
+}
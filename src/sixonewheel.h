@@ -0,0 +1,110 @@
+/* Copyright (c) 2026, the Six/One Router contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file sixonewheel.h
+ *  @brief Six-One Router hierarchical timer wheel
+ *  @date 2026-10-19
+ *
+ *  WHEEL_LEVELS wheels of WHEEL_SLOTS slots, a slot of level l spans
+ *  WHEEL_SLOTS^l ticks. A timer goes to the lowest level its expiry fits
+ *  in and moves down a level each time the wheel above turns, so adding,
+ *  cancelling and expiring a timer are O(1). Timers are embedded in the
+ *  state they expire, the wheel does not allocate. It is not locked, the
+ *  owner serializes the calls.
+ */
+
+#ifndef SIXONEWHEEL_H
+#define SIXONEWHEEL_H
+
+#include <sys/types.h>
+
+/// @brief log2 of the slots per level
+#define WHEEL_BITS 6
+/// @brief Slots per level
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+/// @brief Levels, WHEEL_SLOTS^WHEEL_LEVELS ticks ahead at most (later expiries wait at the top)
+#define WHEEL_LEVELS 4
+
+/**
+ * @brief A timer, embed it in the state it expires
+ */
+typedef struct wheel_timer_ *wheel_timer;
+struct wheel_timer_ {
+	wheel_timer next;
+	wheel_timer *pprev;     /// NULL while the timer is not armed
+	u_int64_t expires;      /// tick
+};
+
+/// @brief Is the timer armed?
+#define wheel_armed(t) (NULL != (t)->pprev)
+
+/**
+ *  @brief Called for an expired timer, which is disarmed and may be added again
+ */
+typedef void (*wheel_fn)(wheel_timer t, void *arg);
+
+/**
+ * @brief The wheel
+ */
+typedef struct sixone_wheel_ {
+	u_int64_t tick_us;      /// length of a tick
+	u_int64_t now;          /// the last tick expired
+	u_int count;            /// timers armed
+	wheel_timer slot[WHEEL_LEVELS][WHEEL_SLOTS];
+} *sixone_wheel;
+
+/**
+ *  @brief Allocates an empty wheel
+ *  @param tick_us Length of a tick (us)
+ *  @param now_us The current time (us), on the clock wheel_advance() will be given
+ *  @return The wheel, NULL if it could not be allocated
+ */
+sixone_wheel alloc_sixone_wheel(u_int64_t tick_us, u_int64_t now_us);
+
+/**
+ *  @brief Frees the wheel, the timers still armed are left as they are
+ */
+void free_sixone_wheel(sixone_wheel w);
+
+/**
+ *  @brief Arms t (which must not be armed) to expire at expires_us, at the earliest on the next tick
+ */
+void wheel_add(sixone_wheel w, wheel_timer t, u_int64_t expires_us);
+
+/**
+ *  @brief Disarms t, nothing happens if it is not armed
+ */
+void wheel_del(sixone_wheel w, wheel_timer t);
+
+/**
+ *  @brief Expires every timer due by now_us, in tick order (unordered after a jump beyond the top level)
+ *  @param fn Called for each expired timer
+ *  @return The number of timers expired
+ */
+u_int wheel_advance(sixone_wheel w, u_int64_t now_us, wheel_fn fn, void *arg);
+
+#endif // SIXONEWHEEL_H